@@ -0,0 +1,1293 @@
+/*
+ * bench.c - fileManager benchmarks
+ *
+ * Every scenario runs fileManager twice: once untimed under a small ptrace
+ * syscall counter (fork children included) and once timed without tracing.
+ * Results are printed one line per run as key=value pairs, or as one JSON
+ * object per line with -j. Synthetic trees and files are kept in the work
+ * directory ($TMPDIR/fileManagerBench unless -d says otherwise, never the
+ * source tree) and reused by later runs of the same shape.
+ *
+ * Usage: fileManagerBench [-n count] [-s bytes] [-w fanout] [-d workdir] [-f fileManager] [-j] [-l]
+ *                         [scenario...]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <dirent.h>
+
+#include "oplog.h"
+
+typedef struct {
+    unsigned long syscalls;
+    unsigned long writes;       // write, writev, pwrite*, sendfile, splice, copy_file_range
+    double seconds;
+    int status;
+} RunStats;
+
+static const char *file_manager = NULL;
+static unsigned long count = 1000000;
+static unsigned long file_bytes = 256UL << 20;
+static unsigned long fanout = 1000;     // entries per directory of nested trees
+static int json = 0;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int is_write_syscall(unsigned long nr) {
+    return nr == SYS_write || nr == SYS_writev || nr == SYS_pwrite64 || nr == SYS_pwritev ||
+           nr == SYS_sendfile || nr == SYS_splice || nr == SYS_copy_file_range;
+}
+
+// Child side: stdout to a file (or /dev/null), then exec under the tracer;
+// names without a slash are looked up on PATH
+static void exec_child(char *const argv[], const char *stdout_path, int traced) {
+    int fd = open(stdout_path ? stdout_path : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1) {
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+    if (traced) {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        raise(SIGSTOP);
+    }
+    execvp(argv[0], argv);
+    _exit(127);
+}
+
+// Run argv to completion, counting syscall entries of it and every child
+static int run_counted(char *const argv[], const char *stdout_path, RunStats *stats) {
+    pid_t root = fork();
+    if (root == -1) {
+        return -1;
+    }
+    if (root == 0) {
+        exec_child(argv, stdout_path, 1);
+    }
+
+    int status;
+    if (waitpid(root, &status, 0) == -1 || !WIFSTOPPED(status)) {
+        return -1;
+    }
+    ptrace(PTRACE_SETOPTIONS, root, NULL,
+           PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK |
+           PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL);
+    ptrace(PTRACE_SYSCALL, root, NULL, NULL);
+
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, __WALL)) > 0) {
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            if (pid == root) {
+                stats->status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+                break;  // Untraced children of ours (a daemon) may still run
+            }
+            continue;
+        }
+
+        int sig = WSTOPSIG(status);
+        int inject = 0;
+        if (sig == (SIGTRAP | 0x80)) {
+            struct __ptrace_syscall_info info;
+            if (ptrace(PTRACE_GET_SYSCALL_INFO, pid, sizeof(info), &info) > 0 &&
+                info.op == PTRACE_SYSCALL_INFO_ENTRY) {
+                stats->syscalls++;
+                if (is_write_syscall(info.entry.nr)) {
+                    stats->writes++;
+                }
+            }
+        } else if (sig != SIGTRAP && sig != SIGSTOP) {
+            inject = sig;  // A real signal for the tracee
+        }
+        ptrace(PTRACE_SYSCALL, pid, NULL, (void *)(long)inject);
+    }
+    return 0;
+}
+
+// Run argv to completion untraced and time it
+static int run_timed(char *const argv[], const char *stdout_path, RunStats *stats) {
+    double start = now_seconds();
+    pid_t pid = fork();
+    if (pid == -1) {
+        return -1;
+    }
+    if (pid == 0) {
+        exec_child(argv, stdout_path, 0);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    stats->seconds = now_seconds() - start;
+    return 0;
+}
+
+// Print one result line; extra is more key=value pairs
+static void bench_print(const char *scenario, const char *variant, unsigned long items,
+                        const RunStats *stats, const char *extra) {
+    const char *format = json ?
+        "{\"scenario\":\"%s\",\"variant\":\"%s\",\"items\":%lu,\"status\":%d,\"syscalls\":%lu,"
+        "\"writes\":%lu,\"syscalls_per_item\":%.3f,\"seconds\":%.6f,\"items_per_sec\":%.0f" :
+        "scenario=%s variant=%s items=%lu status=%d syscalls=%lu writes=%lu "
+        "syscalls_per_item=%.3f seconds=%.6f items_per_sec=%.0f";
+    printf(format, scenario, variant, items, stats->status, stats->syscalls, stats->writes,
+           items ? (double)stats->syscalls / items : 0.0, stats->seconds,
+           stats->seconds > 0 ? items / stats->seconds : 0.0);
+
+    // "key=value key=value" becomes ,"key":value (all of them are numbers)
+    char pairs[256];
+    snprintf(pairs, sizeof(pairs), "%s", extra ? extra : "");
+    for (char *pair = strtok(pairs, " "); pair != NULL; pair = strtok(NULL, " ")) {
+        char *value = strchr(pair, '=');
+        if (value == NULL) {
+            continue;
+        }
+        *value++ = '\0';
+        printf(json ? ",\"%s\":%s" : " %s=%s", pair, value);
+    }
+    printf(json ? "}\n" : "\n");
+    fflush(stdout);
+}
+
+// Print a scenario that could not run
+static void bench_error(const char *scenario, const char *variant) {
+    if (json) {
+        printf("{\"scenario\":\"%s\",\"variant\":\"%s\",\"error\":\"%s\"}\n",
+               scenario, variant ? variant : "", strerror(errno));
+    } else if (variant != NULL) {
+        printf("scenario=%s variant=%s error=%s\n", scenario, variant, strerror(errno));
+    } else {
+        printf("scenario=%s error=%s\n", scenario, strerror(errno));
+    }
+    fflush(stdout);
+}
+
+// Count and time one fileManager invocation and print its result line
+static void bench_run(const char *scenario, const char *variant, unsigned long items,
+                      char *const argv[], const char *stdout_path) {
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    if (run_counted(argv, stdout_path, &stats) == -1 || run_timed(argv, stdout_path, &stats) == -1) {
+        bench_error(scenario, variant);
+        return;
+    }
+    bench_print(scenario, variant, items, &stats, NULL);
+}
+
+// Directory with `entries` empty files, reused when it is already complete
+static int make_flat_tree(const char *dir, unsigned long entries) {
+    char marker[512];
+    snprintf(marker, sizeof(marker), "%s/.complete", dir);
+    if (access(marker, F_OK) == 0) {
+        return 0;
+    }
+
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        return -1;
+    }
+    int dfd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (dfd == -1) {
+        return -1;
+    }
+
+    char name[64];
+    for (unsigned long i = 0; i < entries; i++) {
+        snprintf(name, sizeof(name), "entry_%07lu.txt", i);
+        int fd = openat(dfd, name, O_WRONLY | O_CREAT, 0644);
+        if (fd == -1) {
+            close(dfd);
+            return -1;
+        }
+        close(fd);
+    }
+    close(dfd);
+
+    int fd = open(marker, O_WRONLY | O_CREAT, 0644);
+    if (fd != -1) {
+        close(fd);
+    }
+    return 0;
+}
+
+// Tree of `entries` empty files, `fanout` per directory, directories nested
+// two levels deep (d_NNN/d_NNN/entry_NNN.txt)
+static int make_nested_tree(const char *dir, unsigned long entries, unsigned long fanout) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    if (access(path, F_OK) == 0) {
+        return 0;
+    }
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        return -1;
+    }
+
+    unsigned long leaves = (entries + fanout - 1) / fanout;
+    for (unsigned long leaf = 0; leaf < leaves; leaf++) {
+        snprintf(path, sizeof(path), "%s/d_%03lu", dir, leaf / fanout);
+        mkdir(path, 0755);
+        snprintf(path, sizeof(path), "%s/d_%03lu/d_%03lu", dir, leaf / fanout, leaf % fanout);
+        if (make_flat_tree(path, entries - leaf * fanout < fanout ? entries - leaf * fanout : fanout) == -1) {
+            return -1;
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (fd != -1) {
+        close(fd);
+    }
+    return 0;
+}
+
+// listDir over one huge directory, unbuffered (one write per fragment,
+// like the old write_message) against the default stdout buffer, then
+// sorted by name (no stat), by size (statx per entry) and the top 100
+static void scenario_listdir() {
+    char dir[64];
+    snprintf(dir, sizeof(dir), "listdir_%lu", count);
+    if (make_flat_tree(dir, count) == -1) {
+        bench_error("listdir", NULL);
+        return;
+    }
+
+    char *unbuffered[] = { (char *)file_manager, "--output-buffer=0", "listDir", dir, NULL };
+    char *buffered[] = { (char *)file_manager, "listDir", dir, NULL };
+    bench_run("listdir", "unbuffered", count, unbuffered, NULL);
+    bench_run("listdir", "buffered", count, buffered, NULL);
+
+    char *by_name[] = { (char *)file_manager, "listDir", "--sort=name", dir, NULL };
+    char *by_size[] = { (char *)file_manager, "listDir", "--sort=size", "--long", dir, NULL };
+    char *top[] = { (char *)file_manager, "listDir", "--sort=size", "--limit=100", dir, NULL };
+    bench_run("listdir", "sort_name", count, by_name, NULL);
+    bench_run("listdir", "sort_size_long", count, by_size, NULL);
+    bench_run("listdir", "sort_size_top100", count, top, NULL);
+}
+
+// Regular file of `bytes` pseudo-random bytes, reused when the size matches
+static int make_data_file(const char *path, unsigned long bytes) {
+    struct stat st;
+    if (stat(path, &st) == 0 && (unsigned long)st.st_size == bytes) {
+        return 0;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+
+    static unsigned long block[8192];
+    unsigned long seed = 88172645463325252UL;
+    unsigned long written = 0;
+    while (written < bytes) {
+        for (size_t i = 0; i < sizeof(block) / sizeof(block[0]); i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            block[i] = seed;
+        }
+        size_t len = bytes - written < sizeof(block) ? bytes - written : sizeof(block);
+        if (write(fd, block, len) != (ssize_t)len) {
+            close(fd);
+            return -1;
+        }
+        written += len;
+    }
+    return close(fd);
+}
+
+// readFile of one large file into a regular file: read()/write() copies
+// against mmap and the in-kernel copy_file_range/sendfile path (items = bytes)
+static void scenario_readfile() {
+    char path[64];
+    snprintf(path, sizeof(path), "readfile_%lu.dat", file_bytes);
+    if (make_data_file(path, file_bytes) == -1) {
+        bench_error("readfile", NULL);
+        return;
+    }
+
+    char *copy[] = { (char *)file_manager, "--transfer=copy", "readFile", path, NULL };
+    char *mapped[] = { (char *)file_manager, "--transfer=mmap", "readFile", path, NULL };
+    char *zero_copy[] = { (char *)file_manager, "--transfer=auto", "readFile", path, NULL };
+    bench_run("readfile", "copy", file_bytes, copy, "readfile.out");
+    bench_run("readfile", "mmap", file_bytes, mapped, "readfile.out");
+    bench_run("readfile", "zerocopy", file_bytes, zero_copy, "readfile.out");
+    unlink("readfile.out");
+}
+
+// copyFile of one large file through a buffer, with copy_file_range on
+// one thread and on one per CPU, then moveFile (a rename); items = bytes
+static void scenario_copyfile() {
+    char path[64];
+    snprintf(path, sizeof(path), "readfile_%lu.dat", file_bytes);
+    if (make_data_file(path, file_bytes) == -1) {
+        bench_error("copyfile", NULL);
+        return;
+    }
+
+    char *variants[][6] = {
+        { "copy", (char *)file_manager, "--transfer=copy", "copyFile", "--threads=1", NULL },
+        { "kernel", (char *)file_manager, "copyFile", "--threads=1", NULL, NULL },
+        { "parallel", (char *)file_manager, "copyFile", NULL, NULL, NULL },
+        { "move", (char *)file_manager, "moveFile", NULL, NULL, NULL },
+    };
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        char *argv[8];
+        int argc = 0;
+        for (int i = 1; i < 6 && variants[v][i] != NULL; i++) {
+            argv[argc++] = variants[v][i];
+        }
+        argv[argc++] = path;
+        argv[argc++] = "copyfile.dat";
+        argv[argc] = NULL;
+
+        // A move takes the file away; put it back before the next run
+        int move = strcmp(variants[v][0], "move") == 0;
+        RunStats stats;
+        memset(&stats, 0, sizeof(stats));
+        unlink("copyfile.dat");
+        int failed = run_counted(argv, NULL, &stats) == -1;
+        if (move) {
+            rename("copyfile.dat", path);
+        } else {
+            unlink("copyfile.dat");
+        }
+        failed = failed || run_timed(argv, NULL, &stats) == -1;
+        if (move) {
+            rename("copyfile.dat", path);
+        }
+        unlink("copyfile.dat");
+        if (failed) {
+            bench_error("copyfile", variants[v][0]);
+            continue;
+        }
+        bench_print("copyfile", variants[v][0], file_bytes, &stats, NULL);
+    }
+}
+
+// Recursive listDir over a nested tree, one walker thread against one per CPU
+static void scenario_listtree() {
+    char dir[64];
+    snprintf(dir, sizeof(dir), "listtree_%lu_%lu", count, fanout);
+    if (make_nested_tree(dir, count, fanout) == -1) {
+        bench_error("listtree", NULL);
+        return;
+    }
+
+    char *single[] = { (char *)file_manager, "listDir", "-R", "--threads=1", dir, NULL };
+    char *parallel[] = { (char *)file_manager, "listDir", "-R", dir, NULL };
+    char *sorted[] = { (char *)file_manager, "listDir", "-R", "--sort", dir, NULL };
+    bench_run("listtree", "threads1", count, single, NULL);
+    bench_run("listtree", "parallel", count, parallel, NULL);
+    bench_run("listtree", "sorted", count, sorted, NULL);
+}
+
+// listFilesByExtension over the nested tree: a full scan against an index
+// lookup (after indexDir), for an extension no file has
+static void scenario_extindex() {
+    char dir[64];
+    snprintf(dir, sizeof(dir), "listtree_%lu_%lu", count, fanout);
+    if (make_nested_tree(dir, count, fanout) == -1) {
+        bench_error("extindex", NULL);
+        return;
+    }
+
+    char *build[] = { (char *)file_manager, "indexDir", dir, NULL };
+    char *scan[] = { (char *)file_manager, "listFilesByExtension", "-R", dir, ".log", NULL };
+    char *lookup[] = { (char *)file_manager, "listFilesByExtension", "--index", dir, ".log", NULL };
+    bench_run("extindex", "build", count, build, NULL);
+    bench_run("extindex", "scan", count, scan, NULL);
+    bench_run("extindex", "lookup", count, lookup, NULL);
+}
+
+// du over the nested tree: one walker thread, one per CPU, and a rerun
+// with every directory unchanged since the cached scan
+static void scenario_du() {
+    char dir[64];
+    char cache[128];
+    snprintf(dir, sizeof(dir), "listtree_%lu_%lu", count, fanout);
+    snprintf(cache, sizeof(cache), "%s/.fmducache", dir);
+    if (make_nested_tree(dir, count, fanout) == -1) {
+        bench_error("du", NULL);
+        return;
+    }
+
+    char *single[] = { (char *)file_manager, "du", "--threads=1", dir, NULL };
+    char *parallel[] = { (char *)file_manager, "du", dir, NULL };
+    char *cached[] = { (char *)file_manager, "du", "--cache", dir, NULL };
+    bench_run("du", "threads1", count, single, "/dev/null");
+    bench_run("du", "parallel", count, parallel, "/dev/null");
+    unlink(cache);
+    RunStats stats;
+    if (run_counted(cached, "/dev/null", &stats) == 0) {  // Writes the cache
+        bench_run("du", "cached", count, cached, "/dev/null");
+    }
+    unlink(cache);
+}
+
+// Tree of `entries` files in directories of 1000: three in four have a
+// size of their own (a short header, the rest a hole), the others are 8 KB
+// and come in identical pairs
+static int make_dup_tree(const char *dir, unsigned long entries) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    if (access(path, F_OK) == 0) {
+        return 0;
+    }
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        return -1;
+    }
+
+    static unsigned long block[8192 / sizeof(unsigned long)];
+    for (unsigned long i = 0; i < entries; i++) {
+        if (i % 1000 == 0) {
+            snprintf(path, sizeof(path), "%s/d_%04lu", dir, i / 1000);
+            mkdir(path, 0755);
+        }
+        int paired = i % 4 == 0;
+        size_t written = paired ? sizeof(block) : 64;
+        unsigned long seed = (paired ? i / 8 : i) * 2654435761UL + 1;
+        for (size_t w = 0; w < written / sizeof(unsigned long); w++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            block[w] = seed;
+        }
+
+        snprintf(path, sizeof(path), "%s/d_%04lu/file_%07lu.dat", dir, i / 1000, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1 || write(fd, block, written) != (ssize_t)written ||
+            (!paired && ftruncate(fd, sizeof(block) + i) == -1)) {
+            return -1;
+        }
+        close(fd);
+    }
+
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (fd != -1) {
+        close(fd);
+    }
+    return 0;
+}
+
+// hashFile of one large file on one thread and on one per CPU (items =
+// bytes), then findDuplicates over a tree of small files (items = files)
+static void scenario_dedup() {
+    char path[64];
+    snprintf(path, sizeof(path), "readfile_%lu.dat", file_bytes);
+    if (make_data_file(path, file_bytes) == -1) {
+        bench_error("dedup", NULL);
+        return;
+    }
+    char *single[] = { (char *)file_manager, "hashFile", "--threads=1", path, NULL };
+    char *parallel[] = { (char *)file_manager, "hashFile", path, NULL };
+    bench_run("dedup", "hash1", file_bytes, single, "/dev/null");
+    bench_run("dedup", "hash", file_bytes, parallel, "/dev/null");
+
+    char dir[64];
+    snprintf(dir, sizeof(dir), "dedup_%lu", count);
+    if (make_dup_tree(dir, count) == -1) {
+        bench_error("dedup", NULL);
+        return;
+    }
+    char *find1[] = { (char *)file_manager, "findDuplicates", "--threads=1", dir, NULL };
+    char *find[] = { (char *)file_manager, "findDuplicates", dir, NULL };
+    bench_run("dedup", "find1", count, find1, "/dev/null");
+    bench_run("dedup", "find", count, find, "/dev/null");
+}
+
+// Tree of `entries` 16 KB log-like text files in directories of 1000;
+// every 100th file has one line holding "timeout_9f3" (and half of them
+// end in .log, the rest in .txt)
+static int make_text_tree(const char *dir, unsigned long entries) {
+    static const char *words[] = { "GET ", "/index.html ", "200 ", "user=42 ", "took ",
+                                   "12ms ", "INFO ", "request ", "done ", "cache hit " };
+    char path[512];
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    if (access(path, F_OK) == 0) {
+        return 0;
+    }
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        return -1;
+    }
+
+    static char text[16384];
+    unsigned long seed = 2463534242UL;
+    for (unsigned long i = 0; i < entries; i++) {
+        if (i % 1000 == 0) {
+            snprintf(path, sizeof(path), "%s/d_%04lu", dir, i / 1000);
+            mkdir(path, 0755);
+        }
+        size_t used = 0;
+        size_t line = 0;
+        while (used + 32 < sizeof(text)) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            const char *word = words[seed % 10];
+            size_t len = strlen(word);
+            memcpy(text + used, word, len);
+            used += len;
+            if (seed % 7 == 0) {
+                text[used++] = '\n';
+                if (++line == 100 && i % 100 == 0) {
+                    memcpy(text + used, "ERROR timeout_9f3\n", 18);
+                    used += 18;
+                }
+            }
+        }
+        text[used++] = '\n';
+
+        snprintf(path, sizeof(path), "%s/d_%04lu/file_%07lu.%s", dir, i / 1000, i, i % 2 ? "txt" : "log");
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1 || write(fd, text, used) != (ssize_t)used) {
+            return -1;
+        }
+        close(fd);
+    }
+
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    if (fd != -1) {
+        close(fd);
+    }
+    return 0;
+}
+
+// searchFiles for a rare string over a tree of text files, one thread
+// against one per CPU and with --ext, then grep -rnF for comparison
+// (items = files; output goes to a file, grep stops early on /dev/null)
+static void scenario_search() {
+    char dir[64];
+    snprintf(dir, sizeof(dir), "search_%lu", count);
+    if (make_text_tree(dir, count) == -1) {
+        bench_error("search", NULL);
+        return;
+    }
+
+    char *single[] = { (char *)file_manager, "searchFiles", "--threads=1", dir, "timeout_9f3", NULL };
+    char *parallel[] = { (char *)file_manager, "searchFiles", dir, "timeout_9f3", NULL };
+    char *ext[] = { (char *)file_manager, "searchFiles", dir, "timeout_9f3", "--ext", ".log", NULL };
+    char *grep[] = { "grep", "-rnF", "timeout_9f3", dir, NULL };
+    bench_run("search", "threads1", count, single, "search.out");
+    bench_run("search", "parallel", count, parallel, "search.out");
+    bench_run("search", "ext", count, ext, "search.out");
+    bench_run("search", "grep", count, grep, "search.out");
+    unlink("search.out");
+}
+
+// Recursive deleteDir of a fresh copy of the nested tree, one walker
+// thread against one per CPU (items = files removed)
+static void scenario_deltree() {
+    const char *variants[][2] = { { "threads1", "--threads=1" }, { "parallel", NULL } };
+
+    for (size_t v = 0; v < 2; v++) {
+        char dir[64];
+        snprintf(dir, sizeof(dir), "deltree_%lu_%lu", count, fanout);
+        if (make_nested_tree(dir, count, fanout) == -1) {
+            bench_error("deltree", NULL);
+            return;
+        }
+
+        // Counting pass deletes the tree: rebuild it for the timed pass
+        char *argv[] = { (char *)file_manager, "deleteDir", "-R", (char *)variants[v][1], dir, NULL };
+        if (variants[v][1] == NULL) {
+            argv[3] = dir;
+            argv[4] = NULL;
+        }
+        RunStats stats;
+        memset(&stats, 0, sizeof(stats));
+        if (run_counted(argv, NULL, &stats) == -1 || make_nested_tree(dir, count, fanout) == -1 ||
+            run_timed(argv, NULL, &stats) == -1) {
+            bench_error("deltree", variants[v][0]);
+            continue;
+        }
+        bench_print("deltree", variants[v][0], count, &stats, NULL);
+    }
+}
+
+#define APPEND_PROCS 8
+
+// Lines in a file (0 if it is missing)
+static unsigned long count_lines(const char *path) {
+    FILE *file = fopen(path, "r");
+    unsigned long lines = 0;
+    int c;
+    if (file == NULL) {
+        return 0;
+    }
+    while ((c = getc(file)) != EOF) {
+        lines += c == '\n';
+    }
+    fclose(file);
+    return lines;
+}
+
+// One batch process making every append alone, then APPEND_PROCS batch
+// processes appending to one file at once: failing on a held lock (the old
+// behaviour), waiting for it, and queueing through an appendDaemon.
+// items = appends attempted, lost = appends missing after.
+static void scenario_append() {
+    unsigned long per_proc = count / 10 / APPEND_PROCS;
+    if (per_proc == 0) {
+        per_proc = 1;
+    }
+    unsigned long total = per_proc * APPEND_PROCS;
+
+    char fifo[4096];
+    if (getcwd(fifo, sizeof(fifo) - 32) == NULL) {
+        return;
+    }
+    strcat(fifo, "/append.fifo");
+
+    const char *variants[][2] = {
+        { "single", "" },
+        { "nowait", "" },
+        { "wait", "--wait=10000 " },
+        { "coalesce", NULL },
+    };
+    char coalesce_flag[4200];
+    snprintf(coalesce_flag, sizeof(coalesce_flag), "--coalesce=%s ", fifo);
+
+    for (size_t v = 0; v < 4; v++) {
+        const char *flag = variants[v][1] ? variants[v][1] : coalesce_flag;
+        int procs = v == 0 ? 1 : APPEND_PROCS;
+        FILE *script = fopen("append_script.txt", "w");
+        if (script == NULL) {
+            return;
+        }
+        for (unsigned long i = 0; i < total / procs; i++) {
+            fprintf(script, "appendToFile %sappend_target.txt \"line %lu of a concurrent append\"\n", flag, i);
+        }
+        fclose(script);
+        close(open("append_target.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644));
+
+        pid_t daemon = -1;
+        if (variants[v][1] == NULL) {
+            daemon = fork();
+            if (daemon == 0) {
+                int null = open("/dev/null", O_WRONLY);
+                dup2(null, STDOUT_FILENO);
+                execl(file_manager, file_manager, "appendDaemon", fifo, (char *)NULL);
+                _exit(127);
+            }
+            for (int i = 0; i < 200 && access(fifo, F_OK) != 0; i++) {
+                usleep(10000);
+            }
+            usleep(50000);  // Until it has the FIFO open
+        }
+
+        // One shell runs every appender in the background and waits
+        char command[8192];
+        int len = snprintf(command, sizeof(command), "for i in");
+        for (int p = 0; p < procs; p++) {
+            len += snprintf(command + len, sizeof(command) - len, " %d", p);
+        }
+        snprintf(command + len, sizeof(command) - len,
+                 "; do '%s' batch append_script.txt > /dev/null & done; wait", file_manager);
+        char *argv[] = { "/bin/sh", "-c", command, NULL };
+
+        RunStats stats;
+        memset(&stats, 0, sizeof(stats));
+        int failed = run_counted(argv, NULL, &stats) == -1 || run_timed(argv, NULL, &stats) == -1;
+
+        if (daemon > 0) {
+            kill(daemon, SIGTERM);
+            waitpid(daemon, NULL, 0);
+        }
+        if (failed) {
+            bench_error("append", variants[v][0]);
+            continue;
+        }
+
+        // Both the counted and the timed pass appended everything
+        char extra[64];
+        unsigned long lines = count_lines("append_target.txt");
+        snprintf(extra, sizeof(extra), "lost=%lu", 2 * total > lines ? 2 * total - lines : 0);
+        bench_print("append", variants[v][0], total, &stats, extra);
+    }
+    unlink("append_script.txt");
+    unlink("append_target.txt");
+}
+
+// log.txt with `records` records, ten a second from 2026-01-01, reused
+// when it is already complete
+static int make_log(const char *dir, unsigned long records) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    if (access(path, F_OK) == 0) {
+        return 0;
+    }
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/log.txt", dir);
+    FILE *log = fopen(path, "w");
+    if (log == NULL) {
+        return -1;
+    }
+    time_t start = 1767225600;  // 2026-01-01 00:00:00 UTC
+    char stamp[32];
+    for (unsigned long i = 0; i < records; i++) {
+        time_t when = start + i / 10;
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", gmtime(&when));
+        fprintf(log, "[%s] Appended content to file \"data/file_%05lu.txt\".\n", stamp, i % 50000);
+    }
+    if (fclose(log) != 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    return close(open(path, O_WRONLY | O_CREAT, 0644));
+}
+
+// showLogs over a log of `count` records: the whole log, one minute from
+// the middle, the last 100 records, and a text that appears once
+static void scenario_showlogs() {
+    char dir[64];
+    snprintf(dir, sizeof(dir), "showlogs_%lu", count);
+    if (make_log(dir, count) == -1 || chdir(dir) == -1) {
+        bench_error("showlogs", NULL);
+        return;
+    }
+
+    char since[64], until[64], grep[64];
+    time_t middle = 1767225600 + count / 20;
+    strftime(since, sizeof(since), "--since=%Y-%m-%d %H:%M:00", gmtime(&middle));
+    strftime(until, sizeof(until), "--until=%Y-%m-%d %H:%M", gmtime(&middle));
+    snprintf(grep, sizeof(grep), "--grep=file_%05lu.txt", (count / 2) % 50000);
+
+    char *full[] = { (char *)file_manager, "showLogs", NULL };
+    char *range[] = { (char *)file_manager, "showLogs", since, until, NULL };
+    char *tail[] = { (char *)file_manager, "showLogs", "--tail=100", NULL };
+    char *text[] = { (char *)file_manager, "showLogs", grep, NULL };
+    bench_run("showlogs", "full", count, full, "showlogs.out");
+    bench_run("showlogs", "range", count, range, "showlogs.out");
+    bench_run("showlogs", "tail", count, tail, "showlogs.out");
+    bench_run("showlogs", "grep", count, text, "showlogs.out");
+    unlink("showlogs.out");
+    chdir("..");
+}
+
+// Remove log.txt, the segment index and every segment
+static void remove_logs() {
+    char name[64];
+    unlink("log.txt");
+    unlink("log.index");
+    for (unsigned long i = 1;; i++) {
+        snprintf(name, sizeof(name), "log.%06lu.txt", i);
+        int plain = unlink(name);
+        strcat(name, ".gz");
+        if (unlink(name) == -1 && plain == -1) {
+            break;
+        }
+    }
+}
+
+// A batch of count / 10 appends with log.txt left to grow and with 64 KB
+// rotation plus compression, then --tail=10 over the rotated log
+static void scenario_logrotate() {
+    char dir[64];
+    unsigned long appends = count / 10 ? count / 10 : 1;
+    snprintf(dir, sizeof(dir), "logrotate_%lu", count);
+    if ((mkdir(dir, 0755) == -1 && errno != EEXIST) || chdir(dir) == -1) {
+        bench_error("logrotate", NULL);
+        return;
+    }
+
+    FILE *script = fopen("rotate_script.txt", "w");
+    if (script == NULL) {
+        chdir("..");
+        return;
+    }
+    for (unsigned long i = 0; i < appends; i++) {
+        fprintf(script, "appendToFile rotate_target.txt \"line %lu\"\n", i);
+    }
+    fclose(script);
+
+    char *plain[] = { (char *)file_manager, "batch", "rotate_script.txt", NULL };
+    char *rotated[] = { (char *)file_manager, "--log-rotate=64K", "--log-compress", "batch",
+                        "rotate_script.txt", NULL };
+    char *tail[] = { (char *)file_manager, "showLogs", "--tail=10", NULL };
+    close(open("rotate_target.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    remove_logs();
+    bench_run("logrotate", "plain", appends, plain, "/dev/null");
+    remove_logs();
+    bench_run("logrotate", "rotate", appends, rotated, "/dev/null");
+    bench_run("logrotate", "tail", appends, tail, "/dev/null");
+
+    remove_logs();
+    unlink("rotate_script.txt");
+    unlink("rotate_target.txt");
+    chdir("..");
+}
+
+// count / 1000 listDir commands over a 1000-entry directory, each one a
+// fileManager process of its own, against the same commands sent to a
+// serve process with --server (only the clients are traced)
+static void scenario_serve() {
+    unsigned long commands = count / 1000 ? count / 1000 : 1;
+    if (make_flat_tree("serve_dir", 1000) == -1) {
+        bench_error("serve", NULL);
+        return;
+    }
+
+    char fifo[4096];
+    if (getcwd(fifo, sizeof(fifo) - 32) == NULL) {
+        return;
+    }
+    strcat(fifo, "/serve.fifo");
+    pid_t server = fork();
+    if (server == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        execl(file_manager, file_manager, "serve", fifo, (char *)NULL);
+        _exit(127);
+    }
+    for (int i = 0; i < 200 && access(fifo, F_OK) != 0; i++) {
+        usleep(10000);
+    }
+    usleep(50000);  // Until it has the FIFO open
+
+    const char *variants[][2] = {
+        { "process", "" },
+        { "server", fifo },
+    };
+    for (size_t v = 0; v < 2; v++) {
+        char flag[4200] = "";
+        if (variants[v][1][0] != '\0') {
+            snprintf(flag, sizeof(flag), "'--server=%s' ", variants[v][1]);
+        }
+        char command[8192];
+        snprintf(command, sizeof(command),
+                 "i=0; while [ $i -lt %lu ]; do '%s' %slistDir serve_dir || exit 1; i=$((i+1)); done",
+                 commands, file_manager, flag);
+        char *argv[] = { "/bin/sh", "-c", command, NULL };
+        bench_run("serve", variants[v][0], commands, argv, "/dev/null");
+    }
+
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+}
+
+// log.bin with `records` records, ten a second from 2026-01-01, cycling
+// through the op codes, reused when it is already complete
+static int make_binary_log(const char *dir, unsigned long records) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    if (access(path, F_OK) == 0) {
+        return 0;
+    }
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/" LOG_BINARY_FILE, dir);
+    FILE *log = fopen(path, "w");
+    if (log == NULL) {
+        return -1;
+    }
+    LogFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOG_BINARY_MAGIC, sizeof(header.magic));
+    header.record_size = LOG_RECORD_SIZE;
+    fwrite(&header, sizeof(header), 1, log);
+
+    LogRecord record;
+    memset(&record, 0, sizeof(record));
+    uint64_t start = 1767225600ULL * 1000000000;  // 2026-01-01 00:00:00 UTC
+    for (unsigned long i = 0; i < records; i++) {
+        record.time_ns = start + i * 100000000ULL;
+        record.op = 1 + i % (LOG_OP_COUNT - 1);
+        record.status = i % 97 == 0;
+        record.path_len = snprintf(record.path, sizeof(record.path), "data/file_%05lu.txt", i % 50000);
+        fwrite(&record, sizeof(record), 1, log);
+    }
+    if (fclose(log) != 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/.complete", dir);
+    return close(open(path, O_WRONLY | O_CREAT, 0644));
+}
+
+// Appends logged as text and as binary records, then showLogs over a
+// binary log of `count` records: one minute from the middle, the last 100
+// records, a path that appears once (rendering every record), and the
+// per-hour summary
+static void scenario_binlog() {
+    char dir[64];
+    unsigned long appends = count / 100 ? count / 100 : 1;
+    snprintf(dir, sizeof(dir), "binlog_%lu", count);
+    if (make_binary_log(dir, count) == -1 || chdir(dir) == -1) {
+        bench_error("binlog", NULL);
+        return;
+    }
+
+    // The appends run in a directory of their own to leave log.bin alone
+    if ((mkdir("writes", 0755) == -1 && errno != EEXIST) || chdir("writes") == -1) {
+        bench_error("binlog", NULL);
+        chdir("..");
+        return;
+    }
+    FILE *script = fopen("binlog_script.txt", "w");
+    if (script == NULL) {
+        chdir("../..");
+        return;
+    }
+    for (unsigned long i = 0; i < appends; i++) {
+        fprintf(script, "appendToFile binlog_target.txt \"line %lu\"\n", i);
+    }
+    fclose(script);
+
+    char *plain[] = { (char *)file_manager, "batch", "binlog_script.txt", NULL };
+    char *records[] = { (char *)file_manager, "--log-format=binary", "batch", "binlog_script.txt", NULL };
+    close(open("binlog_target.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    bench_run("binlog", "write_text", appends, plain, "/dev/null");
+    bench_run("binlog", "write_binary", appends, records, "/dev/null");
+    unlink("binlog_target.txt");
+    unlink("binlog_script.txt");
+    unlink(LOG_FILE);
+    unlink(LOG_BINARY_FILE);
+    chdir("..");
+    rmdir("writes");
+
+    // Times are local in showLogs: the middle record's local minute
+    char since[64], until[64], grep[64];
+    time_t middle = 1767225600 + count / 20;
+    strftime(since, sizeof(since), "--since=%Y-%m-%d %H:%M:00", localtime(&middle));
+    strftime(until, sizeof(until), "--until=%Y-%m-%d %H:%M", localtime(&middle));
+    snprintf(grep, sizeof(grep), "--grep=file_%05lu.txt", (count / 2) % 50000);
+
+    char *range[] = { (char *)file_manager, "--log-format=binary", "showLogs", since, until, NULL };
+    char *tail[] = { (char *)file_manager, "--log-format=binary", "showLogs", "--tail=100", NULL };
+    char *text[] = { (char *)file_manager, "--log-format=binary", "showLogs", grep, NULL };
+    char *summary[] = { (char *)file_manager, "--log-format=binary", "showLogs", "--summary", NULL };
+    bench_run("binlog", "range", count, range, "binlog.out");
+    bench_run("binlog", "tail", count, tail, "binlog.out");
+    bench_run("binlog", "grep", count, text, "binlog.out");
+    bench_run("binlog", "summary", count, summary, "binlog.out");
+    unlink("binlog.out");
+    chdir("..");
+}
+
+// count / 1000 lines appended to a 1 MB log, each followed by a readFile
+// of the whole file (polling) against one readFile --follow that gets
+// only the new bytes
+static void scenario_follow() {
+    unsigned long appends = count / 1000 ? count / 1000 : 1;
+    FILE *log = fopen("follow.log", "w");
+    if (log == NULL) {
+        bench_error("follow", NULL);
+        return;
+    }
+    for (unsigned long i = 0; ftell(log) < 1 << 20; i++) {
+        fprintf(log, "existing line %lu of the followed log\n", i);
+    }
+    fclose(log);
+
+    char reread[4096], follow[4096];
+    snprintf(reread, sizeof(reread),
+             "i=0; while [ $i -lt %lu ]; do echo \"appended line $i\" >> follow.log; "
+             "'%s' readFile follow.log > /dev/null; i=$((i+1)); done",
+             appends, file_manager);
+    snprintf(follow, sizeof(follow),
+             "'%s' readFile --follow follow.log > follow.out & sleep 0.2; "
+             "i=0; while [ $i -lt %lu ]; do echo \"appended line $i\" >> follow.log; i=$((i+1)); done; "
+             "sleep 0.2; kill -INT $!; wait",
+             file_manager, appends);
+    char *polling[] = { "/bin/sh", "-c", reread, NULL };
+    char *following[] = { "/bin/sh", "-c", follow, NULL };
+    bench_run("follow", "reread", appends, polling, "/dev/null");
+
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (run_counted(following, "/dev/null", &stats) == -1 || run_timed(following, "/dev/null", &stats) == -1) {
+        bench_error("follow", "follow");
+    } else {
+        // The timed follower prints a header and 10 lines, then every append
+        char extra[64];
+        unsigned long lines = count_lines("follow.out");
+        snprintf(extra, sizeof(extra), "lost=%lu", appends + 11 > lines ? appends + 11 - lines : 0);
+        bench_print("follow", "follow", appends, &stats, extra);
+    }
+    unlink("follow.log");
+    unlink("follow.out");
+}
+
+// Remove a directory of plain files, and its .complete marker
+static void remove_flat_tree(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            unlinkat(dirfd(d), entry->d_name, 0);
+        }
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+// Script of count / 10 lines "command dir/entry_NNNNNNN.txt", one per
+// entry of a flat tree
+static int write_entry_script(const char *path, const char *command, const char *dir,
+                              unsigned long entries) {
+    FILE *script = fopen(path, "w");
+    if (script == NULL) {
+        return -1;
+    }
+    for (unsigned long i = 0; i < entries; i++) {
+        fprintf(script, "%s %s/entry_%07lu.txt\n", command, dir, i);
+    }
+    return fclose(script);
+}
+
+// count / 10 createFile commands in one batch, against count / 1000 of
+// them each run as its own fileManager process, and count / 10 files made
+// by one createFiles, one at a time and through io_uring
+static void scenario_createfile() {
+    unsigned long files = count / 10 ? count / 10 : 1;
+    unsigned long processes = count / 1000 ? count / 1000 : 1;
+    const char *dir = "createfile_dir";
+    remove_flat_tree(dir);
+
+    if (write_entry_script("createfile_script.txt", "createFile", dir, files) == -1) {
+        bench_error("createfile", NULL);
+        return;
+    }
+    char *batch[] = { (char *)file_manager, "batch", "createfile_script.txt", NULL };
+
+    // Both passes need an empty directory to create into
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+    mkdir(dir, 0755);
+    int failed = run_counted(batch, "/dev/null", &stats) == -1;
+    remove_flat_tree(dir);
+    mkdir(dir, 0755);
+    failed = failed || run_timed(batch, "/dev/null", &stats) == -1;
+    remove_flat_tree(dir);
+    if (failed) {
+        bench_error("createfile", "batch");
+    } else {
+        bench_print("createfile", "batch", files, &stats, NULL);
+    }
+
+    char command[4200];
+    snprintf(command, sizeof(command),
+             "i=0; while [ $i -lt %lu ]; do '%s' createFile %s/entry_$i.txt || exit 1; i=$((i+1)); done",
+             processes, file_manager, dir);
+    char *each[] = { "/bin/sh", "-c", command, NULL };
+    memset(&stats, 0, sizeof(stats));
+    mkdir(dir, 0755);
+    failed = run_counted(each, "/dev/null", &stats) == -1;
+    remove_flat_tree(dir);
+    mkdir(dir, 0755);
+    failed = failed || run_timed(each, "/dev/null", &stats) == -1;
+    remove_flat_tree(dir);
+    if (failed) {
+        bench_error("createfile", "process");
+    } else {
+        bench_print("createfile", "process", processes, &stats, NULL);
+    }
+    unlink("createfile_script.txt");
+
+    // createFiles: the same files one at a time and through io_uring
+    char files_arg[32];
+    snprintf(files_arg, sizeof(files_arg), "%lu", files);
+    const char *bulk[][2] = { { "bulk_sync", "--sync" }, { "bulk_uring", NULL } };
+    for (size_t v = 0; v < 2; v++) {
+        char *argv[] = { (char *)file_manager, "createFiles", (char *)bulk[v][1], (char *)dir, files_arg, NULL };
+        if (bulk[v][1] == NULL) {
+            argv[2] = (char *)dir;
+            argv[3] = files_arg;
+            argv[4] = NULL;
+        }
+        memset(&stats, 0, sizeof(stats));
+        mkdir(dir, 0755);
+        failed = run_counted(argv, "/dev/null", &stats) == -1;
+        remove_flat_tree(dir);
+        mkdir(dir, 0755);
+        failed = failed || run_timed(argv, "/dev/null", &stats) == -1;
+        remove_flat_tree(dir);
+        if (failed) {
+            bench_error("createfile", bulk[v][0]);
+        } else {
+            bench_print("createfile", bulk[v][0], files, &stats, NULL);
+        }
+    }
+}
+
+// deleteFile of every entry of a flat tree of count / 10 files in one batch
+static void scenario_deletefile() {
+    unsigned long files = count / 10 ? count / 10 : 1;
+    const char *dir = "deletefile_dir";
+
+    char *batch[] = { (char *)file_manager, "batch", "deletefile_script.txt", NULL };
+    RunStats stats;
+    memset(&stats, 0, sizeof(stats));
+    remove_flat_tree(dir);
+    int failed = write_entry_script("deletefile_script.txt", "deleteFile", dir, files) == -1 ||
+                 make_flat_tree(dir, files) == -1 || run_counted(batch, "/dev/null", &stats) == -1;
+    remove_flat_tree(dir);
+    failed = failed || make_flat_tree(dir, files) == -1 || run_timed(batch, "/dev/null", &stats) == -1;
+    remove_flat_tree(dir);
+    if (failed) {
+        bench_error("deletefile", "batch");
+    } else {
+        bench_print("deletefile", "batch", files, &stats, NULL);
+    }
+    unlink("deletefile_script.txt");
+}
+
+// readFile of files from 4 KB up to -s bytes, 16 times bigger each step;
+// items = bytes
+static void scenario_readsizes() {
+    for (unsigned long bytes = 4096; bytes <= file_bytes; bytes *= 16) {
+        char path[64], variant[32];
+        snprintf(path, sizeof(path), "readsizes_%lu.dat", bytes);
+        snprintf(variant, sizeof(variant), "bytes%lu", bytes);
+        if (make_data_file(path, bytes) == -1) {
+            bench_error("readsizes", variant);
+            return;
+        }
+        char *argv[] = { (char *)file_manager, "readFile", path, NULL };
+        bench_run("readsizes", variant, bytes, argv, "readsizes.out");
+    }
+    unlink("readsizes.out");
+}
+
+typedef struct {
+    const char *name;
+    void (*run)();
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { "createfile", scenario_createfile },
+    { "deletefile", scenario_deletefile },
+    { "listdir", scenario_listdir },
+    { "readfile", scenario_readfile },
+    { "readsizes", scenario_readsizes },
+    { "copyfile", scenario_copyfile },
+    { "listtree", scenario_listtree },
+    { "extindex", scenario_extindex },
+    { "du", scenario_du },
+    { "dedup", scenario_dedup },
+    { "search", scenario_search },
+    { "deltree", scenario_deltree },
+    { "append", scenario_append },
+    { "showlogs", scenario_showlogs },
+    { "logrotate", scenario_logrotate },
+    { "binlog", scenario_binlog },
+    { "follow", scenario_follow },
+    { "serve", scenario_serve },
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+int main(int argc, char *argv[]) {
+    // Fixtures run to millions of files: keep them out of the source tree
+    char default_workdir[4096];
+    const char *tmpdir = getenv("TMPDIR");
+    snprintf(default_workdir, sizeof(default_workdir), "%s/fileManagerBench",
+             tmpdir != NULL && tmpdir[0] != '\0' ? tmpdir : "/tmp");
+    const char *workdir = default_workdir;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:w:d:f:jl")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            file_bytes = strtoul(optarg, NULL, 10);
+            break;
+        case 'w':
+            fanout = strtoul(optarg, NULL, 10);
+            if (fanout == 0) {
+                fanout = 1;
+            }
+            break;
+        case 'd':
+            workdir = optarg;
+            break;
+        case 'j':
+            json = 1;
+            break;
+        case 'l':
+            for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+                printf("%s\n", scenarios[i].name);
+            }
+            return 0;
+        case 'f':
+            file_manager = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n count] [-s bytes] [-w fanout] [-d workdir] [-f fileManager] [-j] [-l] "
+                    "[scenario...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // fileManager is run from inside the work directory so its log.txt
+    // lands there too
+    static char binary[4096];
+    if (file_manager == NULL) {
+        file_manager = "./fileManager";
+    }
+    if (realpath(file_manager, binary) == NULL) {
+        fprintf(stderr, "Cannot find %s: %s\n", file_manager, strerror(errno));
+        return 1;
+    }
+    file_manager = binary;
+
+    if (mkdir(workdir, 0755) == -1 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s: %s\n", workdir, strerror(errno));
+        return 1;
+    }
+    if (chdir(workdir) == -1) {
+        fprintf(stderr, "Cannot enter %s: %s\n", workdir, strerror(errno));
+        return 1;
+    }
+
+    for (int a = optind; a < argc; a++) {
+        size_t i = 0;
+        while (i < SCENARIO_COUNT && strcmp(argv[a], scenarios[i].name) != 0) {
+            i++;
+        }
+        if (i == SCENARIO_COUNT) {
+            fprintf(stderr, "Unknown scenario %s (-l lists them)\n", argv[a]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+        int selected = optind == argc;
+        for (int a = optind; a < argc; a++) {
+            if (strcmp(argv[a], scenarios[i].name) == 0) {
+                selected = 1;
+            }
+        }
+        if (selected) {
+            scenarios[i].run();
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,378 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "bulkcreate.h"
+
+// Longest name taken from a list, with its NUL
+#define BULK_NAME_MAX 256
+
+// The ring, talked to through the raw system calls (no liburing)
+typedef struct {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sqe_tail;          // requests queued but not yet published
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    size_t sqes_size;
+} Ring;
+
+// Which of a file's three requests a completion belongs to
+#define OP_OPEN 0
+#define OP_WRITE 1
+#define OP_CLOSE 2
+
+static void ring_exit(Ring *ring) {
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    if (ring->sq_ptr != NULL) {
+        munmap(ring->sq_ptr, ring->sq_size);
+    }
+    close(ring->fd);
+}
+
+// Function to set up a ring and a table of slots direct descriptors are
+// opened into; -1 if the kernel has no (usable) io_uring
+static int ring_init(Ring *ring, unsigned entries, unsigned slots) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = entries;
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sq_size = ring->cq_size = ring->sq_size > ring->cq_size ? ring->sq_size : ring->cq_size;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        ring->sq_ptr = NULL;
+        ring_exit(ring);
+        return -1;
+    }
+    ring->cq_ptr = ring->sq_ptr;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            ring->cq_ptr = NULL;
+            ring_exit(ring);
+            return -1;
+        }
+    }
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        ring_exit(ring);
+        return -1;
+    }
+
+    char *sq = ring->sq_ptr;
+    ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->sq_entries = p.sq_entries;
+    ring->sqe_tail = *ring->sq_tail;
+    char *cq = ring->cq_ptr;
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    // Creates in one directory take its lock in turn, so more kernel
+    // workers than CPUs only queue up on it
+    unsigned workers[2];
+    workers[0] = workers[1] = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_IOWQ_MAX_WORKERS, workers, 2);
+
+    // An empty table: openat installs each file straight into a slot
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = slots;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES2, &reg, sizeof(reg)) < 0) {
+        ring_exit(ring);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to queue one request; the caller never queues more than fit
+static struct io_uring_sqe *ring_sqe(Ring *ring) {
+    unsigned index = ring->sqe_tail++ & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    return sqe;
+}
+
+// Function to queue the open, header write and close of one file into a
+// slot as one chain: a failed open (a name already taken) cancels the
+// rest, while the close runs even if the write failed, so every slot is
+// free again when the batch is done
+static void queue_file(Ring *ring, int dir_fd, const char *name, unsigned slot,
+                       const char *header, size_t header_len) {
+    struct io_uring_sqe *sqe = ring_sqe(ring);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = dir_fd;
+    sqe->addr = (unsigned long)name;
+    sqe->len = 0644;
+    sqe->open_flags = O_WRONLY | O_CREAT | O_EXCL;  // O_CLOEXEC is refused for direct ones
+    sqe->file_index = slot + 1;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = (unsigned long)slot << 2 | OP_OPEN;
+
+    sqe = ring_sqe(ring);
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = slot;
+    sqe->addr = (unsigned long)header;
+    sqe->len = header_len;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = (unsigned long)slot << 2 | OP_WRITE;
+
+    sqe = ring_sqe(ring);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    sqe->user_data = (unsigned long)slot << 2 | OP_CLOSE;
+}
+
+// Function to submit what is queued and wait for all of its completions:
+// one system call per batch
+static int ring_run(Ring *ring, unsigned queued, unsigned char *results) {
+    unsigned done = 0;
+    unsigned submit = ring->sqe_tail - *ring->sq_tail;
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+    while (done < queued) {
+        int entered = syscall(__NR_io_uring_enter, ring->fd, submit, queued - done,
+                              IORING_ENTER_GETEVENTS, NULL, 0);
+        if (entered < 0 && errno != EINTR) {
+            return -1;
+        }
+        submit -= entered > 0 ? (unsigned)entered : 0;
+
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++, done++) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            unsigned slot = cqe->user_data >> 2;
+            int op = cqe->user_data & 3;
+
+            // results[slot]: bit 0 opened, bit 1 exists, bit 2 write failed
+            if (op == OP_OPEN) {
+                results[slot] |= cqe->res >= 0 ? 1 : cqe->res == -EEXIST ? 2 : 0;
+            } else if (op == OP_WRITE && cqe->res < 0 && cqe->res != -ECANCELED) {
+                results[slot] |= 4;
+            }
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+// Function to put the name of file number i (or the next line of the
+// list) into name; 0 when there are no more
+static int next_name(char *name, unsigned long i, unsigned long count, int width,
+                     const char **list, const char *list_end) {
+    if (*list == NULL) {
+        if (i >= count) {
+            return 0;
+        }
+        // "file_" + zero-padded number + ".txt", without snprintf
+        memcpy(name, "file_", 5);
+        for (int d = width - 1; d >= 0; d--) {
+            name[5 + d] = '0' + i % 10;
+            i /= 10;
+        }
+        memcpy(name + 5 + width, ".txt", 5);
+        return 1;
+    }
+
+    // Empty lines are skipped. Names too long to keep, and names that are
+    // not a plain entry of the folder ("a/b", "../x", ".", ".."), come back
+    // empty and are counted as failed.
+    for (;;) {
+        if (*list >= list_end) {
+            return 0;
+        }
+        const char *line = *list;
+        const char *newline = memchr(line, '\n', list_end - line);
+        const char *end = newline ? newline : list_end;
+        *list = newline ? newline + 1 : list_end;
+        size_t len = end - line;
+        if (len > 0 && line[len - 1] == '\r') {
+            len--;
+        }
+        if (len == 0) {
+            continue;
+        }
+        if (len >= BULK_NAME_MAX || memchr(line, '/', len) != NULL ||
+            memchr(line, '\0', len) != NULL || (line[0] == '.' && (len == 1 ||
+            (len == 2 && line[1] == '.')))) {
+            name[0] = '\0';
+            return 1;
+        }
+        memcpy(name, line, len);
+        name[len] = '\0';
+        return 1;
+    }
+}
+
+// Function to create files in dir_name
+int bulk_create(const char *dir_name, unsigned long count, const char *names, int sync,
+                BulkStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    int dir_fd = open(dir_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd == -1) {
+        return -1;
+    }
+
+    // The list of names, mapped
+    const char *list = NULL;
+    const char *list_end = NULL;
+    void *list_map = NULL;
+    size_t list_size = 0;
+    if (names != NULL) {
+        int fd = open(names, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) == -1) {
+            int saved = errno;
+            if (fd != -1) {
+                close(fd);
+            }
+            close(dir_fd);
+            errno = saved;
+            return -1;
+        }
+        list_size = st.st_size;
+        if (list_size > 0) {
+            list_map = mmap(NULL, list_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (list_map == MAP_FAILED) {
+            close(dir_fd);
+            return -1;
+        }
+        list = list_map != NULL ? list_map : "";
+        list_end = list + list_size;
+    }
+
+    // Every file gets the same header: one localtime/strftime for all
+    char header[64];
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    size_t header_len = strftime(header, sizeof(header), "Created on: %Y-%m-%d %H:%M:%S\n", &local);
+
+    int width = 7;
+    for (unsigned long limit = 10000000; count > limit && width < 19; limit *= 10) {
+        width++;
+    }
+
+    Ring ring;
+    char (*slot_names)[BULK_NAME_MAX] = malloc(BULK_BATCH * sizeof(*slot_names));
+    unsigned char *results = malloc(BULK_BATCH);
+    int result = 0;
+    stats->uring = !sync && slot_names != NULL && results != NULL &&
+                   ring_init(&ring, 4 * BULK_BATCH, BULK_BATCH) == 0;
+
+    unsigned long i = 0;
+    if (stats->uring) {
+        for (;;) {
+            unsigned queued = 0;
+            memset(results, 0, BULK_BATCH);
+            while (queued < BULK_BATCH && next_name(slot_names[queued], i, count, width, &list, list_end)) {
+                i++;
+                if (slot_names[queued][0] == '\0') {
+                    stats->failed++;
+                    continue;
+                }
+                queue_file(&ring, dir_fd, slot_names[queued], queued, header, header_len);
+                queued++;
+            }
+            if (queued == 0) {
+                break;
+            }
+            if (ring_run(&ring, 3 * queued, results) == -1) {
+                result = -1;
+                break;
+            }
+            stats->batches++;
+            for (unsigned slot = 0; slot < queued; slot++) {
+                if (results[slot] == 1) {
+                    stats->created++;
+                } else if (results[slot] & 2) {
+                    stats->existed++;
+                } else {
+                    stats->failed++;
+                }
+            }
+        }
+        ring_exit(&ring);
+    } else if (slot_names != NULL) {
+        // One at a time, as createFile does, minus its stat and per-file time
+        char *name = slot_names[0];
+        while (next_name(name, i, count, width, &list, list_end)) {
+            i++;
+            int fd = name[0] ? openat(dir_fd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644) : -1;
+            if (fd == -1) {
+                if (name[0] && errno == EEXIST) {
+                    stats->existed++;
+                } else {
+                    stats->failed++;
+                }
+                continue;
+            }
+            if (write(fd, header, header_len) == (ssize_t)header_len) {
+                stats->created++;
+            } else {
+                stats->failed++;
+            }
+            close(fd);
+        }
+    } else {
+        errno = ENOMEM;
+        result = -1;
+    }
+
+    free(slot_names);
+    free(results);
+    if (list_map != NULL) {
+        munmap(list_map, list_size);
+    }
+    close(dir_fd);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef BULKCREATE_H
+#define BULKCREATE_H
+
+#include <stddef.h>
+
+// Files in flight at once: each takes an open, a write and a close
+#define BULK_BATCH 1024
+
+typedef struct {
+    unsigned long created;      // new files with their header written
+    unsigned long existed;      // names that were already taken
+    unsigned long failed;       // files that could not be created or written
+    unsigned long batches;      // batches submitted to io_uring (0 when synchronous)
+    int uring;                  // 1 if io_uring did the work
+} BulkStats;
+
+// Function to create files in dir_name, each with a "Created on: ..."
+// header like createFile: count files named file_0000000.txt, ... when
+// names is NULL, else one per line of names. Listed names must be plain
+// entries of dir_name: ones holding '/', and "." or "..", count as failed.
+// Opens, header writes and closes are submitted through io_uring in
+// batches of BULK_BATCH files, or made one by one if io_uring is not
+// available or sync is set. Returns -1 if dir_name cannot be opened.
+int bulk_create(const char *dir_name, unsigned long count, const char *names, int sync,
+                BulkStats *stats);
+
+#endif
\ No newline at end of file
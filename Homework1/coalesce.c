@@ -0,0 +1,217 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/uio.h>
+
+#include "coalesce.h"
+#include "fiforeader.h"
+
+#define COALESCE_BATCH (1024 * 1024)    // bytes read from the FIFO at once
+
+// Record layout on the FIFO: header, absolute file name, content
+typedef struct {
+    uint16_t name_len;
+    uint16_t data_len;
+} RecordHeader;
+
+typedef struct {
+    const char *name;
+    const char *data;
+    size_t name_len;
+    size_t data_len;
+    size_t order;       // arrival order, kept within a file
+} Record;
+
+// Records parsed from the FIFO, kept between batches
+typedef struct {
+    Record *records;
+    size_t cap;
+    CoalesceStats *stats;
+} CoalesceBatch;
+
+// Function to queue an append for the daemon listening on fifo
+int coalesce_submit(const char *fifo, const char *file_name, const char *data, size_t len) {
+    char path[PATH_MAX];
+    if (realpath(file_name, path) == NULL) {
+        return -1;  // The daemon may run elsewhere: it needs the full path
+    }
+
+    size_t name_len = strlen(path);
+    size_t total = sizeof(RecordHeader) + name_len + len;
+    if (total > COALESCE_RECORD_MAX || total > PIPE_BUF) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    // ENXIO here means nobody is serving the FIFO
+    int fd = open(fifo, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    fcntl(fd, F_SETFL, 0);  // Now block while the daemon catches up
+
+    char record[COALESCE_RECORD_MAX];
+    RecordHeader header = { (uint16_t)name_len, (uint16_t)len };
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), path, name_len);
+    memcpy(record + sizeof(header) + name_len, data, len);
+
+    // A daemon that quits between open and write must not kill us
+    struct sigaction ignore, old;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignore, &old);
+    ssize_t n = write(fd, record, total);  // <= PIPE_BUF: never interleaved
+    sigaction(SIGPIPE, &old, NULL);
+
+    close(fd);
+    return n == (ssize_t)total ? 0 : -1;
+}
+
+static int compare_records(const void *a, const void *b) {
+    const Record *x = a;
+    const Record *y = b;
+    size_t len = x->name_len < y->name_len ? x->name_len : y->name_len;
+    int order = memcmp(x->name, y->name, len);
+    if (order == 0 && x->name_len != y->name_len) {
+        order = x->name_len < y->name_len ? -1 : 1;
+    }
+    if (order == 0) {
+        order = x->order < y->order ? -1 : 1;
+    }
+    return order;
+}
+
+// Append a run of records for one file: one lock, writev in IOV_MAX pieces
+static void write_group(const Record *records, size_t count, CoalesceStats *stats) {
+    char path[PATH_MAX];
+    size_t len = records[0].name_len < sizeof(path) - 1 ? records[0].name_len : sizeof(path) - 1;
+    memcpy(path, records[0].name, len);
+    path[len] = '\0';
+
+    int fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd == -1) {
+        stats->failed += count;
+        return;
+    }
+    flock(fd, LOCK_EX);  // Direct appenders use the same lock
+
+    struct iovec iov[IOV_MAX];
+    size_t done = 0;
+    while (done < count) {
+        int n = 0;
+        while (done + n < count && n < IOV_MAX) {
+            iov[n].iov_base = (void *)records[done + n].data;
+            iov[n].iov_len = records[done + n].data_len;
+            n++;
+        }
+
+        // Short writes resume from where they stopped
+        struct iovec *next = iov;
+        int left = n;
+        while (left > 0) {
+            ssize_t written = writev(fd, next, left);
+            if (written == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                stats->failed += left;
+                break;
+            }
+            stats->writes++;
+            while (left > 0 && (size_t)written >= next->iov_len) {
+                written -= next->iov_len;
+                next++;
+                left--;
+            }
+            if (left > 0) {
+                next->iov_base = (char *)next->iov_base + written;
+                next->iov_len -= written;
+            }
+        }
+        done += n;
+    }
+
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+// Parse the complete records in data, write them grouped by file; returns
+// the bytes consumed (a trailing partial record is left for next time)
+static size_t process_batch(const char *data, size_t len, Record **records, size_t *cap,
+                            CoalesceStats *stats) {
+    size_t count = 0;
+    size_t pos = 0;
+
+    while (len - pos >= sizeof(RecordHeader)) {
+        RecordHeader header;
+        memcpy(&header, data + pos, sizeof(header));
+        size_t total = sizeof(header) + header.name_len + header.data_len;
+        if (len - pos < total) {
+            break;
+        }
+
+        if (count == *cap) {
+            size_t bigger = *cap ? *cap * 2 : 1024;
+            Record *grown = realloc(*records, bigger * sizeof(Record));
+            if (grown == NULL) {
+                break;  // Retried after the records so far are written
+            }
+            *records = grown;
+            *cap = bigger;
+        }
+        Record *record = &(*records)[count];
+        record->name = data + pos + sizeof(header);
+        record->name_len = header.name_len;
+        record->data = record->name + header.name_len;
+        record->data_len = header.data_len;
+        record->order = count++;
+        pos += total;
+    }
+
+    qsort(*records, count, sizeof(Record), compare_records);
+    for (size_t start = 0; start < count;) {
+        size_t end = start + 1;
+        while (end < count && (*records)[end].name_len == (*records)[start].name_len &&
+               memcmp((*records)[end].name, (*records)[start].name, (*records)[start].name_len) == 0) {
+            end++;
+        }
+        write_group(*records + start, end - start, stats);
+        start = end;
+    }
+
+    stats->records += count;
+    return pos;
+}
+
+// FIFO reader callback: everything queued right now is one batch
+static size_t coalesce_batch(const char *data, size_t len, void *arg) {
+    CoalesceBatch *batch = arg;
+    batch->stats->batches++;
+    return process_batch(data, len, &batch->records, &batch->cap, batch->stats);
+}
+
+// Function to serve fifo until SIGINT or SIGTERM
+int coalesce_serve(const char *fifo, CoalesceStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    FifoReader reader;
+    if (fifo_reader_open(&reader, fifo, 0666, COALESCE_BATCH) == -1) {
+        return -1;
+    }
+
+    // New writers fail to open the FIFO once we stop, and append directly
+    CoalesceBatch batch = { NULL, 0, stats };
+    fifo_reader_run(&reader, coalesce_batch, &batch);
+
+    fifo_reader_close(&reader);
+    free(batch.records);
+    return 0;
+}
\ No newline at end of file
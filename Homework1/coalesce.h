@@ -0,0 +1,25 @@
+#ifndef COALESCE_H
+#define COALESCE_H
+
+#include <stddef.h>
+
+// Appenders hand records to a daemon through a FIFO; each record is one
+// atomic pipe write, so it can carry at most this much (name + content)
+#define COALESCE_RECORD_MAX 4096
+
+typedef struct {
+    unsigned long records;      // appends received
+    unsigned long writes;       // writev calls made for them
+    unsigned long batches;      // reads from the FIFO
+    unsigned long failed;       // records that could not be written
+} CoalesceStats;
+
+// Function to queue an append for the daemon listening on fifo. Returns
+// 0 once queued, -1 if there is no daemon or the record is too big.
+int coalesce_submit(const char *fifo, const char *file_name, const char *data, size_t len);
+
+// Function to serve fifo, writing each batch of queued appends with one
+// writev per file, until SIGINT or SIGTERM
+int coalesce_serve(const char *fifo, CoalesceStats *stats);
+
+#endif
\ No newline at end of file
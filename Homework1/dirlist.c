@@ -0,0 +1,487 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "dirlist.h"
+#include "output.h"
+
+#define DIRLIST_DENTS_BUFFER (256 * 1024)  // getdents64 buffer
+#define DIRLIST_ARENA_BLOCK (1 << 20)      // names are carved out of blocks this big
+#define DIRLIST_SMALL_SORT 32              // runs this short are insertion sorted
+#define DIRLIST_TRIM_MIN 65536             // with a limit, entries held before trimming
+
+// One block of the arena; its records are only ever freed all together
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    char data[DIRLIST_ARENA_BLOCK];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;
+    size_t bytes;
+} Arena;
+
+// Stored in front of a record when the sort needs metadata
+typedef struct {
+    uint64_t size;
+    int64_t mtime_ns;
+} DirMeta;
+
+// A record in the arena is [DirMeta] type name '\0'. Entries point at
+// the type byte and keep the current sort key beside the pointer, so the
+// sort passes never touch the arena.
+typedef struct {
+    uint64_t key;
+    const char *record;
+} DirEntry;
+
+typedef struct {
+    const DirListOptions *options;
+    DirListStats *stats;
+    int with_meta;              // sorting by size or mtime: stat while reading
+    Arena arena;
+    DirEntry *entries;
+    size_t count;
+    size_t cap;
+    DirEntry *scratch;          // radix sort buffer
+    size_t scratch_cap;
+} DirListing;
+
+// Function to take len bytes from the arena, NULL if out of memory
+static char *arena_alloc(Arena *arena, size_t len) {
+    ArenaBlock *block = arena->head;
+    if (block == NULL || block->used + len > DIRLIST_ARENA_BLOCK) {
+        block = malloc(sizeof(ArenaBlock));
+        if (block == NULL) {
+            return NULL;
+        }
+        block->next = arena->head;
+        block->used = 0;
+        arena->head = block;
+        arena->bytes += sizeof(ArenaBlock);
+    }
+    char *data = block->data + block->used;
+    block->used += len;
+    return data;
+}
+
+// Function to free every block of the arena
+static void arena_free(Arena *arena) {
+    while (arena->head != NULL) {
+        ArenaBlock *next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    arena->bytes = 0;
+}
+
+static const char *record_name(const char *record) {
+    return record + 1;
+}
+
+// Function to note the memory held now (plus extra) if it is a new peak
+static void listing_track(DirListing *listing, size_t extra) {
+    size_t bytes = listing->arena.bytes + extra +
+                   (listing->cap + listing->scratch_cap) * sizeof(DirEntry);
+    if (bytes > listing->stats->peak_bytes) {
+        listing->stats->peak_bytes = bytes;
+    }
+}
+
+// Function to read an entry's size and mtime, -1 if it is gone
+static int dir_statx(int dfd, const char *name, DirMeta *meta, DirListStats *stats) {
+    struct statx stx;
+    stats->statx_calls++;
+    if (statx(dfd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STATX_SIZE | STATX_MTIME,
+              &stx) == -1) {
+        stats->errors++;
+        return -1;
+    }
+    meta->size = stx.stx_size;
+    meta->mtime_ns = (int64_t)stx.stx_mtime.tv_sec * 1000000000 + stx.stx_mtime.tv_nsec;
+    return 0;
+}
+
+// Function to copy an entry into the arena and append it, -1 if out of memory
+static int listing_add(DirListing *listing, const char *name, size_t name_len,
+                       unsigned char type, const DirMeta *meta) {
+    if (listing->count == listing->cap) {
+        size_t cap = listing->cap ? listing->cap * 2 : 4096;
+        DirEntry *entries = realloc(listing->entries, cap * sizeof(DirEntry));
+        if (entries == NULL) {
+            return -1;
+        }
+        listing->entries = entries;
+        listing->cap = cap;
+    }
+
+    size_t head = listing->with_meta ? sizeof(DirMeta) : 0;
+    char *record = arena_alloc(&listing->arena, head + name_len + 2);
+    if (record == NULL) {
+        return -1;
+    }
+    if (listing->with_meta) {
+        memcpy(record, meta, sizeof(DirMeta));
+        record += sizeof(DirMeta);
+    }
+    record[0] = type;
+    memcpy(record + 1, name, name_len + 1);
+
+    listing->entries[listing->count].key = 0;
+    listing->entries[listing->count].record = record;
+    listing->count++;
+    listing_track(listing, 0);
+    return 0;
+}
+
+// Function to sort entries by key, equal keys keeping their order: one
+// counting pass per key byte, least significant first, skipping the
+// bytes every key shares
+static void radix_sort(DirEntry *entries, DirEntry *scratch, size_t n) {
+    size_t counts[8][256];
+    if (n < 2) {
+        return;
+    }
+
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = entries[i].key;
+        for (int b = 0; b < 8; b++) {
+            counts[b][(key >> (8 * b)) & 0xff]++;
+        }
+    }
+
+    DirEntry *from = entries;
+    DirEntry *to = scratch;
+    for (int b = 0; b < 8; b++) {
+        size_t *count = counts[b];
+        if (count[(from[0].key >> (8 * b)) & 0xff] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int v = 0; v < 256; v++) {
+            size_t c = count[v];
+            count[v] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            to[count[(from[i].key >> (8 * b)) & 0xff]++] = from[i];
+        }
+        DirEntry *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != entries) {
+        memcpy(entries, from, n * sizeof(DirEntry));
+    }
+}
+
+// Function to get the 8 name bytes from depth on as a big-endian key,
+// zero-padded past the end of the name
+static uint64_t name_key(const char *name, size_t depth) {
+    uint64_t key = 0;
+    int ended = 0;
+    for (size_t i = 0; i < 8; i++) {
+        unsigned char c = ended ? 0 : (unsigned char)name[depth + i];
+        ended = c == 0;
+        key = key << 8 | c;
+    }
+    return key;
+}
+
+// Function to sort a short run of names that agree on their first depth bytes
+static void insertion_sort(DirEntry *entries, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; i++) {
+        DirEntry entry = entries[i];
+        const char *name = record_name(entry.record) + depth;
+        size_t j = i;
+        while (j > 0 && strcmp(record_name(entries[j - 1].record) + depth, name) > 0) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+}
+
+// Function to sort names that agree on their first depth bytes: radix
+// sort on the next 8, then each run still tied on them the same way.
+// Names in a directory are unique, so a tied run never ends inside its key.
+static void sort_names(DirEntry *entries, DirEntry *scratch, size_t n, size_t depth) {
+    if (n <= DIRLIST_SMALL_SORT) {
+        insertion_sort(entries, n, depth);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        entries[i].key = name_key(record_name(entries[i].record), depth);
+    }
+    radix_sort(entries, scratch, n);
+
+    for (size_t start = 0; start < n;) {
+        size_t end = start + 1;
+        while (end < n && entries[end].key == entries[start].key) {
+            end++;
+        }
+        if (end - start > 1) {
+            sort_names(entries + start, scratch, end - start, depth + 8);
+        }
+        start = end;
+    }
+}
+
+// Function to put the entries in the order asked for; size and mtime are
+// a stable pass over the name order, so ties stay sorted by name
+static int sort_entries(DirListing *listing) {
+    if (listing->scratch_cap < listing->count) {
+        free(listing->scratch);
+        listing->scratch = malloc(listing->count * sizeof(DirEntry));
+        listing->scratch_cap = listing->scratch != NULL ? listing->count : 0;
+        if (listing->scratch == NULL) {
+            return -1;
+        }
+        listing_track(listing, 0);
+    }
+
+    sort_names(listing->entries, listing->scratch, listing->count, 0);
+    if (!listing->with_meta) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < listing->count; i++) {
+        DirMeta meta;
+        memcpy(&meta, listing->entries[i].record - sizeof(DirMeta), sizeof(DirMeta));
+        // Largest and newest first: flip the bits so they sort lowest
+        if (listing->options->sort == DIRLIST_BY_SIZE) {
+            listing->entries[i].key = ~meta.size;
+        } else {
+            listing->entries[i].key = ~((uint64_t)meta.mtime_ns ^ (1ULL << 63));
+        }
+    }
+    radix_sort(listing->entries, listing->scratch, listing->count);
+    return 0;
+}
+
+// Function to keep only the first limit entries in sort order, moving
+// their records to a fresh arena so the memory of the rest comes back
+static int listing_trim(DirListing *listing) {
+    if (sort_entries(listing) == -1) {
+        return -1;
+    }
+
+    Arena kept = { NULL, 0 };
+    size_t head = listing->with_meta ? sizeof(DirMeta) : 0;
+    size_t limit = listing->options->limit;
+    for (size_t i = 0; i < limit; i++) {
+        const char *record = listing->entries[i].record;
+        size_t len = head + strlen(record_name(record)) + 2;
+        char *copy = arena_alloc(&kept, len);
+        if (copy == NULL) {
+            arena_free(&kept);
+            return -1;
+        }
+        memcpy(copy, record - head, len);
+        listing->entries[i].record = copy + head;
+    }
+
+    listing_track(listing, kept.bytes);
+    arena_free(&listing->arena);
+    listing->arena = kept;
+    listing->count = limit;
+    return 0;
+}
+
+// Function to format an unsigned number, returns its length
+static size_t put_number(char *buffer, unsigned long long value) {
+    char digits[32];
+    size_t len = 0;
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = digits[len - 1 - i];
+    }
+    return len;
+}
+
+// Function to format a number zero-padded to width digits
+static size_t put_padded(char *buffer, unsigned long value, size_t width) {
+    char digits[32];
+    size_t len = put_number(digits, value);
+    size_t used = 0;
+    while (used + len < width) {
+        buffer[used++] = '0';
+    }
+    memcpy(buffer + used, digits, len);
+    return used + len;
+}
+
+// Function to print one entry; with the long format and no metadata yet
+// it is stat'ed here, so a limited listing only stats what it prints
+static void print_entry(DirListing *listing, int dfd, const char *name, unsigned char type,
+                        const DirMeta *meta) {
+    const DirListOptions *options = listing->options;
+    char line[512];
+    size_t len = 0;
+    line[len++] = ' ';
+    line[len++] = ' ';
+
+    if (options->long_format) {
+        DirMeta own;
+        if (meta == NULL) {
+            if (dir_statx(dfd, name, &own, listing->stats) == -1) {
+                return;
+            }
+            meta = &own;
+        }
+
+        // "        4096  2026-10-19 14:03  "
+        char number[32];
+        size_t digits = put_number(number, meta->size);
+        while (digits < 12) {
+            line[len++] = ' ';
+            digits++;
+        }
+        len += put_number(line + len, meta->size);
+        line[len++] = ' ';
+        line[len++] = ' ';
+
+        time_t seconds = meta->mtime_ns / 1000000000;
+        struct tm tm;
+        if (localtime_r(&seconds, &tm) == NULL) {
+            memset(&tm, 0, sizeof(tm));
+        }
+        len += put_padded(line + len, tm.tm_year + 1900, 4);
+        line[len++] = '-';
+        len += put_padded(line + len, tm.tm_mon + 1, 2);
+        line[len++] = '-';
+        len += put_padded(line + len, tm.tm_mday, 2);
+        line[len++] = ' ';
+        len += put_padded(line + len, tm.tm_hour, 2);
+        line[len++] = ':';
+        len += put_padded(line + len, tm.tm_min, 2);
+        line[len++] = ' ';
+        line[len++] = ' ';
+    }
+
+    size_t name_len = strlen(name);
+    memcpy(line + len, name, name_len);
+    len += name_len;
+    if (type == DT_DIR && options->extension == NULL) {
+        line[len++] = '/';
+    }
+    line[len++] = '\n';
+    output_write(line, len);
+    listing->stats->printed++;
+}
+
+int dir_list(const char *dir, const DirListOptions *options, DirListStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    int dfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd == -1) {
+        return -1;
+    }
+    char *buffer = malloc(DIRLIST_DENTS_BUFFER);
+    if (buffer == NULL) {
+        close(dfd);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    DirListing listing;
+    memset(&listing, 0, sizeof(listing));
+    listing.options = options;
+    listing.stats = stats;
+    listing.with_meta = options->sort == DIRLIST_BY_SIZE || options->sort == DIRLIST_BY_MTIME;
+
+    // With a limit only the best entries so far are kept: every time twice
+    // the limit have piled up, the rest are dropped
+    size_t trim_at = (size_t)-1;
+    if (options->limit > 0 && options->limit < ((size_t)-1) / 4) {
+        trim_at = options->limit * 2 > DIRLIST_TRIM_MIN ? options->limit * 2 : DIRLIST_TRIM_MIN;
+    }
+
+    size_t ext_len = options->extension != NULL ? strlen(options->extension) : 0;
+    int failed = 0;
+    ssize_t n;
+    while (!failed && (n = getdents64(dfd, buffer, DIRLIST_DENTS_BUFFER)) != 0) {
+        if (n == -1) {
+            failed = 1;
+            break;
+        }
+        for (ssize_t pos = 0; pos < n && !failed;) {
+            struct dirent64 *entry = (struct dirent64 *)(buffer + pos);
+            pos += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            size_t name_len = strlen(name);
+            if (options->extension != NULL &&
+                (name_len <= ext_len ||
+                 memcmp(name + name_len - ext_len, options->extension, ext_len) != 0)) {
+                continue;
+            }
+            stats->entries++;
+
+            // Nothing to order: print as read up to the limit, then only
+            // count, so the summary has the whole directory
+            if (options->sort == DIRLIST_UNSORTED) {
+                if (options->limit == 0 || stats->printed < options->limit) {
+                    print_entry(&listing, dfd, name, entry->d_type, NULL);
+                }
+                continue;
+            }
+
+            DirMeta meta;
+            if (listing.with_meta && dir_statx(dfd, name, &meta, stats) == -1) {
+                continue;
+            }
+            if (listing_add(&listing, name, name_len, entry->d_type, &meta) == -1 ||
+                (listing.count >= trim_at && listing_trim(&listing) == -1)) {
+                errno = ENOMEM;
+                failed = 1;
+            }
+        }
+    }
+
+    if (!failed && options->sort != DIRLIST_UNSORTED) {
+        if (sort_entries(&listing) == -1) {
+            errno = ENOMEM;
+            failed = 1;
+        } else {
+            size_t count = listing.count;
+            if (options->limit > 0 && options->limit < count) {
+                count = options->limit;
+            }
+            for (size_t i = 0; i < count; i++) {
+                const char *record = listing.entries[i].record;
+                DirMeta meta;
+                if (listing.with_meta) {
+                    memcpy(&meta, record - sizeof(DirMeta), sizeof(DirMeta));
+                }
+                print_entry(&listing, dfd, record_name(record), (unsigned char)record[0],
+                            listing.with_meta ? &meta : NULL);
+            }
+        }
+    }
+
+    int saved = errno;
+    free(listing.entries);
+    free(listing.scratch);
+    arena_free(&listing.arena);
+    free(buffer);
+    close(dfd);
+    errno = saved;
+    return failed ? -1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef DIRLIST_H
+#define DIRLIST_H
+
+#include <stddef.h>
+
+typedef enum {
+    DIRLIST_UNSORTED,           // directory order, printed as it is read
+    DIRLIST_BY_NAME,            // byte order of the names
+    DIRLIST_BY_SIZE,            // largest first, ties in name order
+    DIRLIST_BY_MTIME            // newest first, ties in name order
+} DirListSort;
+
+typedef struct {
+    DirListSort sort;
+    int long_format;            // size and modification time before each name
+    unsigned long limit;        // print only the first N entries (0 = all)
+    const char *extension;      // only names ending in it (NULL = all)
+} DirListOptions;
+
+typedef struct {
+    unsigned long entries;      // entries read (that matched the extension)
+    unsigned long printed;
+    unsigned long statx_calls;
+    unsigned long errors;       // entries removed before they could be stat'ed
+    size_t peak_bytes;          // most memory held for names and sort arrays
+} DirListStats;
+
+// Function to print the entries of dir as "  name" lines through the
+// output buffer, directories with a trailing '/' unless an extension is
+// given. Names go into an arena and metadata is only read when the sort
+// or the long format needs it. Returns -1 (errno set) if dir cannot be
+// opened or memory runs out.
+int dir_list(const char *dir, const DirListOptions *options, DirListStats *stats);
+
+#endif
\ No newline at end of file
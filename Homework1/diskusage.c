@@ -0,0 +1,544 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "diskusage.h"
+#include "walker.h"
+
+#define DU_DENTS_BUFFER (256 * 1024)   // getdents64 buffer when re-reading
+#define DU_CACHE_MAGIC "fmducache 1\n"
+#define DU_UNREAD ((unsigned long)-1)  // own_files of a directory still to list
+
+// A growable array of directories
+typedef struct {
+    DuDir *items;
+    size_t count;
+    size_t cap;
+} DuList;
+
+// What one walker thread found: the directories it was handed and, for
+// every directory it read, one run with the totals of its entries
+typedef struct {
+    DuList dirs;
+    DuList runs;
+    size_t run_len;             // length of the last run's path
+    unsigned long statx_calls;
+    unsigned long errors;
+    char pad[64];               // keep workers off each other's cache lines
+} DuWorker;
+
+typedef struct {
+    DuWorker workers[WALK_MAX_THREADS];
+} DuScan;
+
+// Function to add a zeroed directory with a copy of path[0..len)
+static DuDir *list_push(DuList *list, const char *path, size_t len) {
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 256;
+        DuDir *items = realloc(list->items, cap * sizeof(DuDir));
+        if (items == NULL) {
+            return NULL;
+        }
+        list->items = items;
+        list->cap = cap;
+    }
+
+    DuDir *dir = &list->items[list->count];
+    memset(dir, 0, sizeof(*dir));
+    dir->path = malloc(len + 1);
+    if (dir->path == NULL) {
+        return NULL;
+    }
+    memcpy(dir->path, path, len);
+    dir->path[len] = '\0';
+    list->count++;
+    return dir;
+}
+
+static void list_free(DuList *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->items[i].path);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = list->cap = 0;
+}
+
+static int compare_dirs(const void *a, const void *b) {
+    return strcmp(((const DuDir *)a)->path, ((const DuDir *)b)->path);
+}
+
+static DuDir *find_dir(DuDir *dirs, size_t count, const char *path) {
+    DuDir key;
+    key.path = (char *)path;
+    return bsearch(&key, dirs, count, sizeof(DuDir), compare_dirs);
+}
+
+// Only what du needs: no owner, no times for files
+static int du_statx(int dfd, const char *name, unsigned int mask, struct statx *stx) {
+    return statx(dfd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, stx);
+}
+
+// Walker callback: directories become records (with their mtime for the
+// cache), everything else is added to the run of the directory holding it
+static int du_visit(int worker, int dfd, const char *path, size_t path_len,
+                    const char *name, unsigned char type, void *arg) {
+    DuWorker *self = &((DuScan *)arg)->workers[worker];
+    size_t name_len = strlen(name);
+    size_t dir_len = path_len > name_len ? path_len - name_len - 1 : 0;
+    struct statx stx;
+
+    if (type == DT_DIR) {
+        self->statx_calls++;
+        DuDir *dir = NULL;
+        if (du_statx(dfd, name, STATX_MTIME | STATX_SIZE | STATX_BLOCKS, &stx) == -1 ||
+            (dir = list_push(&self->dirs, path, path_len)) == NULL) {
+            self->errors++;
+            return 0;
+        }
+        dir->mtime_sec = stx.stx_mtime.tv_sec;
+        dir->mtime_nsec = stx.stx_mtime.tv_nsec;
+        dir->own_bytes = stx.stx_size;  // The directory itself, like du
+        dir->own_blocks = stx.stx_blocks;
+        return 1;
+    }
+    if (dir_len == 0 && strcmp(name, DU_CACHE_FILE) == 0) {
+        return 0;  // Changes every run, so it is not part of the tree
+    }
+
+    self->statx_calls++;
+    if (du_statx(dfd, name, STATX_SIZE | STATX_BLOCKS, &stx) == -1) {
+        self->errors++;
+        return 0;
+    }
+
+    // A directory is read by one worker in one go, so its entries arrive
+    // back to back: only the first one starts a run
+    DuList *runs = &self->runs;
+    DuDir *run = runs->count > 0 ? &runs->items[runs->count - 1] : NULL;
+    if (run == NULL || self->run_len != dir_len || memcmp(run->path, path, dir_len) != 0) {
+        run = list_push(runs, path, dir_len);
+        if (run == NULL) {
+            self->errors++;
+            return 0;
+        }
+        self->run_len = dir_len;
+    }
+    run->own_files++;
+    run->own_bytes += stx.stx_size;
+    run->own_blocks += stx.stx_blocks;
+    return 0;
+}
+
+// Function to list one directory: its entries are added to its own
+// totals and subdirectories that known does not hold are added to list,
+// unread
+static void read_dir(int root_fd, DuList *list, size_t index, DuDir *known, size_t known_count,
+                     DuResult *result, char *buffer) {
+    char path[WALK_PATH_MAX];
+    size_t base = strlen(list->items[index].path);
+    memcpy(path, list->items[index].path, base + 1);
+
+    int dfd = openat(root_fd, base ? path : ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (dfd == -1) {
+        result->errors++;
+        return;
+    }
+    result->dirs_read++;
+    if (base > 0) {
+        path[base++] = '/';
+    }
+
+    unsigned long files = 0, bytes = 0, blocks = 0;
+    ssize_t n;
+    while ((n = getdents64(dfd, buffer, DU_DENTS_BUFFER)) > 0) {
+        for (ssize_t pos = 0; pos < n;) {
+            struct dirent64 *entry = (struct dirent64 *)(buffer + pos);
+            pos += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            size_t name_len = strlen(name);
+            if ((name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) ||
+                (base == 0 && strcmp(name, DU_CACHE_FILE) == 0)) {
+                continue;
+            }
+            if (base + name_len >= WALK_PATH_MAX) {
+                result->errors++;
+                continue;
+            }
+            memcpy(path + base, name, name_len + 1);
+
+            struct statx stx;
+            result->statx_calls++;
+            if (du_statx(dfd, name, STATX_TYPE | STATX_MTIME | STATX_SIZE | STATX_BLOCKS, &stx) == -1) {
+                result->errors++;
+                continue;
+            }
+            if (!S_ISDIR(stx.stx_mode)) {
+                files++;
+                bytes += stx.stx_size;
+                blocks += stx.stx_blocks;
+            } else if (find_dir(known, known_count, path) == NULL) {
+                // New since the cache: read it (and all below it) later
+                DuDir *dir = list_push(list, path, base + name_len);
+                if (dir == NULL) {
+                    result->errors++;
+                    continue;
+                }
+                dir->mtime_sec = stx.stx_mtime.tv_sec;
+                dir->mtime_nsec = stx.stx_mtime.tv_nsec;
+                dir->own_files = DU_UNREAD;
+                dir->own_bytes = stx.stx_size;
+                dir->own_blocks = stx.stx_blocks;
+            }
+        }
+    }
+    if (n == -1) {
+        result->errors++;
+    }
+    close(dfd);
+
+    DuDir *dir = &list->items[index];
+    dir->own_files += files;
+    dir->own_bytes += bytes;
+    dir->own_blocks += blocks;
+}
+
+// Function to load the cache: directories sorted by path with their
+// mtime and own totals. Returns 0, or -1 if there is no usable cache.
+static int cache_load(int fd, DuList *list) {
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= (off_t)strlen(DU_CACHE_MAGIC)) {
+        return -1;
+    }
+    char *data = malloc(st.st_size + 1);
+    if (data == NULL) {
+        return -1;
+    }
+    ssize_t n = pread(fd, data, st.st_size, 0);
+    if (n != st.st_size || memcmp(data, DU_CACHE_MAGIC, strlen(DU_CACHE_MAGIC)) != 0) {
+        free(data);
+        return -1;
+    }
+    data[n] = '\0';
+
+    // "mtime_sec<TAB>mtime_nsec<TAB>files<TAB>bytes<TAB>blocks<TAB>path\n"
+    char *line = data + strlen(DU_CACHE_MAGIC);
+    while (*line != '\0') {
+        char *end = strchr(line, '\n');
+        if (end == NULL) {
+            break;  // A torn last line: ignore it
+        }
+        *end = '\0';
+
+        char *field = line;
+        long long sec = strtoll(field, &field, 10);
+        long nsec = strtol(field, &field, 10);
+        unsigned long files = strtoul(field, &field, 10);
+        unsigned long bytes = strtoul(field, &field, 10);
+        unsigned long blocks = strtoul(field, &field, 10);
+        if (*field != '\t') {
+            list_free(list);
+            free(data);
+            return -1;
+        }
+        field++;
+
+        DuDir *dir = list_push(list, field, end - field);
+        if (dir == NULL) {
+            list_free(list);
+            free(data);
+            return -1;
+        }
+        dir->mtime_sec = sec;
+        dir->mtime_nsec = nsec;
+        dir->own_files = files;
+        dir->own_bytes = bytes;
+        dir->own_blocks = blocks;
+        line = end + 1;
+    }
+    free(data);
+
+    qsort(list->items, list->count, sizeof(DuDir), compare_dirs);
+    return list->count > 0 && list->items[0].path[0] == '\0' ? 0 : -1;
+}
+
+// Function to format an unsigned number, returns its length
+static size_t put_number(char *buffer, unsigned long long value) {
+    char digits[32];
+    size_t len = 0;
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (size_t i = 0; i < len; i++) {
+        buffer[i] = digits[len - 1 - i];
+    }
+    return len;
+}
+
+// Function to rewrite the cache in place: truncating and writing an
+// existing file leaves the root's mtime alone
+static int cache_write(int fd, const DuDir *dirs, size_t count) {
+    size_t cap = 1 << 20;
+    size_t used = 0;
+    char *buffer = malloc(cap);
+    if (buffer == NULL) {
+        return -1;
+    }
+    memcpy(buffer, DU_CACHE_MAGIC, strlen(DU_CACHE_MAGIC));
+    used = strlen(DU_CACHE_MAGIC);
+
+    for (size_t i = 0; i < count; i++) {
+        const DuDir *dir = &dirs[i];
+        size_t path_len = strlen(dir->path);
+        if (strpbrk(dir->path, "\t\n") != NULL) {
+            free(buffer);
+            return -1;  // Could not be read back: no cache rather than a wrong one
+        }
+        if (used + path_len + 128 > cap) {
+            char *grown = realloc(buffer, cap * 2 + path_len);
+            if (grown == NULL) {
+                free(buffer);
+                return -1;
+            }
+            buffer = grown;
+            cap = cap * 2 + path_len;
+        }
+        used += put_number(buffer + used, dir->mtime_sec);
+        buffer[used++] = '\t';
+        used += put_number(buffer + used, dir->mtime_nsec);
+        buffer[used++] = '\t';
+        used += put_number(buffer + used, dir->own_files);
+        buffer[used++] = '\t';
+        used += put_number(buffer + used, dir->own_bytes);
+        buffer[used++] = '\t';
+        used += put_number(buffer + used, dir->own_blocks);
+        buffer[used++] = '\t';
+        memcpy(buffer + used, dir->path, path_len);
+        used += path_len;
+        buffer[used++] = '\n';
+    }
+
+    int result = 0;
+    flock(fd, LOCK_EX);
+    if (ftruncate(fd, 0) == -1) {
+        result = -1;
+    }
+    for (size_t done = 0; result == 0 && done < used;) {
+        ssize_t n = pwrite(fd, buffer + done, used - done, done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            result = -1;
+            break;
+        }
+        done += n;
+    }
+    flock(fd, LOCK_UN);
+    free(buffer);
+    return result;
+}
+
+// Function to check the cached directories against the tree: unchanged
+// ones keep their totals, changed ones are listed again, removed ones are
+// dropped and new ones read in full
+static int cache_refresh(int root_fd, DuList *cached, DuList *out, DuResult *result) {
+    char *buffer = malloc(DU_DENTS_BUFFER);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < cached->count; i++) {
+        DuDir *dir = &cached->items[i];
+        struct statx stx;
+        result->statx_calls++;
+        if (du_statx(root_fd, dir->path[0] ? dir->path : ".",
+                     STATX_TYPE | STATX_MTIME | STATX_SIZE | STATX_BLOCKS, &stx) == -1 ||
+            !S_ISDIR(stx.stx_mode)) {
+            continue;  // Gone (or no longer a directory)
+        }
+
+        DuDir *copy = list_push(out, dir->path, strlen(dir->path));
+        if (copy == NULL) {
+            free(buffer);
+            return -1;
+        }
+        copy->mtime_sec = stx.stx_mtime.tv_sec;
+        copy->mtime_nsec = stx.stx_mtime.tv_nsec;
+        if (stx.stx_mtime.tv_sec == dir->mtime_sec && (long)stx.stx_mtime.tv_nsec == dir->mtime_nsec) {
+            copy->own_files = dir->own_files;
+            copy->own_bytes = dir->own_bytes;
+            copy->own_blocks = dir->own_blocks;
+            result->dirs_cached++;
+        } else {
+            copy->own_bytes = stx.stx_size;
+            copy->own_blocks = stx.stx_blocks;
+            read_dir(root_fd, out, out->count - 1, cached->items, cached->count, result, buffer);
+        }
+    }
+
+    // Directories the cache did not know; listing them may find more
+    for (size_t i = 0; i < out->count; i++) {
+        if (out->items[i].own_files == DU_UNREAD) {
+            out->items[i].own_files = 0;
+            read_dir(root_fd, out, i, cached->items, cached->count, result, buffer);
+        }
+    }
+
+    free(buffer);
+    return 0;
+}
+
+// Function to sort the directories and add every subtree into its parent
+// (descendants sort after their ancestors, so walk backwards)
+static void aggregate(DuDir *dirs, size_t count) {
+    qsort(dirs, count, sizeof(DuDir), compare_dirs);
+    for (size_t i = 0; i < count; i++) {
+        dirs[i].files += dirs[i].own_files;
+        dirs[i].bytes += dirs[i].own_bytes;
+        dirs[i].blocks += dirs[i].own_blocks;
+    }
+
+    for (size_t i = count; i-- > 1;) {
+        DuDir *dir = &dirs[i];
+        char *slash = strrchr(dir->path, '/');
+        DuDir *parent;
+        if (slash != NULL) {
+            *slash = '\0';
+            parent = find_dir(dirs, i, dir->path);
+            *slash = '/';
+        } else {
+            parent = &dirs[0];  // The root sorts first: ""
+        }
+        if (parent != NULL) {
+            parent->files += dir->files;
+            parent->dirs += dir->dirs + 1;
+            parent->bytes += dir->bytes;
+            parent->blocks += dir->blocks;
+        }
+    }
+}
+
+// Function to total every directory under root
+int du_scan(const char *root, int threads, int use_cache, DuResult *result) {
+    memset(result, 0, sizeof(*result));
+
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd == -1) {
+        return -1;
+    }
+
+    // Opened (or created) before anything is looked at, so the root's
+    // mtime we record already includes the cache file itself
+    int cache_fd = -1;
+    if (use_cache) {
+        cache_fd = openat(root_fd, DU_CACHE_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    }
+
+    struct statx root_stx;
+    if (du_statx(root_fd, ".", STATX_MTIME | STATX_SIZE | STATX_BLOCKS, &root_stx) == -1) {
+        if (cache_fd != -1) {
+            close(cache_fd);
+        }
+        close(root_fd);
+        return -1;
+    }
+
+    DuList cached = { NULL, 0, 0 };
+    DuList all = { NULL, 0, 0 };
+    int status = 0;
+
+    if (cache_fd != -1 && cache_load(cache_fd, &cached) == 0) {
+        // Mostly a statx per directory; only changed ones are listed
+        result->threads = 1;
+        status = cache_refresh(root_fd, &cached, &all, result);
+        list_free(&cached);
+    } else {
+        DuScan *scan = calloc(1, sizeof(DuScan));
+        DuDir *top = scan ? list_push(&all, "", 0) : NULL;
+        if (top == NULL) {
+            free(scan);
+            status = -1;
+        } else {
+            top->mtime_sec = root_stx.stx_mtime.tv_sec;
+            top->mtime_nsec = root_stx.stx_mtime.tv_nsec;
+            top->own_bytes = root_stx.stx_size;
+            top->own_blocks = root_stx.stx_blocks;
+
+            WalkOptions options = { threads, du_visit, scan, NULL };
+            WalkStats stats;
+            status = walk_tree(root, &options, &stats);
+            result->threads = stats.threads;
+            result->dirs_read = stats.dirs;
+            result->errors = stats.errors;
+
+            // Gather the directories, then add each run to its directory
+            for (int w = 0; w < WALK_MAX_THREADS && status == 0; w++) {
+                DuWorker *worker = &scan->workers[w];
+                for (size_t i = 0; i < worker->dirs.count; i++) {
+                    DuDir *dir = list_push(&all, "", 0);
+                    if (dir == NULL) {
+                        status = -1;
+                        break;
+                    }
+                    free(dir->path);
+                    *dir = worker->dirs.items[i];
+                    worker->dirs.items[i].path = NULL;
+                }
+                result->statx_calls += worker->statx_calls;
+                result->errors += worker->errors;
+            }
+            qsort(all.items, all.count, sizeof(DuDir), compare_dirs);
+            for (int w = 0; w < WALK_MAX_THREADS; w++) {
+                DuWorker *worker = &scan->workers[w];
+                for (size_t i = 0; status == 0 && i < worker->runs.count; i++) {
+                    DuDir *run = &worker->runs.items[i];
+                    DuDir *dir = find_dir(all.items, all.count, run->path);
+                    if (dir != NULL) {
+                        dir->own_files += run->own_files;
+                        dir->own_bytes += run->own_bytes;
+                        dir->own_blocks += run->own_blocks;
+                    }
+                }
+                list_free(&worker->dirs);
+                list_free(&worker->runs);
+            }
+            free(scan);
+        }
+    }
+
+    if (status == 0 && cache_fd != -1) {
+        // The cache is kept sorted by path
+        qsort(all.items, all.count, sizeof(DuDir), compare_dirs);
+        cache_write(cache_fd, all.items, all.count);
+    }
+    if (cache_fd != -1) {
+        close(cache_fd);
+    }
+    close(root_fd);
+
+    if (status == -1) {
+        list_free(&all);
+        return -1;
+    }
+    aggregate(all.items, all.count);
+    result->dirs = all.items;
+    result->count = all.count;
+    return 0;
+}
+
+// Function to free what du_scan returned
+void du_free(DuResult *result) {
+    DuList list = { result->dirs, result->count, result->count };
+    list_free(&list);
+    result->dirs = NULL;
+    result->count = 0;
+}
\ No newline at end of file
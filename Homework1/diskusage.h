@@ -0,0 +1,41 @@
+#ifndef DISKUSAGE_H
+#define DISKUSAGE_H
+
+#include <stddef.h>
+
+// Cache of a tree's per-directory totals, kept in the tree itself
+#define DU_CACHE_FILE ".fmducache"
+
+// One directory of the tree
+typedef struct {
+    char *path;                 // relative to the root, "" for the root
+    long long mtime_sec;        // when its entries last changed
+    long mtime_nsec;
+    unsigned long own_files;    // non-directories directly inside it
+    unsigned long own_bytes;
+    unsigned long own_blocks;
+    unsigned long files;        // non-directories in the whole subtree
+    unsigned long dirs;         // directories below it
+    unsigned long bytes;        // apparent size (st_size)
+    unsigned long blocks;       // allocated 512-byte blocks
+} DuDir;
+
+typedef struct {
+    DuDir *dirs;                // sorted by path, the root first
+    size_t count;
+    unsigned long statx_calls;
+    unsigned long dirs_read;    // directories listed with getdents64
+    unsigned long dirs_cached;  // directories taken unchanged from the cache
+    unsigned long errors;       // entries or directories that could not be read
+    int threads;
+} DuResult;
+
+// Function to total every directory under root with a pool of walker
+// threads; with use_cache, unchanged directories come from DU_CACHE_FILE
+// and the cache is rewritten afterwards
+int du_scan(const char *root, int threads, int use_cache, DuResult *result);
+
+// Function to free what du_scan returned
+void du_free(DuResult *result);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,927 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "extindex.h"
+#include "output.h"
+#include "walker.h"
+
+/*
+ * Index file layout (text, one record per line, fields split by tabs):
+ *
+ *   fileManager-index 1
+ *   pid <watcher pid, 0 when nobody keeps it current>
+ *   D <mtime sec> <mtime nsec> <directory>      one per directory, "." is the root
+ *   F <extension> <path>                        sorted by extension, then path
+ *
+ * An index is trusted only while every directory still has the mtime
+ * recorded for it; adding, removing or renaming an entry changes the mtime
+ * of the directory holding it. The mtime is taken before the directory is
+ * read (or, for a watcher, when an event for it arrives), so a change the
+ * scan missed always leaves the directory newer than its record. A watcher
+ * rewrites the index shortly after changes, so the check holds even while
+ * one runs. The file is created before the root is stat'ed and rewritten
+ * in place under flock() so the root's mtime never moves because of the
+ * index itself.
+ *
+ * A watcher keeps INDEX_LOCK_FILE flock()ed for as long as it runs; the
+ * lock goes away with the process, however it dies, so a reused pid is
+ * never taken for a live watcher.
+ */
+
+#define INDEX_MAGIC "fileManager-index 1\n"
+#define INDEX_WRITE_BUFFER (1024 * 1024)
+#define INDEX_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                          IN_EXCL_UNLINK | IN_ONLYDIR | IN_DONT_FOLLOW)
+#define INDEX_QUIET_MS 500          // write once events pause this long
+#define INDEX_MAX_DELAY 2.0         // or at least this often while busy
+
+// Open-addressing set of relative paths (the strings are owned)
+typedef struct {
+    char **slots;
+    struct timespec *stamps;    // mtime per slot, only when stamped
+    size_t cap;
+    size_t used;    // live + removed
+    size_t live;
+    int stamped;    // the directory set keeps an mtime for each path
+} PathSet;
+
+typedef struct {
+    char *root;             // as given on the command line
+    int root_fd;
+    PathSet files;          // files that have an extension
+    PathSet dirs;           // "" is the root
+    int inotify_fd;         // -1 when not watching
+    char **watches;         // wd -> directory
+    size_t watch_cap;
+    pthread_mutex_t watch_lock;
+    atomic_ulong skipped;
+    int live;               // cleared when a watch could not be added
+} Index;
+
+static char removed_slot[1];
+#define REMOVED removed_slot
+
+static volatile sig_atomic_t watch_stop = 0;
+
+static uint64_t hash_path(const char *path) {
+    uint64_t hash = 14695981039346656037ULL;
+    while (*path) {
+        hash = (hash ^ (unsigned char)*path++) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int set_resize(PathSet *set, size_t cap) {
+    char **slots = calloc(cap, sizeof(char *));
+    struct timespec *stamps = set->stamped ? calloc(cap, sizeof(struct timespec)) : NULL;
+    if (slots == NULL || (set->stamped && stamps == NULL)) {
+        free(slots);
+        free(stamps);
+        return -1;
+    }
+    for (size_t i = 0; i < set->cap; i++) {
+        char *path = set->slots[i];
+        if (path != NULL && path != REMOVED) {
+            size_t at = hash_path(path) & (cap - 1);
+            while (slots[at] != NULL) {
+                at = (at + 1) & (cap - 1);
+            }
+            slots[at] = path;
+            if (stamps != NULL) {
+                stamps[at] = set->stamps[i];
+            }
+        }
+    }
+    free(set->slots);
+    free(set->stamps);
+    set->slots = slots;
+    set->stamps = stamps;
+    set->cap = cap;
+    set->used = set->live;
+    return 0;
+}
+
+// Takes ownership of path, which is freed if it was already there; a
+// stamped set records mtime for it either way
+static void set_insert(PathSet *set, char *path, const struct timespec *mtime) {
+    if ((set->used + 1) * 4 > set->cap * 3) {
+        size_t cap = set->cap ? set->cap : 1024;
+        while ((set->live + 1) * 2 > cap) {
+            cap *= 2;
+        }
+        if (set_resize(set, cap) == -1) {
+            free(path);
+            return;
+        }
+    }
+
+    size_t at = hash_path(path) & (set->cap - 1);
+    size_t reuse = SIZE_MAX;
+    while (set->slots[at] != NULL) {
+        if (set->slots[at] == REMOVED) {
+            if (reuse == SIZE_MAX) {
+                reuse = at;
+            }
+        } else if (strcmp(set->slots[at], path) == 0) {
+            if (set->stamped) {
+                set->stamps[at] = *mtime;
+            }
+            free(path);
+            return;
+        }
+        at = (at + 1) & (set->cap - 1);
+    }
+    if (reuse != SIZE_MAX) {
+        at = reuse;
+    } else {
+        set->used++;
+    }
+    set->slots[at] = path;
+    if (set->stamped) {
+        set->stamps[at] = *mtime;
+    }
+    set->live++;
+}
+
+static void set_remove(PathSet *set, const char *path) {
+    if (set->cap == 0) {
+        return;
+    }
+    size_t at = hash_path(path) & (set->cap - 1);
+    while (set->slots[at] != NULL) {
+        if (set->slots[at] != REMOVED && strcmp(set->slots[at], path) == 0) {
+            free(set->slots[at]);
+            set->slots[at] = REMOVED;
+            set->live--;
+            return;
+        }
+        at = (at + 1) & (set->cap - 1);
+    }
+}
+
+// Is path the directory `dir` or somewhere below it ("" is the root)
+static int path_within(const char *path, const char *dir, size_t dir_len) {
+    return dir_len == 0 ||
+           (strncmp(path, dir, dir_len) == 0 && (path[dir_len] == '\0' || path[dir_len] == '/'));
+}
+
+// Remove a directory's whole subtree (a full pass, only on directory moves)
+static void set_remove_tree(PathSet *set, const char *dir) {
+    size_t dir_len = strlen(dir);
+    for (size_t i = 0; i < set->cap; i++) {
+        char *path = set->slots[i];
+        if (path != NULL && path != REMOVED && path_within(path, dir, dir_len)) {
+            free(path);
+            set->slots[i] = REMOVED;
+            set->live--;
+        }
+    }
+}
+
+static void set_free(PathSet *set) {
+    for (size_t i = 0; i < set->cap; i++) {
+        if (set->slots[i] != NULL && set->slots[i] != REMOVED) {
+            free(set->slots[i]);
+        }
+    }
+    free(set->slots);
+    free(set->stamps);
+    int stamped = set->stamped;
+    memset(set, 0, sizeof(*set));
+    set->stamped = stamped;
+}
+
+// Directory mtime for the index, taken before the directory is read; a
+// failed stat records 0, which never matches, so the index reads as stale
+static void dir_mtime(int dfd, const char *name, struct timespec *mtime) {
+    struct statx stx;
+    if (statx(dfd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STATX_MTIME, &stx) == -1) {
+        mtime->tv_sec = 0;
+        mtime->tv_nsec = 0;
+        return;
+    }
+    mtime->tv_sec = stx.stx_mtime.tv_sec;
+    mtime->tv_nsec = stx.stx_mtime.tv_nsec;
+}
+
+// Extension of the last path component, NULL if it has none
+static const char *path_extension(const char *path) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    const char *dot = strrchr(name, '.');
+    return dot != NULL && dot != name ? dot : NULL;
+}
+
+// Watch one directory of the tree and remember which it is
+static void index_add_watch(Index *index, const char *dir) {
+    char full[WALK_PATH_MAX * 2];
+    strcpy(full, index->root);
+    if (dir[0]) {
+        strcat(full, "/");
+        strcat(full, dir);
+    }
+
+    int wd = inotify_add_watch(index->inotify_fd, full, INDEX_WATCH_MASK);
+    pthread_mutex_lock(&index->watch_lock);
+    if (wd == -1) {
+        index->live = 0;  // e.g. fs.inotify.max_user_watches reached
+    } else {
+        if ((size_t)wd >= index->watch_cap) {
+            size_t cap = index->watch_cap ? index->watch_cap : 1024;
+            while ((size_t)wd >= cap) {
+                cap *= 2;
+            }
+            char **watches = realloc(index->watches, cap * sizeof(char *));
+            if (watches != NULL) {
+                memset(watches + index->watch_cap, 0, (cap - index->watch_cap) * sizeof(char *));
+                index->watches = watches;
+                index->watch_cap = cap;
+            }
+        }
+        if ((size_t)wd < index->watch_cap) {
+            free(index->watches[wd]);
+            index->watches[wd] = strdup(dir);
+        }
+    }
+    pthread_mutex_unlock(&index->watch_lock);
+}
+
+// Drop the watches of a directory that left (or moved inside) the tree
+static void index_drop_watches(Index *index, const char *dir) {
+    size_t dir_len = strlen(dir);
+    for (size_t wd = 0; wd < index->watch_cap; wd++) {
+        if (index->watches[wd] != NULL && path_within(index->watches[wd], dir, dir_len)) {
+            inotify_rm_watch(index->inotify_fd, wd);
+            free(index->watches[wd]);
+            index->watches[wd] = NULL;
+        }
+    }
+}
+
+// Paths found by one walker thread
+typedef struct {
+    char **items;
+    struct timespec *stamps;    // directory lists only
+    size_t used;
+    size_t cap;
+} PathList;
+
+typedef struct {
+    Index *index;
+    const char *prefix;     // subtree being scanned, "" for the whole tree
+    size_t prefix_len;
+    PathList files[WALK_MAX_THREADS];
+    PathList dirs[WALK_MAX_THREADS];
+} IndexScan;
+
+// mtime is NULL for the file lists
+static void list_push(PathList *list, char *path, const struct timespec *mtime) {
+    if (list->used == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 4096;
+        char **items = realloc(list->items, cap * sizeof(char *));
+        if (items != NULL) {
+            list->items = items;
+        }
+        if (items != NULL && mtime != NULL) {
+            struct timespec *stamps = realloc(list->stamps, cap * sizeof(struct timespec));
+            if (stamps == NULL) {
+                items = NULL;
+            } else {
+                list->stamps = stamps;
+            }
+        }
+        if (items == NULL) {
+            free(path);
+            return;
+        }
+        list->cap = cap;
+    }
+    if (mtime != NULL) {
+        list->stamps[list->used] = *mtime;
+    }
+    list->items[list->used++] = path;
+}
+
+// Walker callback: collect directories and files with an extension
+static int index_visit(int worker, int dfd, const char *path, size_t path_len,
+                       const char *name, unsigned char type, void *arg) {
+    IndexScan *scan = arg;
+
+    if (scan->prefix_len == 0 &&
+        (strcmp(path, INDEX_FILE) == 0 || strcmp(path, INDEX_LOCK_FILE) == 0)) {
+        return 0;
+    }
+    if (strpbrk(name, "\t\n") != NULL) {
+        atomic_fetch_add(&scan->index->skipped, 1);  // Can't go on an index line
+        return 0;
+    }
+    if (type != DT_DIR && path_extension(name) == NULL) {
+        return 0;
+    }
+
+    char *full = malloc(scan->prefix_len + path_len + 2);
+    if (full == NULL) {
+        return 0;
+    }
+    memcpy(full, scan->prefix, scan->prefix_len);
+    if (scan->prefix_len > 0) {
+        full[scan->prefix_len] = '/';
+        memcpy(full + scan->prefix_len + 1, path, path_len + 1);
+    } else {
+        memcpy(full, path, path_len + 1);
+    }
+
+    if (type == DT_DIR) {
+        // Watch before the walker reads it so no entry slips between
+        if (scan->index->inotify_fd != -1) {
+            index_add_watch(scan->index, full);
+        }
+        struct timespec mtime;
+        dir_mtime(dfd, name, &mtime);
+        list_push(&scan->dirs[worker], full, &mtime);
+        return 1;
+    }
+    list_push(&scan->files[worker], full, NULL);
+    return 0;
+}
+
+// Scan a directory of the tree ("" for all of it) into the sets
+static int index_scan(Index *index, const char *dir, int threads) {
+    IndexScan scan;  // Not static: serve may run two scans at once
+    memset(&scan, 0, sizeof(scan));
+    scan.index = index;
+    scan.prefix = dir;
+    scan.prefix_len = strlen(dir);
+
+    char root[WALK_PATH_MAX * 2];
+    strcpy(root, index->root);
+    if (dir[0]) {
+        strcat(root, "/");
+        strcat(root, dir);
+    }
+
+    if (index->inotify_fd != -1) {
+        index_add_watch(index, dir);
+    }
+    struct timespec mtime;
+    dir_mtime(index->root_fd, dir[0] ? dir : ".", &mtime);
+    set_insert(&index->dirs, strdup(dir), &mtime);
+
+    WalkOptions options = { threads, index_visit, &scan, NULL };
+    int result = walk_tree(root, &options, NULL);
+
+    for (int i = 0; i < WALK_MAX_THREADS; i++) {
+        for (size_t j = 0; j < scan.files[i].used; j++) {
+            set_insert(&index->files, scan.files[i].items[j], NULL);
+        }
+        for (size_t j = 0; j < scan.dirs[i].used; j++) {
+            set_insert(&index->dirs, scan.dirs[i].items[j], &scan.dirs[i].stamps[j]);
+        }
+        free(scan.files[i].items);
+        free(scan.dirs[i].items);
+        free(scan.dirs[i].stamps);
+    }
+    return result;
+}
+
+// A directory line of the index
+typedef struct {
+    const char *path;
+    struct timespec mtime;
+} IndexedDir;
+
+static int compare_dirs(const void *a, const void *b) {
+    return strcmp(((const IndexedDir *)a)->path, ((const IndexedDir *)b)->path);
+}
+
+// A file with its extension found once, not on every comparison
+typedef struct {
+    const char *ext;
+    const char *path;
+} IndexedFile;
+
+static int compare_files(const void *a, const void *b) {
+    const IndexedFile *x = a;
+    const IndexedFile *y = b;
+    int order = strcmp(x->ext, y->ext);
+    return order != 0 ? order : strcmp(x->path, y->path);
+}
+
+// Buffered writes into the index file
+typedef struct {
+    int fd;
+    char *data;
+    size_t used;
+    int failed;
+} IndexWriter;
+
+static void writer_flush(IndexWriter *writer) {
+    size_t done = 0;
+    while (done < writer->used && !writer->failed) {
+        ssize_t n = write(writer->fd, writer->data + done, writer->used - done);
+        if (n == -1 && errno != EINTR) {
+            writer->failed = 1;
+        } else if (n > 0) {
+            done += n;
+        }
+    }
+    writer->used = 0;
+}
+
+static void writer_put(IndexWriter *writer, const char *text, size_t len) {
+    if (writer->used + len > INDEX_WRITE_BUFFER) {
+        writer_flush(writer);
+    }
+    if (len > INDEX_WRITE_BUFFER) {
+        return;
+    }
+    memcpy(writer->data + writer->used, text, len);
+    writer->used += len;
+}
+
+static void writer_string(IndexWriter *writer, const char *text) {
+    writer_put(writer, text, strlen(text));
+}
+
+static void writer_number(IndexWriter *writer, unsigned long value) {
+    char digits[32];
+    int len = 0;
+    char out[32];
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (int i = 0; i < len; i++) {
+        out[i] = digits[len - 1 - i];
+    }
+    writer_put(writer, out, len);
+}
+
+// Collect the indexed directories with their mtimes, sorted
+static IndexedDir *dirs_sorted(PathSet *set) {
+    IndexedDir *items = malloc((set->live ? set->live : 1) * sizeof(IndexedDir));
+    if (items == NULL) {
+        return NULL;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < set->cap; i++) {
+        if (set->slots[i] != NULL && set->slots[i] != REMOVED) {
+            items[n].path = set->slots[i];
+            items[n].mtime = set->stamps[i];
+            n++;
+        }
+    }
+    qsort(items, n, sizeof(IndexedDir), compare_dirs);
+    return items;
+}
+
+// Collect the indexed files, sorted by extension and path
+static IndexedFile *files_sorted(PathSet *set) {
+    IndexedFile *items = malloc((set->live ? set->live : 1) * sizeof(IndexedFile));
+    if (items == NULL) {
+        return NULL;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < set->cap; i++) {
+        if (set->slots[i] != NULL && set->slots[i] != REMOVED) {
+            items[n].path = set->slots[i];
+            items[n].ext = path_extension(set->slots[i]);
+            n++;
+        }
+    }
+    qsort(items, n, sizeof(IndexedFile), compare_files);
+    return items;
+}
+
+// Rewrite the index file from the sets; pid 0 marks it as not watched
+static int index_write(Index *index, pid_t pid) {
+    int fd = openat(index->root_fd, INDEX_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    flock(fd, LOCK_EX);
+
+    IndexedDir *dirs = dirs_sorted(&index->dirs);
+    IndexedFile *files = files_sorted(&index->files);
+    IndexWriter writer = { fd, malloc(INDEX_WRITE_BUFFER), 0, 0 };
+    if (dirs == NULL || files == NULL || writer.data == NULL || ftruncate(fd, 0) == -1) {
+        free(dirs);
+        free(files);
+        free(writer.data);
+        close(fd);
+        return -1;
+    }
+
+    writer_string(&writer, INDEX_MAGIC);
+    writer_string(&writer, "pid\t");
+    writer_number(&writer, pid);
+    writer_string(&writer, "\n");
+
+    // The mtimes recorded when each directory was read, not current ones:
+    // a directory that changed since then must read as stale
+    for (size_t i = 0; i < index->dirs.live; i++) {
+        writer_string(&writer, "D\t");
+        writer_number(&writer, dirs[i].mtime.tv_sec);
+        writer_string(&writer, "\t");
+        writer_number(&writer, dirs[i].mtime.tv_nsec);
+        writer_string(&writer, "\t");
+        writer_string(&writer, dirs[i].path[0] ? dirs[i].path : ".");
+        writer_string(&writer, "\n");
+    }
+
+    for (size_t i = 0; i < index->files.live; i++) {
+        writer_string(&writer, "F\t");
+        writer_string(&writer, files[i].ext);
+        writer_string(&writer, "\t");
+        writer_string(&writer, files[i].path);
+        writer_string(&writer, "\n");
+    }
+    writer_flush(&writer);
+
+    int failed = writer.failed;
+    free(dirs);
+    free(files);
+    free(writer.data);
+    flock(fd, LOCK_UN);
+    close(fd);
+    return failed ? -1 : 0;
+}
+
+static int index_open(Index *index, const char *dir_name, int watch) {
+    memset(index, 0, sizeof(*index));
+    index->root = strdup(dir_name);
+    index->root_fd = open(dir_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    index->inotify_fd = -1;
+    index->live = 1;
+    index->dirs.stamped = 1;
+    pthread_mutex_init(&index->watch_lock, NULL);
+    if (index->root == NULL || index->root_fd == -1) {
+        free(index->root);
+        return -1;
+    }
+
+    // Created before the root's mtime is taken, so it does not count as a change
+    int fd = openat(index->root_fd, INDEX_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd != -1) {
+        close(fd);
+    }
+    if (watch) {
+        index->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (index->inotify_fd == -1) {
+            close(index->root_fd);
+            free(index->root);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void index_close(Index *index, IndexStats *stats) {
+    if (stats != NULL) {
+        stats->files = index->files.live;
+        stats->dirs = index->dirs.live;
+        stats->skipped = atomic_load(&index->skipped);
+        stats->live = index->live;
+    }
+    set_free(&index->files);
+    set_free(&index->dirs);
+    for (size_t wd = 0; wd < index->watch_cap; wd++) {
+        free(index->watches[wd]);
+    }
+    free(index->watches);
+    if (index->inotify_fd != -1) {
+        close(index->inotify_fd);
+    }
+    pthread_mutex_destroy(&index->watch_lock);
+    close(index->root_fd);
+    free(index->root);
+}
+
+// Function to scan dir_name and (re)write its index file
+int index_build(const char *dir_name, int threads, IndexStats *stats) {
+    Index index;
+    if (index_open(&index, dir_name, 0) == -1) {
+        return -1;
+    }
+    int result = index_scan(&index, "", threads);
+    if (result == 0) {
+        result = index_write(&index, 0);
+    }
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(*stats));
+    }
+    index_close(&index, stats);
+    return result;
+}
+
+// Compare an "F\t<ext>\t..." line's extension with key (strcmp order)
+static int compare_line_extension(const char *line, const char *end, const char *key, size_t key_len) {
+    const char *ext = line + 2;
+    const char *stop = memchr(ext, '\t', end - ext);
+    size_t len = stop ? (size_t)(stop - ext) : (size_t)(end - ext);
+    int order = memcmp(ext, key, len < key_len ? len : key_len);
+    if (order != 0) {
+        return order;
+    }
+    return len < key_len ? -1 : len > key_len ? 1 : 0;
+}
+
+// Next line start after p (or end)
+static const char *next_line(const char *p, const char *end) {
+    const char *newline = memchr(p, '\n', end - p);
+    return newline ? newline + 1 : end;
+}
+
+// Function to tell whether a watcher holds the lock of the index in root_fd
+static int index_watched(int root_fd) {
+    int fd = openat(root_fd, INDEX_LOCK_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+    int watched = flock(fd, LOCK_SH | LOCK_NB) == -1 && errno == EWOULDBLOCK;
+    close(fd);
+    return watched;
+}
+
+// Function to print every indexed file ending in extension
+long index_query(const char *dir_name, const char *extension) {
+    size_t key_len = strlen(extension);
+    if (extension[0] != '.' || key_len < 2 || strpbrk(extension + 1, "./\t\n") != NULL) {
+        return INDEX_UNSUPPORTED;
+    }
+
+    int root_fd = open(dir_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd == -1) {
+        return INDEX_MISSING;
+    }
+    int fd = openat(root_fd, INDEX_FILE, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1 || flock(fd, LOCK_SH) == -1 || fstat(fd, &st) == -1 ||
+        (size_t)st.st_size < sizeof(INDEX_MAGIC) - 1) {
+        if (fd != -1) {
+            close(fd);
+        }
+        close(root_fd);
+        return INDEX_MISSING;
+    }
+
+    char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED || memcmp(map, INDEX_MAGIC, sizeof(INDEX_MAGIC) - 1) != 0) {
+        if (map != MAP_FAILED) {
+            munmap(map, st.st_size);
+        }
+        close(fd);
+        close(root_fd);
+        return INDEX_MISSING;
+    }
+    const char *end = map + st.st_size;
+    const char *p = map + sizeof(INDEX_MAGIC) - 1;
+
+    // The pid line is informational; the directory mtimes decide
+    if (end - p > 4 && memcmp(p, "pid\t", 4) == 0) {
+        p = next_line(p, end);
+    }
+
+    long result = 0;
+    char dir[WALK_PATH_MAX];
+    while (p < end && *p == 'D') {
+        const char *line_end = next_line(p, end);
+        if (result == 0) {
+            unsigned long fields[2] = { 0, 0 };
+            const char *f = p + 2;
+            for (int i = 0; i < 2; i++, f++) {
+                for (; f < line_end && *f >= '0' && *f <= '9'; f++) {
+                    fields[i] = fields[i] * 10 + (*f - '0');
+                }
+            }
+            size_t len = line_end - f - (line_end[-1] == '\n');
+            if (len >= sizeof(dir)) {
+                len = sizeof(dir) - 1;
+            }
+            memcpy(dir, f, len);
+            dir[len] = '\0';
+            if (fstatat(root_fd, dir, &st, AT_SYMLINK_NOFOLLOW) == -1 ||
+                (unsigned long)st.st_mtim.tv_sec != fields[0] ||
+                (unsigned long)st.st_mtim.tv_nsec != fields[1]) {
+                result = INDEX_STALE;
+            }
+        }
+        p = line_end;
+    }
+    if (result == INDEX_STALE && index_watched(root_fd)) {
+        result = INDEX_PENDING;
+    }
+
+    if (result == 0) {
+        // Lower bound of the extension among the sorted F lines
+        const char *lo = p;
+        const char *hi = end;
+        while (lo < hi) {
+            const char *mid = lo + (hi - lo) / 2;
+            while (mid > lo && mid[-1] != '\n') {
+                mid--;
+            }
+            if (compare_line_extension(mid, end, extension, key_len) < 0) {
+                lo = next_line(mid, end);
+            } else {
+                hi = mid;
+            }
+        }
+
+        for (p = lo; p < end && compare_line_extension(p, end, extension, key_len) == 0;) {
+            const char *line_end = next_line(p, end);
+            const char *path = p + 2 + key_len + 1;
+            output_write("  ", 2);
+            output_write(path, line_end - path);
+            result++;
+            p = line_end;
+        }
+    }
+
+    munmap(map, st.st_size);
+    close(fd);
+    close(root_fd);
+    return result;
+}
+
+static void watch_signal(int sig) {
+    (void)sig;
+    watch_stop = 1;
+}
+
+// Apply one inotify event to the sets; returns 1 if the index changed
+static int index_event(Index *index, const struct inotify_event *event, int threads) {
+    if (event->mask & IN_IGNORED) {
+        // The watch is gone (directory deleted or moved away)
+        if ((size_t)event->wd < index->watch_cap) {
+            free(index->watches[event->wd]);
+            index->watches[event->wd] = NULL;
+        }
+        return 0;
+    }
+    if (event->len == 0 || (size_t)event->wd >= index->watch_cap ||
+        index->watches[event->wd] == NULL) {
+        return 0;
+    }
+
+    const char *dir = index->watches[event->wd];
+    if (dir[0] == '\0' &&
+        (strcmp(event->name, INDEX_FILE) == 0 || strcmp(event->name, INDEX_LOCK_FILE) == 0)) {
+        return 0;
+    }
+    if (strpbrk(event->name, "\t\n") != NULL) {
+        atomic_fetch_add(&index->skipped, 1);
+        return 0;
+    }
+
+    char path[WALK_PATH_MAX];
+    size_t dir_len = strlen(dir);
+    if (dir_len + strlen(event->name) + 2 > sizeof(path)) {
+        return 0;
+    }
+    strcpy(path, dir);
+    if (dir_len > 0) {
+        strcat(path, "/");
+    }
+    strcat(path, event->name);
+
+    // The event already changed dir, so its mtime now covers the change
+    struct timespec mtime;
+    dir_mtime(index->root_fd, dir[0] ? dir : ".", &mtime);
+    set_insert(&index->dirs, strdup(dir), &mtime);
+
+    if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        if (event->mask & IN_ISDIR) {
+            index_drop_watches(index, path);
+            set_remove_tree(&index->files, path);
+            set_remove_tree(&index->dirs, path);
+        } else {
+            set_remove(&index->files, path);
+        }
+        return 1;
+    }
+
+    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+        if (event->mask & IN_ISDIR) {
+            index_scan(index, path, threads);  // It may already have entries
+        } else if (path_extension(event->name) != NULL) {
+            set_insert(&index->files, strdup(path), NULL);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// Function to keep the index of dir_name current with inotify
+int index_watch(const char *dir_name, int threads, IndexStats *stats) {
+    Index index;
+    if (index_open(&index, dir_name, 1) == -1) {
+        return -1;
+    }
+
+    // One watcher per tree: the lock is held until the process exits
+    int lock_fd = openat(index.root_fd, INDEX_LOCK_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd == -1 || flock(lock_fd, LOCK_EX | LOCK_NB) == -1) {
+        int err = lock_fd != -1 && errno == EWOULDBLOCK ? EBUSY : errno;
+        if (lock_fd != -1) {
+            close(lock_fd);
+        }
+        index_close(&index, stats);
+        errno = err;
+        return -1;
+    }
+    char pid_line[32];
+    IndexWriter writer = { lock_fd, pid_line, 0, 0 };
+    if (ftruncate(lock_fd, 0) == 0) {
+        writer_number(&writer, getpid());  // For people; readers check the lock
+        writer_string(&writer, "\n");
+        writer_flush(&writer);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_signal;  // No SA_RESTART: poll() must wake up
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    unsigned long events = 0, writes = 0;
+    if (index_scan(&index, "", threads) == -1 || index_write(&index, index.live ? getpid() : 0) == -1) {
+        index_close(&index, stats);
+        close(lock_fd);
+        return -1;
+    }
+    writes++;
+
+    char buffer[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd = { index.inotify_fd, POLLIN, 0 };
+    int dirty = 0;
+    struct timespec first_change = { 0, 0 };
+
+    while (!watch_stop) {
+        int ready = poll(&pfd, 1, INDEX_QUIET_MS);
+        if (ready == -1 && errno != EINTR) {
+            break;
+        }
+
+        if (ready > 0) {
+            ssize_t n;
+            while ((n = read(index.inotify_fd, buffer, sizeof(buffer))) > 0) {
+                for (char *p = buffer; p < buffer + n;) {
+                    struct inotify_event *event = (struct inotify_event *)p;
+                    p += sizeof(struct inotify_event) + event->len;
+                    events++;
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        // Events were lost: start again from a fresh scan
+                        set_free(&index.files);
+                        set_free(&index.dirs);
+                        index_scan(&index, "", threads);
+                        dirty = 1;
+                    } else if (index_event(&index, event, threads) && !dirty) {
+                        dirty = 1;
+                        clock_gettime(CLOCK_MONOTONIC, &first_change);
+                    }
+                }
+            }
+        }
+
+        // Write when things go quiet, or every few seconds under load
+        if (dirty) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double waited = (now.tv_sec - first_change.tv_sec) + (now.tv_nsec - first_change.tv_nsec) / 1e9;
+            if (ready == 0 || waited >= INDEX_MAX_DELAY) {
+                index_write(&index, index.live ? getpid() : 0);
+                writes++;
+                dirty = 0;
+            }
+        }
+    }
+
+    // Nobody keeps it current from now on
+    index_write(&index, 0);
+    writes++;
+
+    index_close(&index, stats);
+    close(lock_fd);
+    if (stats != NULL) {
+        stats->events = events;
+        stats->writes = writes;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef EXTINDEX_H
+#define EXTINDEX_H
+
+// Index of a directory tree by file extension, kept in the tree itself
+#define INDEX_FILE ".fmindex"
+// Held locked by a running watcher, with its pid inside
+#define INDEX_LOCK_FILE ".fmindex.lock"
+
+// Why index_query could not answer
+#define INDEX_MISSING -1        // no index file (run indexDir)
+#define INDEX_STALE -2          // a directory changed since it was written
+#define INDEX_UNSUPPORTED -3    // the index only knows ".ext" suffixes
+#define INDEX_PENDING -4        // stale, but a watcher is about to rewrite it
+
+typedef struct {
+    unsigned long files;        // files with an extension
+    unsigned long dirs;
+    unsigned long skipped;      // names with tabs or newlines, not indexed
+    unsigned long events;       // inotify events handled (watch)
+    unsigned long writes;       // times the index file was rewritten (watch)
+    int live;                   // every directory had an inotify watch (watch)
+} IndexStats;
+
+// Function to scan dir_name and (re)write its index file
+int index_build(const char *dir_name, int threads, IndexStats *stats);
+
+// Function to print "  path\n" for every indexed file ending in extension.
+// Returns the number printed, or one of the INDEX_* codes above.
+long index_query(const char *dir_name, const char *extension);
+
+// Function to keep the index of dir_name current with inotify until
+// SIGINT or SIGTERM; fails with EBUSY if another watcher has it
+int index_watch(const char *dir_name, int threads, IndexStats *stats);
+
+#endif
\ No newline at end of file
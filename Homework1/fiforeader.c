@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#include "fiforeader.h"
+
+static volatile sig_atomic_t fifo_stop = 0;
+
+static void fifo_signal(int sig) {
+    (void)sig;
+    fifo_stop = 1;
+}
+
+// Function to open fifo for reading, creating it if it does not exist
+int fifo_reader_open(FifoReader *reader, const char *fifo, mode_t mode, size_t batch) {
+    memset(reader, 0, sizeof(*reader));
+    reader->path = fifo;
+    reader->size = batch;
+    reader->created = mkfifo(fifo, mode) == 0;
+    if (!reader->created && errno != EEXIST) {
+        return -1;
+    }
+
+    // Our own write end keeps read() from seeing EOF between clients
+    reader->buffer = malloc(batch);
+    reader->fd = reader->buffer != NULL ? open(fifo, O_RDONLY | O_NONBLOCK | O_CLOEXEC) : -1;
+    reader->keep = reader->fd != -1 ? open(fifo, O_WRONLY | O_CLOEXEC) : -1;
+    if (reader->keep == -1) {
+        int err = errno;
+        fifo_reader_close(reader);
+        errno = err;
+        return -1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = fifo_signal;  // No SA_RESTART: poll() must wake up
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    return 0;
+}
+
+// Function to read the FIFO until SIGINT or SIGTERM and the last writer
+void fifo_reader_run(FifoReader *reader, FifoRecords records, void *arg) {
+    struct pollfd pfd = { reader->fd, POLLIN, 0 };
+
+    for (;;) {
+        if (fifo_stop && reader->keep != -1) {
+            // New writers now fail to open the FIFO; what was already
+            // written still gets read until the last of them leaves
+            if (reader->created) {
+                unlink(reader->path);
+                reader->created = 0;
+            }
+            close(reader->keep);
+            reader->keep = -1;
+        }
+        if (poll(&pfd, 1, fifo_stop ? 100 : -1) == -1 && errno != EINTR) {
+            break;
+        }
+
+        // Everything queued right now is one batch
+        ssize_t n = 0;
+        while (reader->used < reader->size &&
+               (n = read(reader->fd, reader->buffer + reader->used, reader->size - reader->used)) > 0) {
+            reader->used += n;
+        }
+        if (reader->used > 0) {
+            size_t consumed = records(reader->buffer, reader->used, arg);
+            memmove(reader->buffer, reader->buffer + consumed, reader->used - consumed);
+            reader->used -= consumed;
+        }
+
+        if (n == 0 && reader->keep == -1) {
+            break;  // EOF: no writer is left
+        }
+    }
+}
+
+// Function to close the FIFO, removing it if we created it
+void fifo_reader_close(FifoReader *reader) {
+    if (reader->keep != -1) {
+        close(reader->keep);
+        reader->keep = -1;
+    }
+    if (reader->created) {
+        unlink(reader->path);
+        reader->created = 0;
+    }
+    if (reader->fd != -1) {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+    free(reader->buffer);
+    reader->buffer = NULL;
+}
\ No newline at end of file
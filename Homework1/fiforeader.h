@@ -0,0 +1,33 @@
+#ifndef FIFOREADER_H
+#define FIFOREADER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Called with everything read from the FIFO and not yet consumed; returns
+// the bytes it used (a trailing partial record waits for the next batch)
+typedef size_t (*FifoRecords)(const char *data, size_t len, void *arg);
+
+typedef struct {
+    const char *path;
+    int fd;             // read end
+    int keep;           // our own write end, -1 once we stop taking writers
+    int created;        // the FIFO is ours to remove
+    char *buffer;
+    size_t size;
+    size_t used;
+} FifoReader;
+
+// Function to open fifo for reading, creating it with mode if it does not
+// exist, and to make SIGINT and SIGTERM stop fifo_reader_run. Returns -1
+// (errno set) on failure.
+int fifo_reader_open(FifoReader *reader, const char *fifo, mode_t mode, size_t batch);
+
+// Function to hand everything written to the FIFO to records, a batch per
+// wakeup, until SIGINT or SIGTERM and then until the last writer leaves
+void fifo_reader_run(FifoReader *reader, FifoRecords records, void *arg);
+
+// Function to close the FIFO, removing it if fifo_reader_open created it
+void fifo_reader_close(FifoReader *reader);
+
+#endif
\ No newline at end of file
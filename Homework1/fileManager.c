@@ -1,632 +1,2962 @@
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <sys/file.h>
-#include <sys/wait.h>
-#include <fcntl.h>
-#include <dirent.h>
-#include <time.h>
-#include <errno.h>
-
-#define LOG_FILE "log.txt"
-#define MAX_BUFFER 1024
-
-// Function to log operations
-void log_operation(const char *message) {
-    int log_fd = open(LOG_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
-    if (log_fd == -1) {
-        const char *error_msg = "Error opening log file\n";
-        write(STDERR_FILENO, error_msg, strlen(error_msg));
-        return;
-    }
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[32];
-    char full_log[MAX_BUFFER];
-    
-    strftime(timestamp, sizeof(timestamp), "[%Y-%m-%d %H:%M:%S] ", timeinfo);
-    
-    // Construct the full log message
-    strcpy(full_log, timestamp);
-    strcat(full_log, message);
-    strcat(full_log, "\n");
-    
-    write(log_fd, full_log, strlen(full_log));
-    close(log_fd);
-}
-
-// Function to write message to stdout
-void write_message(const char *message) {
-    write(STDOUT_FILENO, message, strlen(message));
-}
-
-// Function to create a directory
-void create_directory(const char *dir_name) {
-    struct stat st = {0};
-    char log_message[MAX_BUFFER];
-    
-    // Check if directory already exists
-    if (stat(dir_name, &st) == 0) {
-        strcpy(log_message, "Error: Directory \"");
-        strcat(log_message, dir_name);
-        strcat(log_message, "\" already exists.");
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    // Create directory with permissions 0755
-    if (mkdir(dir_name, 0755) == 0) {
-        strcpy(log_message, "Directory \"");
-        strcat(log_message, dir_name);
-        strcat(log_message, "\" created successfully.");
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-    } else {
-        strcpy(log_message, "Error creating directory \"");
-        strcat(log_message, dir_name);
-        strcat(log_message, "\": ");
-        strcat(log_message, strerror(errno));
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-    }
-}
-
-// Function to create a file with timestamp
-void create_file(const char *file_name) {
-    struct stat st = {0};
-    char log_message[MAX_BUFFER];
-    
-    // Check if file already exists
-    if (stat(file_name, &st) == 0) {
-        strcpy(log_message, "Error: File \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\" already exists.");
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    // Create file and write timestamp
-    int fd = open(file_name, O_WRONLY | O_CREAT, 0644);
-    if (fd == -1) {
-        strcpy(log_message, "Error creating file \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\": ");
-        strcat(log_message, strerror(errno));
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    char timestamp[100];
-    int timestamp_len = strftime(timestamp, sizeof(timestamp), 
-                               "Created on: %Y-%m-%d %H:%M:%S\n", timeinfo);
-    
-    write(fd, timestamp, timestamp_len);
-    close(fd);
-    
-    strcpy(log_message, "File \"");
-    strcat(log_message, file_name);
-    strcat(log_message, "\" created successfully.");
-    write_message(log_message);
-    write_message("\n");
-    log_operation(log_message);
-}
-
-// Function to list directory contents
-void list_directory(const char *dir_name) {
-    pid_t pid = fork();
-    
-    if (pid < 0) {
-        write_message("Fork failed\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    if (pid == 0) {  // Child process
-        char log_message[MAX_BUFFER];
-        DIR *dir;
-        struct dirent *entry;
-        
-        dir = opendir(dir_name);
-        if (dir == NULL) {
-            strcpy(log_message, "Error: Directory \"");
-            strcat(log_message, dir_name);
-            strcat(log_message, "\" not found.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-        
-        char dir_msg[MAX_BUFFER];
-        strcpy(dir_msg, "Contents of directory \"");
-        strcat(dir_msg, dir_name);
-        strcat(dir_msg, "\":\n");
-        write_message(dir_msg);
-        
-        int count = 0;
-        
-        while ((entry = readdir(dir)) != NULL) {
-            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
-                write_message("  ");
-                write_message(entry->d_name);
-                write_message("\n");
-                count++;
-            }
-        }
-        
-        if (count == 0) {
-            write_message("  (empty directory)\n");
-        }
-        
-        closedir(dir);
-        strcpy(log_message, "Listed contents of directory \"");
-        strcat(log_message, dir_name);
-        strcat(log_message, "\".");
-        log_operation(log_message);
-        exit(EXIT_SUCCESS);
-    } else {  // Parent process
-        int status;
-        waitpid(pid, &status, 0);  // Wait for child process to complete
-    }
-}
-
-// Function to list files by extension
-void list_files_by_extension(const char *dir_name, const char *extension) {
-    pid_t pid = fork();
-    
-    if (pid < 0) {
-        write_message("Fork failed\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    if (pid == 0) {  // Child process
-        char log_message[MAX_BUFFER];
-        DIR *dir;
-        struct dirent *entry;
-        
-        dir = opendir(dir_name);
-        if (dir == NULL) {
-            strcpy(log_message, "Error: Directory \"");
-            strcat(log_message, dir_name);
-            strcat(log_message, "\" not found.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-        
-        char ext_msg[MAX_BUFFER];
-        strcpy(ext_msg, "Files with extension \"");
-        strcat(ext_msg, extension);
-        strcat(ext_msg, "\" in directory \"");
-        strcat(ext_msg, dir_name);
-        strcat(ext_msg, "\":\n");
-        write_message(ext_msg);
-        
-        int count = 0;
-        size_t ext_len = strlen(extension);
-        
-        while ((entry = readdir(dir)) != NULL) {
-            char *filename = entry->d_name;
-            size_t filename_len = strlen(filename);
-            
-            // Check if file ends with the extension
-            if (filename_len > ext_len && 
-                strcmp(filename + filename_len - ext_len, extension) == 0) {
-                write_message("  ");
-                write_message(filename);
-                write_message("\n");
-                count++;
-            }
-        }
-        
-        if (count == 0) {
-            char not_found[MAX_BUFFER];
-            strcpy(not_found, "No files with extension \"");
-            strcat(not_found, extension);
-            strcat(not_found, "\" found in \"");
-            strcat(not_found, dir_name);
-            strcat(not_found, "\".\n");
-            write_message(not_found);
-        }
-        
-        closedir(dir);
-        strcpy(log_message, "Listed files with extension \"");
-        strcat(log_message, extension);
-        strcat(log_message, "\" in directory \"");
-        strcat(log_message, dir_name);
-        strcat(log_message, "\".");
-        log_operation(log_message);
-        exit(EXIT_SUCCESS);
-    } else {  // Parent process
-        int status;
-        waitpid(pid, &status, 0);  // Wait for child process to complete
-    }
-}
-
-// Function to read file content
-void read_file(const char *file_name) {
-    char log_message[MAX_BUFFER];
-    struct stat st;
-    
-    // Check if file exists
-    if (stat(file_name, &st) == -1) {
-        strcpy(log_message, "Error: File \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\" not found.");
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    int fd = open(file_name, O_RDONLY);
-    if (fd == -1) {
-        strcpy(log_message, "Error opening file \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\": ");
-        strcat(log_message, strerror(errno));
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    char file_msg[MAX_BUFFER];
-    strcpy(file_msg, "Contents of file \"");
-    strcat(file_msg, file_name);
-    strcat(file_msg, "\":\n");
-    write_message(file_msg);
-    
-    char buffer[MAX_BUFFER];
-    ssize_t bytes_read;
-    
-    while ((bytes_read = read(fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[bytes_read] = '\0';  // Null-terminate the buffer
-        write_message(buffer);
-    }
-    
-    // Add a newline if the file doesn't end with one
-    if (bytes_read > 0 && buffer[bytes_read - 1] != '\n') {
-        write_message("\n");
-    }
-    
-    close(fd);
-    strcpy(log_message, "Read contents of file \"");
-    strcat(log_message, file_name);
-    strcat(log_message, "\".");
-    log_operation(log_message);
-}
-
-// Function to append content to a file
-void append_to_file(const char *file_name, const char *content) {
-    char log_message[MAX_BUFFER];
-    struct stat st;
-    
-    // Check if file exists
-    if (stat(file_name, &st) == -1) {
-        strcpy(log_message, "Error: File \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\" not found.");
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    int fd = open(file_name, O_WRONLY | O_APPEND);
-    if (fd == -1) {
-        strcpy(log_message, "Error opening file \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\": ");
-        strcat(log_message, strerror(errno));
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        return;
-    }
-    
-    // Try to get an exclusive lock
-    if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
-        strcpy(log_message, "Error: Cannot write to \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\". File is locked or read-only.");
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        close(fd);
-        return;
-    }
-    
-    // Write content
-    if (write(fd, content, strlen(content)) == -1) {
-        strcpy(log_message, "Error writing to file \"");
-        strcat(log_message, file_name);
-        strcat(log_message, "\": ");
-        strcat(log_message, strerror(errno));
-        write_message(log_message);
-        write_message("\n");
-        log_operation(log_message);
-        flock(fd, LOCK_UN);  // Release the lock
-        close(fd);
-        return;
-    }
-    
-    // Add a newline if needed
-    if (content[strlen(content) - 1] != '\n') {
-        write(fd, "\n", 1);
-    }
-    
-    flock(fd, LOCK_UN);  // Release the lock
-    close(fd);
-    
-    strcpy(log_message, "Successfully appended to file \"");
-    strcat(log_message, file_name);
-    strcat(log_message, "\".");
-    write_message(log_message);
-    write_message("\n");
-    log_operation(log_message);
-}
-
-// Function to delete a file
-void delete_file(const char *file_name) {
-    pid_t pid = fork();
-    
-    if (pid < 0) {
-        write_message("Fork failed\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    if (pid == 0) {  // Child process
-        char log_message[MAX_BUFFER];
-        struct stat st = {0};
-        
-        // Check if file exists
-        if (stat(file_name, &st) == -1) {
-            strcpy(log_message, "Error: File \"");
-            strcat(log_message, file_name);
-            strcat(log_message, "\" not found.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-        
-        // Delete file
-        if (unlink(file_name) == 0) {
-            strcpy(log_message, "File \"");
-            strcat(log_message, file_name);
-            strcat(log_message, "\" deleted successfully.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_SUCCESS);
-        } else {
-            strcpy(log_message, "Error deleting file \"");
-            strcat(log_message, file_name);
-            strcat(log_message, "\": ");
-            strcat(log_message, strerror(errno));
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-    } else {  // Parent process
-        int status;
-        waitpid(pid, &status, 0);  // Wait for child process to complete
-    }
-}
-
-// Function to delete a directory
-void delete_directory(const char *dir_name) {
-    pid_t pid = fork();
-    
-    if (pid < 0) {
-        write_message("Fork failed\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    if (pid == 0) {  // Child process
-        char log_message[MAX_BUFFER];
-        DIR *dir;
-        struct dirent *entry;
-        int is_empty = 1;
-        
-        dir = opendir(dir_name);
-        if (dir == NULL) {
-            strcpy(log_message, "Error: Directory \"");
-            strcat(log_message, dir_name);
-            strcat(log_message, "\" not found.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-        
-        // Check if directory is empty
-        while ((entry = readdir(dir)) != NULL) {
-            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
-                is_empty = 0;
-                break;
-            }
-        }
-        
-        closedir(dir);
-        
-        if (!is_empty) {
-            strcpy(log_message, "Error: Directory \"");
-            strcat(log_message, dir_name);
-            strcat(log_message, "\" is not empty.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-        
-        // Delete the empty directory
-        if (rmdir(dir_name) == 0) {
-            strcpy(log_message, "Directory \"");
-            strcat(log_message, dir_name);
-            strcat(log_message, "\" deleted successfully.");
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_SUCCESS);
-        } else {
-            strcpy(log_message, "Error deleting directory \"");
-            strcat(log_message, dir_name);
-            strcat(log_message, "\": ");
-            strcat(log_message, strerror(errno));
-            write_message(log_message);
-            write_message("\n");
-            log_operation(log_message);
-            exit(EXIT_FAILURE);
-        }
-    } else {  // Parent process
-        int status;
-        waitpid(pid, &status, 0);  // Wait for child process to complete
-    }
-}
-
-// Function to show logs
-void show_logs() {
-    char log_message[MAX_BUFFER];
-    struct stat st;
-    
-    // Check if log file exists
-    if (stat(LOG_FILE, &st) == -1) {
-        write_message("No logs found. Log file does not exist yet.\n");
-        return;
-    }
-    
-    int fd = open(LOG_FILE, O_RDONLY);
-    if (fd == -1) {
-        write_message("Error opening log file: ");
-        write_message(strerror(errno));
-        write_message("\n");
-        return;
-    }
-    
-    write_message("Operation Logs:\n");
-    char buffer[MAX_BUFFER];
-    ssize_t bytes_read;
-    
-    while ((bytes_read = read(fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[bytes_read] = '\0';  // Null-terminate the buffer
-        write_message(buffer);
-    }
-    
-    // Add a newline if the file doesn't end with one
-    if (bytes_read > 0 && buffer[bytes_read - 1] != '\n') {
-        write_message("\n");
-    }
-    
-    close(fd);
-    strcpy(log_message, "Displayed operation logs.");
-    log_operation(log_message);
-}
-
-// Function to display help
-void display_help() {
-    write_message("Usage: fileManager <command> [arguments]\n");
-    write_message("Commands:\n");
-    write_message("  createDir \"folderName\"                      - Create a new directory\n");
-    write_message("  createFile \"fileName\"                       - Create a new file\n");
-    write_message("  listDir \"folderName\"                        - List all files in a directory\n");
-    write_message("  listFilesByExtension \"folderName\" \".txt\"    - List files with specific extension\n");
-    write_message("  readFile \"fileName\"                         - Read a file's content\n");
-    write_message("  appendToFile \"fileName\" \"new content\"       - Append content to a file\n");
-    write_message("  deleteFile \"fileName\"                       - Delete a file\n");
-    write_message("  deleteDir \"folderName\"                      - Delete an empty directory\n");
-    write_message("  showLogs                                    - Display operation logs\n");
-}
-
-int main(int argc, char *argv[]) {
-    // If no arguments provided, display help
-    if (argc == 1) {
-        display_help();
-        return 0;
-    }
-    
-    // Check command
-    if (strcmp(argv[1], "createDir") == 0) {
-        if (argc != 3) {
-            write_message("Error: createDir requires one argument.\n");
-            return 1;
-        }
-        create_directory(argv[2]);
-    }
-    else if (strcmp(argv[1], "createFile") == 0) {
-        if (argc != 3) {
-            write_message("Error: createFile requires one argument.\n");
-            return 1;
-        }
-        create_file(argv[2]);
-    }
-    else if (strcmp(argv[1], "listDir") == 0) {
-        if (argc != 3) {
-            write_message("Error: listDir requires one argument.\n");
-            return 1;
-        }
-        list_directory(argv[2]);
-    }
-    else if (strcmp(argv[1], "listFilesByExtension") == 0) {
-        if (argc != 4) {
-            write_message("Error: listFilesByExtension requires two arguments.\n");
-            return 1;
-        }
-        list_files_by_extension(argv[2], argv[3]);
-    }
-    else if (strcmp(argv[1], "readFile") == 0) {
-        if (argc != 3) {
-            write_message("Error: readFile requires one argument.\n");
-            return 1;
-        }
-        read_file(argv[2]);
-    }
-    else if (strcmp(argv[1], "appendToFile") == 0) {
-        if (argc != 4) {
-            write_message("Error: appendToFile requires two arguments.\n");
-            return 1;
-        }
-        append_to_file(argv[2], argv[3]);
-    }
-    else if (strcmp(argv[1], "deleteFile") == 0) {
-        if (argc != 3) {
-            write_message("Error: deleteFile requires one argument.\n");
-            return 1;
-        }
-        delete_file(argv[2]);
-    }
-    else if (strcmp(argv[1], "deleteDir") == 0) {
-        if (argc != 3) {
-            write_message("Error: deleteDir requires one argument.\n");
-            return 1;
-        }
-        delete_directory(argv[2]);
-    }
-    else if (strcmp(argv[1], "showLogs") == 0) {
-        show_logs();
-    }
-    else {
-        write_message("Unknown command: ");
-        write_message(argv[1]);
-        write_message("\n");
-        display_help();
-        return 1;
-    }
-    
-    return 0;
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "oplog.h"
+#include "output.h"
+#include "transfer.h"
+#include "walker.h"
+#include "extindex.h"
+#include "coalesce.h"
+#include "logquery.h"
+#include "diskusage.h"
+#include "filehash.h"
+#include "search.h"
+#include "serve.h"
+#include "follow.h"
+#include "bulkcreate.h"
+#include "dirlist.h"
+
+#define MAX_BUFFER 1024
+#define MAX_ARGS 16
+
+// Function to write message to stdout (buffered, see output.c)
+void write_message(const char *message) {
+    output_string(message);
+}
+
+// Function to format an unsigned number, returns its length
+int format_number(char *buffer, unsigned long value) {
+    char digits[32];
+    int len = 0;
+    
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    
+    for (int i = 0; i < len; i++) {
+        buffer[i] = digits[len - 1 - i];
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+// Function to format a non-negative value with a fixed number of decimals
+int format_decimal(char *buffer, double value, int decimals) {
+    unsigned long scale = 1;
+    for (int i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    
+    unsigned long scaled = (unsigned long)(value * scale + 0.5);
+    int len = format_number(buffer, scaled / scale);
+    if (decimals > 0) {
+        buffer[len++] = '.';
+        unsigned long frac = scaled % scale;
+        for (unsigned long div = scale / 10; div > 0; div /= 10) {
+            buffer[len++] = '0' + (frac / div) % 10;
+        }
+        buffer[len] = '\0';
+    }
+    return len;
+}
+
+// Function to read the monotonic clock in seconds
+double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Commands that fork (as the assignment asks) run in-process under serve,
+// where worker threads answer many clients from one process
+int in_process = 0;
+
+// Function to fork for a command; in-process the "child" is the caller
+pid_t command_fork() {
+    if (in_process) {
+        return 0;
+    }
+    log_flush();  // The child must not inherit buffered records or output
+    output_flush();
+    return fork();
+}
+
+// Function to end a command's child side: a forked child exits with
+// status, an in-process one returns it like the parent would
+int command_exit(int status) {
+    if (!in_process) {
+        exit(status);
+    }
+    return status == EXIT_SUCCESS ? 0 : -1;
+}
+
+// Function to create a directory
+int create_directory(const char *dir_name) {
+    struct stat st = {0};
+    char log_message[MAX_BUFFER];
+    
+    // Check if directory already exists
+    if (stat(dir_name, &st) == 0) {
+        strcpy(log_message, "Error: Directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\" already exists.");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    // Create directory with permissions 0755
+    if (mkdir(dir_name, 0755) == 0) {
+        strcpy(log_message, "Directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\" created successfully.");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_SUCCESS);
+        return 0;
+    } else {
+        strcpy(log_message, "Error creating directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+}
+
+// Function to create a file with timestamp
+int create_file(const char *file_name) {
+    struct stat st = {0};
+    char log_message[MAX_BUFFER];
+    
+    // Check if file already exists
+    if (stat(file_name, &st) == 0) {
+        strcpy(log_message, "Error: File \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\" already exists.");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    // Create file and write timestamp
+    int fd = open(file_name, O_WRONLY | O_CREAT, 0644);
+    if (fd == -1) {
+        strcpy(log_message, "Error creating file \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    time_t now = time(NULL);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);  // serve runs commands on several threads
+    char timestamp[100];
+    int timestamp_len = strftime(timestamp, sizeof(timestamp), 
+                               "Created on: %Y-%m-%d %H:%M:%S\n", &timeinfo);
+    
+    write(fd, timestamp, timestamp_len);
+    close(fd);
+    
+    strcpy(log_message, "File \"");
+    strcat(log_message, file_name);
+    strcat(log_message, "\" created successfully.");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to create many files in a directory at once, count of them or
+// one per line of a list, with one summary log record
+int create_files(const char *dir_name, unsigned long count, const char *list, int sync) {
+    char log_message[MAX_BUFFER];
+    BulkStats stats;
+    
+    if (list != NULL && access(list, R_OK) == -1) {
+        strcpy(log_message, "Error reading list file \"");
+        strcat(log_message, list);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    double start = now_seconds();
+    if (bulk_create(dir_name, count, list, sync, &stats) == -1 && stats.batches == 0) {
+        strcpy(log_message, "Error creating files in \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    double elapsed = now_seconds() - start;
+    
+    char number[32];
+    if (stats.failed == 0) {
+        strcpy(log_message, "Created ");
+    } else {
+        strcpy(log_message, "Error creating files: created ");
+    }
+    format_number(number, stats.created);
+    strcat(log_message, number);
+    strcat(log_message, stats.created == 1 ? " file in \"" : " files in \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\" (");
+    format_number(number, stats.existed);
+    strcat(log_message, number);
+    strcat(log_message, " already existed, ");
+    format_number(number, stats.failed);
+    strcat(log_message, number);
+    strcat(log_message, " failed) in ");
+    format_decimal(number, elapsed * 1000, 1);
+    strcat(log_message, number);
+    strcat(log_message, " ms (");
+    format_number(number, (unsigned long)(elapsed > 0 ? stats.created / elapsed : 0));
+    strcat(log_message, number);
+    strcat(log_message, " files/sec, ");
+    if (stats.uring) {
+        strcat(log_message, "io_uring, ");
+        format_number(number, stats.batches);
+        strcat(log_message, number);
+        strcat(log_message, stats.batches == 1 ? " batch)." : " batches).");
+    } else {
+        strcat(log_message, "one at a time).");
+    }
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, stats.failed == 0 ? LOG_SUCCESS : LOG_FAILURE);
+    return stats.failed == 0 ? 0 : -1;
+}
+
+// Function to list directory contents
+int list_directory(const char *dir_name) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        char log_message[MAX_BUFFER];
+        DIR *dir;
+        struct dirent *entry;
+        
+        dir = opendir(dir_name);
+        if (dir == NULL) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        char dir_msg[MAX_BUFFER];
+        strcpy(dir_msg, "Contents of directory \"");
+        strcat(dir_msg, dir_name);
+        strcat(dir_msg, "\":\n");
+        write_message(dir_msg);
+        
+        int count = 0;
+        
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                write_message("  ");
+                write_message(entry->d_name);
+                write_message("\n");
+                count++;
+            }
+        }
+        
+        if (count == 0) {
+            write_message("  (empty directory)\n");
+        }
+        
+        closedir(dir);
+        strcpy(log_message, "Listed contents of directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\".");
+        log_operation(log_message, LOG_SUCCESS);
+        return command_exit(EXIT_SUCCESS);
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Function to list files by extension
+int list_files_by_extension(const char *dir_name, const char *extension) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        char log_message[MAX_BUFFER];
+        DIR *dir;
+        struct dirent *entry;
+        
+        dir = opendir(dir_name);
+        if (dir == NULL) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        char ext_msg[MAX_BUFFER];
+        strcpy(ext_msg, "Files with extension \"");
+        strcat(ext_msg, extension);
+        strcat(ext_msg, "\" in directory \"");
+        strcat(ext_msg, dir_name);
+        strcat(ext_msg, "\":\n");
+        write_message(ext_msg);
+        
+        int count = 0;
+        size_t ext_len = strlen(extension);
+        
+        while ((entry = readdir(dir)) != NULL) {
+            char *filename = entry->d_name;
+            size_t filename_len = strlen(filename);
+            
+            // Check if file ends with the extension
+            if (filename_len > ext_len && 
+                strcmp(filename + filename_len - ext_len, extension) == 0) {
+                write_message("  ");
+                write_message(filename);
+                write_message("\n");
+                count++;
+            }
+        }
+        
+        if (count == 0) {
+            char not_found[MAX_BUFFER];
+            strcpy(not_found, "No files with extension \"");
+            strcat(not_found, extension);
+            strcat(not_found, "\" found in \"");
+            strcat(not_found, dir_name);
+            strcat(not_found, "\".\n");
+            write_message(not_found);
+        }
+        
+        closedir(dir);
+        strcpy(log_message, "Listed files with extension \"");
+        strcat(log_message, extension);
+        strcat(log_message, "\" in directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\".");
+        log_operation(log_message, LOG_SUCCESS);
+        return command_exit(EXIT_SUCCESS);
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Function to parse an unsigned decimal argument, returns -1 if it isn't one
+int parse_number(const char *text, unsigned long *value) {
+    char *end;
+    
+    if (*text < '0' || *text > '9') {
+        return -1;
+    }
+    errno = 0;
+    *value = strtoul(text, &end, 10);
+    return errno == 0 && *end == '\0' ? 0 : -1;
+}
+
+// Options shared by the commands that walk a tree
+typedef struct {
+    int recursive;  // -R
+    int sorted;     // --sort: collect everything, print in path order
+    int threads;    // --threads=N, 0 = one per CPU
+    int indexed;    // --index: answer from the extension index if it is current
+    int cached;     // --cache: du keeps per-directory totals between runs
+    int depth;      // --depth=N: du prints directories this deep (-1 = all)
+    int sort_key;   // --sort=name|size|mtime, a DirListSort (0 = not given)
+    int long_format;  // --long: size and modification time of each entry
+    unsigned long limit;  // --limit=N: only the first N entries (0 = all)
+} ListOptions;
+
+#define LIST_CHUNK (64 * 1024)  // streamed output handed over per worker
+
+// Lines found by one walker thread, padded so workers don't share lines
+typedef struct {
+    char *data;
+    size_t used;
+    size_t cap;
+    unsigned long matched;
+    char pad[32];
+} ListBuffer;
+
+typedef struct {
+    const char *extension;  // NULL lists everything
+    size_t ext_len;
+    const ListOptions *options;
+    OutputState *output;    // the command's output, not the worker's own
+    pthread_mutex_t lock;   // output_write is not thread-safe
+    ListBuffer buffers[WALK_MAX_THREADS];
+} TreeListing;
+
+// Function to hand a worker's lines to the output buffer
+void list_flush_buffer(TreeListing *listing, ListBuffer *buffer) {
+    pthread_mutex_lock(&listing->lock);
+    output_write_to(listing->output, buffer->data, buffer->used);
+    pthread_mutex_unlock(&listing->lock);
+    buffer->used = 0;
+}
+
+// Walker callback: format "  path\n" lines into the worker's buffer
+int list_visit(int worker, int dfd, const char *path, size_t path_len,
+               const char *name, unsigned char type, void *arg) {
+    TreeListing *listing = arg;
+    ListBuffer *buffer = &listing->buffers[worker];
+    (void)dfd;
+    
+    int descend = listing->options->recursive;
+    if (listing->extension != NULL) {
+        size_t name_len = strlen(name);
+        if (name_len <= listing->ext_len ||
+            strcmp(name + name_len - listing->ext_len, listing->extension) != 0) {
+            return descend;
+        }
+    }
+    
+    size_t need = path_len + 4;
+    if (buffer->used + need > buffer->cap) {
+        if (!listing->options->sorted && buffer->used > 0) {
+            list_flush_buffer(listing, buffer);
+        }
+        if (buffer->used + need > buffer->cap) {
+            size_t cap = buffer->cap ? buffer->cap * 2 : LIST_CHUNK;
+            while (buffer->used + need > cap) {
+                cap *= 2;
+            }
+            char *data = realloc(buffer->data, cap);
+            if (data == NULL) {
+                return descend;
+            }
+            buffer->data = data;
+            buffer->cap = cap;
+        }
+    }
+    
+    char *line = buffer->data + buffer->used;
+    line[0] = ' ';
+    line[1] = ' ';
+    memcpy(line + 2, path, path_len);
+    size_t len = 2 + path_len;
+    if (type == DT_DIR && listing->extension == NULL) {
+        line[len++] = '/';
+    }
+    line[len++] = '\n';
+    buffer->used += len;
+    buffer->matched++;
+    return descend;
+}
+
+// Function to order two output lines ending in '\n'
+int compare_lines(const void *a, const void *b) {
+    const unsigned char *x = *(const unsigned char *const *)a;
+    const unsigned char *y = *(const unsigned char *const *)b;
+    
+    while (*x == *y && *x != '\n') {
+        x++;
+        y++;
+    }
+    return (int)*x - (int)*y;
+}
+
+// Function to print every worker's lines sorted by path
+void list_print_sorted(TreeListing *listing, unsigned long total) {
+    char **lines = malloc((total ? total : 1) * sizeof(char *));
+    if (lines == NULL) {
+        for (int i = 0; i < WALK_MAX_THREADS; i++) {
+            output_write(listing->buffers[i].data, listing->buffers[i].used);
+        }
+        return;
+    }
+    
+    unsigned long n = 0;
+    for (int i = 0; i < WALK_MAX_THREADS; i++) {
+        ListBuffer *buffer = &listing->buffers[i];
+        for (size_t pos = 0; pos < buffer->used;) {
+            lines[n++] = buffer->data + pos;
+            pos = (char *)memchr(buffer->data + pos, '\n', buffer->used - pos) - buffer->data + 1;
+        }
+    }
+    
+    qsort(lines, n, sizeof(char *), compare_lines);
+    for (unsigned long i = 0; i < n; i++) {
+        output_write(lines[i], strchr(lines[i], '\n') - lines[i] + 1);
+    }
+    free(lines);
+}
+
+// Function to list a directory tree (or one level of it) with the walker,
+// extension NULL lists every entry
+int list_tree(const char *dir_name, const char *extension, const ListOptions *options) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        char log_message[MAX_BUFFER];
+        struct stat st;
+        
+        if (stat(dir_name, &st) == -1 || !S_ISDIR(st.st_mode)) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        char header[MAX_BUFFER];
+        if (extension != NULL) {
+            strcpy(header, "Files with extension \"");
+            strcat(header, extension);
+            strcat(header, "\" in directory \"");
+        } else {
+            strcpy(header, "Contents of directory \"");
+        }
+        strcat(header, dir_name);
+        strcat(header, options->recursive ? "\" (recursive):\n" : "\":\n");
+        write_message(header);
+        
+        if (options->indexed && extension != NULL) {
+            long found = index_query(dir_name, extension);
+            if (found >= 0) {
+                if (found == 0) {
+                    char not_found[MAX_BUFFER];
+                    strcpy(not_found, "No files with extension \"");
+                    strcat(not_found, extension);
+                    strcat(not_found, "\" found in \"");
+                    strcat(not_found, dir_name);
+                    strcat(not_found, "\".\n");
+                    write_message(not_found);
+                }
+                char number[32];
+                format_number(number, found);
+                strcpy(log_message, "Listed files with extension \"");
+                strcat(log_message, extension);
+                strcat(log_message, "\" in directory \"");
+                strcat(log_message, dir_name);
+                strcat(log_message, "\" from its index: ");
+                strcat(log_message, number);
+                strcat(log_message, " matching.");
+                log_operation(log_message, LOG_SUCCESS);
+                return command_exit(EXIT_SUCCESS);
+            }
+            
+            // No usable index: say why and scan instead
+            if (found == INDEX_PENDING) {
+                write_message("  (index is behind, watch is about to rewrite it; scanning instead)\n");
+            } else if (found == INDEX_STALE) {
+                write_message("  (index is stale, scanning instead; run indexDir or watch to refresh it)\n");
+            } else if (found == INDEX_MISSING) {
+                write_message("  (no index, scanning instead; run indexDir to build one)\n");
+            } else {
+                write_message("  (the index only covers \".ext\" suffixes, scanning instead)\n");
+            }
+        }
+        
+        TreeListing listing;
+        memset(&listing, 0, sizeof(listing));
+        listing.extension = extension;
+        listing.ext_len = extension != NULL ? strlen(extension) : 0;
+        listing.options = options;
+        listing.output = output_current();
+        pthread_mutex_init(&listing.lock, NULL);
+        
+        WalkOptions walk = { options->threads, list_visit, &listing, NULL };
+        WalkStats stats;
+        double start = now_seconds();
+        walk_tree(dir_name, &walk, &stats);
+        double elapsed = now_seconds() - start;
+        
+        unsigned long matched = 0;
+        for (int i = 0; i < WALK_MAX_THREADS; i++) {
+            matched += listing.buffers[i].matched;
+        }
+        if (options->sorted) {
+            list_print_sorted(&listing, matched);
+        } else {
+            for (int i = 0; i < WALK_MAX_THREADS; i++) {
+                output_write(listing.buffers[i].data, listing.buffers[i].used);
+            }
+        }
+        
+        if (matched == 0 && extension == NULL) {
+            write_message("  (empty directory)\n");
+        } else if (matched == 0) {
+            char not_found[MAX_BUFFER];
+            strcpy(not_found, "No files with extension \"");
+            strcat(not_found, extension);
+            strcat(not_found, "\" found in \"");
+            strcat(not_found, dir_name);
+            strcat(not_found, "\".\n");
+            write_message(not_found);
+        }
+        
+        // Summary: entries, directories, threads and rate
+        char number[32];
+        char summary[MAX_BUFFER];
+        format_number(number, matched);
+        strcpy(summary, number);
+        strcat(summary, extension != NULL ? " matching, " : " entries, ");
+        format_number(number, stats.dirs);
+        strcat(summary, number);
+        strcat(summary, " directories read with ");
+        format_number(number, stats.threads);
+        strcat(summary, number);
+        strcat(summary, " threads in ");
+        format_decimal(number, elapsed * 1000, 1);
+        strcat(summary, number);
+        strcat(summary, " ms (");
+        format_number(number, (unsigned long)(elapsed > 0 ? stats.entries / elapsed : 0));
+        strcat(summary, number);
+        strcat(summary, " entries/sec)");
+        if (stats.errors > 0) {
+            strcat(summary, ", ");
+            format_number(number, stats.errors);
+            strcat(summary, number);
+            strcat(summary, " unreadable");
+        }
+        
+        if (extension != NULL) {
+            strcpy(log_message, "Listed files with extension \"");
+            strcat(log_message, extension);
+            strcat(log_message, "\" in directory \"");
+        } else {
+            strcpy(log_message, "Listed contents of directory \"");
+        }
+        strcat(log_message, dir_name);
+        strcat(log_message, options->recursive ? "\" recursively: " : "\": ");
+        strcat(log_message, summary);
+        strcat(log_message, ".");
+        log_operation(log_message, LOG_SUCCESS);
+        for (int i = 0; i < WALK_MAX_THREADS; i++) {
+            free(listing.buffers[i].data);
+        }
+        pthread_mutex_destroy(&listing.lock);
+        return command_exit(EXIT_SUCCESS);
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Function to list one directory sorted, long or limited (listDir and
+// listFilesByExtension with --sort=key, --long or --limit=N)
+int list_directory_sorted(const char *dir_name, const char *extension, const ListOptions *options) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        static const char *sort_names[] = { "directory order", "name", "size", "mtime" };
+        char log_message[MAX_BUFFER];
+        DirListOptions list = { options->sort_key, options->long_format, options->limit, extension };
+        if (options->sorted && list.sort == DIRLIST_UNSORTED) {
+            list.sort = DIRLIST_BY_NAME;
+        }
+        
+        char header[MAX_BUFFER];
+        if (extension != NULL) {
+            strcpy(header, "Files with extension \"");
+            strcat(header, extension);
+            strcat(header, "\" in directory \"");
+        } else {
+            strcpy(header, "Contents of directory \"");
+        }
+        strcat(header, dir_name);
+        strcat(header, "\":\n");
+        
+        struct stat st;
+        if (stat(dir_name, &st) == -1 || !S_ISDIR(st.st_mode)) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        write_message(header);
+        
+        DirListStats stats;
+        double start = now_seconds();
+        if (dir_list(dir_name, &list, &stats) == -1) {
+            strcpy(log_message, "Error listing directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\": ");
+            strcat(log_message, strerror(errno));
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        double elapsed = now_seconds() - start;
+        
+        if (stats.printed == 0 && extension == NULL) {
+            write_message("  (empty directory)\n");
+        } else if (stats.printed == 0) {
+            char not_found[MAX_BUFFER];
+            strcpy(not_found, "No files with extension \"");
+            strcat(not_found, extension);
+            strcat(not_found, "\" found in \"");
+            strcat(not_found, dir_name);
+            strcat(not_found, "\".\n");
+            write_message(not_found);
+        }
+        
+        // Summary: shown of read, order, statx calls, time and memory
+        char number[32];
+        char summary[MAX_BUFFER];
+        format_number(number, stats.printed);
+        strcpy(summary, number);
+        strcat(summary, " of ");
+        format_number(number, stats.entries);
+        strcat(summary, number);
+        strcat(summary, extension != NULL ? " matching by " : " entries by ");
+        strcat(summary, sort_names[list.sort]);
+        strcat(summary, ", ");
+        format_number(number, stats.statx_calls);
+        strcat(summary, number);
+        strcat(summary, " statx calls in ");
+        format_decimal(number, elapsed * 1000, 1);
+        strcat(summary, number);
+        strcat(summary, " ms, ");
+        format_number(number, (stats.peak_bytes + 1023) / 1024);
+        strcat(summary, number);
+        strcat(summary, " KiB held");
+        if (stats.errors > 0) {
+            strcat(summary, ", ");
+            format_number(number, stats.errors);
+            strcat(summary, number);
+            strcat(summary, " gone before stat");
+        }
+        
+        if (extension != NULL) {
+            strcpy(log_message, "Listed files with extension \"");
+            strcat(log_message, extension);
+            strcat(log_message, "\" in directory \"");
+        } else {
+            strcpy(log_message, "Listed contents of directory \"");
+        }
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, summary);
+        strcat(log_message, ".");
+        log_operation(log_message, LOG_SUCCESS);
+        return command_exit(EXIT_SUCCESS);
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Function to read listing flags (-R, --sort[=key], --long, --limit=N,
+// --threads=N, ...) starting at
+// argv[*first]; *first is left on the first positional argument
+int parse_list_options(int argc, char *argv[], int *first, ListOptions *options) {
+    memset(options, 0, sizeof(*options));
+    options->depth = -1;
+    
+    while (*first < argc && argv[*first][0] == '-' && argv[*first][1] != '\0') {
+        const char *flag = argv[*first];
+        unsigned long threads, limit;
+        
+        if (strcmp(flag, "-R") == 0) {
+            options->recursive = 1;
+        } else if (strcmp(flag, "--sort") == 0) {
+            options->sorted = 1;
+        } else if (strcmp(flag, "--sort=name") == 0) {
+            options->sorted = 1;
+            options->sort_key = DIRLIST_BY_NAME;
+        } else if (strcmp(flag, "--sort=size") == 0) {
+            options->sort_key = DIRLIST_BY_SIZE;
+        } else if (strcmp(flag, "--sort=mtime") == 0) {
+            options->sort_key = DIRLIST_BY_MTIME;
+        } else if (strcmp(flag, "--long") == 0) {
+            options->long_format = 1;
+        } else if (strncmp(flag, "--limit=", 8) == 0 &&
+                   parse_number(flag + 8, &limit) == 0 && limit > 0) {
+            options->limit = limit;
+        } else if (strcmp(flag, "--index") == 0) {
+            options->indexed = 1;
+            options->recursive = 1;
+            options->sorted = 1;  // Index answers come sorted, so do fallbacks
+        } else if (strncmp(flag, "--threads=", 10) == 0 &&
+                   parse_number(flag + 10, &threads) == 0 && threads > 0) {
+            options->threads = threads;
+        } else {
+            write_message("Unknown option: ");
+            write_message(flag);
+            write_message("\n");
+            return -1;
+        }
+        (*first)++;
+    }
+    return 0;
+}
+
+// Function to read the flags of commands that only take --threads=N and,
+// when recursive isn't NULL, -R; any other flag is an error
+int parse_thread_options(int argc, char *argv[], int *first, int *recursive, int *threads) {
+    if (recursive != NULL) {
+        *recursive = 0;
+    }
+    *threads = 0;
+    
+    while (*first < argc && argv[*first][0] == '-' && argv[*first][1] != '\0') {
+        const char *flag = argv[*first];
+        unsigned long count;
+        
+        if (recursive != NULL && strcmp(flag, "-R") == 0) {
+            *recursive = 1;
+        } else if (strncmp(flag, "--threads=", 10) == 0 &&
+                   parse_number(flag + 10, &count) == 0 && count > 0) {
+            *threads = count;
+        } else {
+            write_message("Unknown option: ");
+            write_message(flag);
+            write_message("\n");
+            return -1;
+        }
+        (*first)++;
+    }
+    return 0;
+}
+
+// Function to read the flags of du (--cache, --depth=N, --threads=N);
+// any other flag is an error
+int parse_du_options(int argc, char *argv[], int *first, ListOptions *options) {
+    memset(options, 0, sizeof(*options));
+    options->depth = -1;
+    
+    while (*first < argc && argv[*first][0] == '-' && argv[*first][1] != '\0') {
+        const char *flag = argv[*first];
+        unsigned long threads, depth;
+        
+        if (strcmp(flag, "--cache") == 0) {
+            options->cached = 1;
+        } else if (strncmp(flag, "--depth=", 8) == 0 && parse_number(flag + 8, &depth) == 0) {
+            options->depth = depth;
+        } else if (strncmp(flag, "--threads=", 10) == 0 &&
+                   parse_number(flag + 10, &threads) == 0 && threads > 0) {
+            options->threads = threads;
+        } else {
+            write_message("Unknown option: ");
+            write_message(flag);
+            write_message("\n");
+            return -1;
+        }
+        (*first)++;
+    }
+    return 0;
+}
+
+// Function to tell whether a listing goes to list_directory_sorted; -1
+// (after saying why) if it asks for a single-directory option with -R
+int list_single_directory(const ListOptions *options) {
+    int single = options->sort_key > DIRLIST_BY_NAME || options->long_format || options->limit > 0;
+    if (options->recursive && single) {
+        write_message("Error: --sort=size, --sort=mtime, --long and --limit list one directory, not -R.\n");
+        return -1;
+    }
+    return single || options->sort_key == DIRLIST_BY_NAME ? !options->recursive : 0;
+}
+
+// Function to build (or rebuild) the extension index of a directory tree
+int index_directory(const char *dir_name, int threads) {
+    char log_message[MAX_BUFFER];
+    IndexStats stats;
+    double start = now_seconds();
+    
+    if (index_build(dir_name, threads, &stats) == -1) {
+        strcpy(log_message, "Error indexing directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    char number[32];
+    strcpy(log_message, "Indexed directory \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\": ");
+    format_number(number, stats.files);
+    strcat(log_message, number);
+    strcat(log_message, " files in ");
+    format_number(number, stats.dirs);
+    strcat(log_message, number);
+    strcat(log_message, " directories (");
+    format_decimal(number, (now_seconds() - start) * 1000, 1);
+    strcat(log_message, number);
+    strcat(log_message, " ms)");
+    if (stats.skipped > 0) {
+        strcat(log_message, ", ");
+        format_number(number, stats.skipped);
+        strcat(log_message, number);
+        strcat(log_message, " names with tabs or newlines skipped");
+    }
+    strcat(log_message, ".");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to keep a directory's extension index current until interrupted
+int watch_directory(const char *dir_name, int threads) {
+    char log_message[MAX_BUFFER];
+    IndexStats stats;
+    
+    strcpy(log_message, "Watching directory \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\" (Ctrl+C to stop).");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    output_flush();
+    log_flush();
+    
+    if (index_watch(dir_name, threads, &stats) == -1) {
+        strcpy(log_message, "Error watching directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    char number[32];
+    strcpy(log_message, "Stopped watching directory \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\": ");
+    format_number(number, stats.events);
+    strcat(log_message, number);
+    strcat(log_message, " events, index written ");
+    format_number(number, stats.writes);
+    strcat(log_message, number);
+    strcat(log_message, " times, ");
+    format_number(number, stats.files);
+    strcat(log_message, number);
+    strcat(log_message, " files indexed");
+    if (!stats.live) {
+        strcat(log_message, " (some directories could not be watched)");
+    }
+    strcat(log_message, ".");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to format a size in bytes as "512B", "4.0K", "12.3M", ...
+int format_size(char *buffer, unsigned long bytes) {
+    const char *units = "BKMGTP";
+    double value = bytes;
+    int unit = 0;
+    while (value >= 1024 && unit < 5) {
+        value /= 1024;
+        unit++;
+    }
+    int len = unit == 0 ? format_number(buffer, bytes) : format_decimal(buffer, value, 1);
+    buffer[len++] = units[unit];
+    buffer[len] = '\0';
+    return len;
+}
+
+// Function to print the disk usage of a tree, one line per directory:
+// size on disk, apparent size, files below it, path
+int disk_usage(const char *dir_name, const ListOptions *options) {
+    char log_message[MAX_BUFFER];
+    char number[32];
+    DuResult result;
+    double start = now_seconds();
+    
+    if (du_scan(dir_name, options->threads, options->cached, &result) == -1) {
+        strcpy(log_message, "Error reading directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    double elapsed = now_seconds() - start;
+    
+    write_message("Disk usage of \"");
+    write_message(dir_name);
+    write_message("\" (on disk, apparent size, files):\n");
+    for (size_t i = 0; i < result.count; i++) {
+        const DuDir *dir = &result.dirs[i];
+        if (options->depth >= 0) {
+            int depth = dir->path[0] != '\0';
+            for (const char *p = dir->path; *p; p++) {
+                depth += *p == '/';
+            }
+            if (depth > options->depth) {
+                continue;
+            }
+        }
+        
+        char line[96];
+        int len = format_size(line, dir->blocks * 512);
+        line[len++] = '\t';
+        len += format_size(line + len, dir->bytes);
+        line[len++] = '\t';
+        len += format_number(line + len, dir->files);
+        line[len++] = '\t';
+        line[len] = '\0';
+        write_message(line);
+        write_message(dir_name);
+        if (dir->path[0] != '\0') {
+            write_message("/");
+            write_message(dir->path);
+        }
+        write_message("\n");
+    }
+    
+    const DuDir *root = &result.dirs[0];
+    strcpy(log_message, "Disk usage of \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\": ");
+    format_number(number, root->bytes);
+    strcat(log_message, number);
+    strcat(log_message, " bytes (");
+    format_size(number, root->blocks * 512);
+    strcat(log_message, number);
+    strcat(log_message, " on disk) in ");
+    format_number(number, root->files);
+    strcat(log_message, number);
+    strcat(log_message, " files and ");
+    format_number(number, root->dirs);
+    strcat(log_message, number);
+    strcat(log_message, " directories; ");
+    format_number(number, result.dirs_read);
+    strcat(log_message, number);
+    strcat(log_message, " read, ");
+    format_number(number, result.dirs_cached);
+    strcat(log_message, number);
+    strcat(log_message, " from cache, ");
+    format_number(number, result.threads);
+    strcat(log_message, number);
+    strcat(log_message, result.threads == 1 ? " thread, " : " threads, ");
+    format_decimal(number, elapsed * 1000, 1);
+    strcat(log_message, number);
+    strcat(log_message, " ms.");
+    log_operation(log_message, LOG_SUCCESS);
+    
+    du_free(&result);
+    return 0;
+}
+
+// Function to print the content hash of each file, "hash  name" like
+// sha256sum; big files are hashed in chunks by several threads
+int hash_file_list(char *paths[], int count, int threads) {
+    char log_message[MAX_BUFFER];
+    char number[32];
+    HashStats stats;
+    double start = now_seconds();
+    
+    HashFile *files = calloc(count, sizeof(HashFile));
+    if (files == NULL) {
+        write_message("Error: out of memory.\n");
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        struct stat st;
+        files[i].path = paths[i];
+        if (stat(paths[i], &st) == -1) {
+            files[i].error = errno;
+        } else if (S_ISDIR(st.st_mode)) {
+            files[i].error = EISDIR;
+        } else {
+            files[i].size = st.st_size;
+        }
+    }
+    
+    if (hash_files(AT_FDCWD, files, count, threads, &stats) == -1) {
+        write_message("Error: out of memory.\n");
+        free(files);
+        return -1;
+    }
+    double elapsed = now_seconds() - start;
+    
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        if (files[i].error != 0) {
+            strcpy(log_message, "Error hashing \"");
+            strcat(log_message, paths[i]);
+            strcat(log_message, "\": ");
+            strcat(log_message, strerror(files[i].error));
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            failed = 1;
+            continue;
+        }
+        char hash[HASH_HEX_LEN + 1];
+        hash_format(hash, files[i].hash);
+        write_message(hash);
+        write_message("  ");
+        write_message(paths[i]);
+        write_message("\n");
+    }
+    
+    strcpy(log_message, "Hashed ");
+    format_number(number, stats.files);
+    strcat(log_message, number);
+    strcat(log_message, stats.files == 1 ? " file (" : " files (");
+    format_number(number, stats.bytes);
+    strcat(log_message, number);
+    strcat(log_message, " bytes) in ");
+    format_decimal(number, elapsed * 1000, 1);
+    strcat(log_message, number);
+    strcat(log_message, " ms, ");
+    format_decimal(number, elapsed > 0 ? stats.bytes / elapsed / (1024 * 1024) : 0, 1);
+    strcat(log_message, number);
+    strcat(log_message, " MB/s, ");
+    format_number(number, stats.threads);
+    strcat(log_message, number);
+    strcat(log_message, stats.threads == 1 ? " thread." : " threads.");
+    log_operation(log_message, failed ? LOG_FAILURE : LOG_SUCCESS);
+    
+    free(files);
+    return failed ? -1 : 0;
+}
+
+// Function to list groups of files with the same content under a tree:
+// size, copies and hash, then the files of the group
+int find_duplicate_files(const char *dir_name, int threads) {
+    char log_message[MAX_BUFFER];
+    char number[32];
+    DupResult result;
+    double start = now_seconds();
+    
+    if (find_duplicates(dir_name, threads, &result) == -1) {
+        strcpy(log_message, "Error reading directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    double elapsed = now_seconds() - start;
+    
+    write_message("Duplicate files in \"");
+    write_message(dir_name);
+    write_message("\" (");
+    format_number(number, result.groups);
+    write_message(number);
+    write_message(result.groups == 1 ? " group, " : " groups, ");
+    format_size(number, result.reclaimable);
+    write_message(number);
+    write_message(" reclaimable):\n");
+    for (size_t i = 0; i < result.count;) {
+        size_t end = i + 1;
+        while (end < result.count && result.files[end].size == result.files[i].size &&
+               result.files[end].hash == result.files[i].hash) {
+            end++;
+        }
+        
+        char line[96];
+        int len = format_size(line, result.files[i].size);
+        line[len++] = '\t';
+        len += format_number(line + len, end - i);
+        strcpy(line + len, " copies\t");
+        len += 8;
+        hash_format(line + len, result.files[i].hash);
+        write_message(line);
+        write_message("\n");
+        for (; i < end; i++) {
+            write_message("\t");
+            write_message(dir_name);
+            write_message("/");
+            write_message(result.files[i].path);
+            write_message("\n");
+        }
+    }
+    
+    strcpy(log_message, "Found ");
+    format_number(number, result.groups);
+    strcat(log_message, number);
+    strcat(log_message, " groups of duplicate files in \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\": ");
+    format_number(number, result.count);
+    strcat(log_message, number);
+    strcat(log_message, " files, ");
+    format_number(number, result.reclaimable);
+    strcat(log_message, number);
+    strcat(log_message, " bytes reclaimable; ");
+    format_number(number, result.hash.files);
+    strcat(log_message, number);
+    strcat(log_message, " of ");
+    format_number(number, result.scanned);
+    strcat(log_message, number);
+    strcat(log_message, " files hashed (");
+    format_number(number, result.hash.bytes);
+    strcat(log_message, number);
+    strcat(log_message, " bytes), ");
+    if (result.errors > 0) {
+        format_number(number, result.errors);
+        strcat(log_message, number);
+        strcat(log_message, " unreadable, ");
+    }
+    format_number(number, result.hash.threads);
+    strcat(log_message, number);
+    strcat(log_message, result.hash.threads == 1 ? " thread, " : " threads, ");
+    format_decimal(number, elapsed * 1000, 1);
+    strcat(log_message, number);
+    strcat(log_message, " ms.");
+    log_operation(log_message, LOG_SUCCESS);
+    
+    dup_free(&result);
+    return 0;
+}
+
+// Function to print the lines holding pattern in the files under a tree,
+// "path:line:text" like grep -rn
+int search_files(const char *dir_name, const char *pattern, const char *extension, int threads) {
+    char log_message[MAX_BUFFER];
+    char number[32];
+    SearchOptions options = { extension, threads };
+    SearchStats stats;
+    double start = now_seconds();
+    
+    if (search_tree(dir_name, pattern, &options, &stats) == -1) {
+        strcpy(log_message, "Error reading directory \"");
+        strcat(log_message, dir_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    double elapsed = now_seconds() - start;
+    
+    strcpy(log_message, "Searched \"");
+    strcat(log_message, dir_name);
+    strcat(log_message, "\" for \"");
+    strncat(log_message, pattern, 256);
+    strcat(log_message, "\"");
+    if (extension != NULL) {
+        strcat(log_message, " in \"");
+        strcat(log_message, extension);
+        strcat(log_message, "\" files");
+    }
+    strcat(log_message, ": ");
+    format_number(number, stats.lines);
+    strcat(log_message, number);
+    strcat(log_message, " lines in ");
+    format_number(number, stats.matched);
+    strcat(log_message, number);
+    strcat(log_message, " of ");
+    format_number(number, stats.files);
+    strcat(log_message, number);
+    strcat(log_message, " files (");
+    format_number(number, stats.bytes);
+    strcat(log_message, number);
+    strcat(log_message, " bytes), ");
+    if (stats.binary > 0) {
+        format_number(number, stats.binary);
+        strcat(log_message, number);
+        strcat(log_message, " binary skipped, ");
+    }
+    if (stats.errors > 0) {
+        format_number(number, stats.errors);
+        strcat(log_message, number);
+        strcat(log_message, " unreadable, ");
+    }
+    format_number(number, stats.threads);
+    strcat(log_message, number);
+    strcat(log_message, stats.threads == 1 ? " thread, " : " threads, ");
+    format_decimal(number, elapsed * 1000, 1);
+    strcat(log_message, number);
+    strcat(log_message, " ms.");
+    log_operation(log_message, LOG_SUCCESS);
+    
+    if (stats.lines == 0) {
+        write_message("No matches for \"");
+        write_message(pattern);
+        write_message("\".\n");
+    }
+    return 0;
+}
+
+// Function to read file content, optionally only `length` bytes from `offset`
+// (length -1 means up to the end of the file)
+int read_file(const char *file_name, off_t offset, off_t length) {
+    char log_message[MAX_BUFFER];
+    struct stat st;
+    
+    // Check if file exists
+    if (stat(file_name, &st) == -1) {
+        strcpy(log_message, "Error: File \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\" not found.");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        strcpy(log_message, "Error opening file \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+    
+    char file_msg[MAX_BUFFER];
+    strcpy(file_msg, "Contents of file \"");
+    strcat(file_msg, file_name);
+    strcat(file_msg, "\":\n");
+    write_message(file_msg);
+    
+    // The bytes go to stdout behind the buffer's back, so empty it first
+    output_flush();
+    
+    char last = '\n';
+    ssize_t moved;
+    
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        // Known size: copy the range in the kernel where possible
+        off_t end = st.st_size;
+        if (offset > end) {
+            offset = end;
+        }
+        if (length >= 0 && length < end - offset) {
+            end = offset + length;
+        }
+        moved = transfer_range(fd, offset, end - offset, output_fd());
+        if (moved > 0) {
+            pread(fd, &last, 1, offset + moved - 1);
+        }
+    } else {
+        // Pipes, devices and /proc files have no usable size
+        moved = transfer_stream(fd, offset, length, output_fd(), &last);
+    }
+    
+    if (moved == -1) {
+        strcpy(log_message, "Error reading file \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message("\n");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        close(fd);
+        return -1;
+    }
+    
+    // Add a newline if the file doesn't end with one
+    if (last != '\n') {
+        write_message("\n");
+    }
+    
+    close(fd);
+    strcpy(log_message, "Read contents of file \"");
+    strcat(log_message, file_name);
+    if (offset > 0 || length >= 0) {
+        char number[32];
+        strcat(log_message, "\" (");
+        format_number(number, moved);
+        strcat(log_message, number);
+        strcat(log_message, " bytes from offset ");
+        format_number(number, offset);
+        strcat(log_message, number);
+        strcat(log_message, ").");
+    } else {
+        strcat(log_message, "\".");
+    }
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to print the end of a file and then whatever is appended to
+// it, until interrupted
+int follow_file_command(const char *file_name, unsigned long lines) {
+    char log_message[MAX_BUFFER];
+    FollowStats stats;
+    struct stat st;
+    
+    if (stat(file_name, &st) == -1) {
+        strcpy(log_message, "Error: File \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\" not found.");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    strcpy(log_message, "Following file \"");
+    strcat(log_message, file_name);
+    strcat(log_message, "\" (Ctrl+C to stop):\n");
+    write_message(log_message);
+    
+    if (follow_file(file_name, lines, &stats) == -1) {
+        strcpy(log_message, "Error following file \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, errno == EINVAL ? "not a regular file" : strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    char number[32];
+    strcpy(log_message, "Followed file \"");
+    strcat(log_message, file_name);
+    strcat(log_message, "\": ");
+    format_number(number, stats.bytes);
+    strcat(log_message, number);
+    strcat(log_message, " bytes appended, ");
+    format_number(number, stats.wakeups);
+    strcat(log_message, number);
+    strcat(log_message, " wakeups, ");
+    format_number(number, stats.truncations);
+    strcat(log_message, number);
+    strcat(log_message, " truncations, ");
+    format_number(number, stats.rotations);
+    strcat(log_message, number);
+    strcat(log_message, " rotations.");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Options for appendToFile
+typedef struct {
+    long wait_ms;           // --wait=MS: how long to wait for the lock (0 = not at all)
+    int from_stdin;         // --stdin: the content comes from stdin
+    const char *coalesce;   // --coalesce=FIFO: queue it with an appendDaemon
+} AppendOptions;
+
+// Function to take an exclusive lock, waiting up to wait_ms for it.
+// Waits back off exponentially with jitter so waiting appenders don't
+// retry in lockstep.
+int lock_exclusive(int fd, long wait_ms) {
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+        return 0;
+    }
+    if (errno != EWOULDBLOCK || wait_ms <= 0) {
+        return -1;
+    }
+    
+    double deadline = now_seconds() + wait_ms / 1000.0;
+    long delay_us = 100;
+    // Per thread, not just per process: serve's workers share one pid
+    struct timespec clock_now;
+    clock_gettime(CLOCK_MONOTONIC, &clock_now);
+    unsigned int seed = getpid() ^ gettid() ^ clock_now.tv_nsec;
+    
+    for (;;) {
+        double left = deadline - now_seconds();
+        if (left <= 0) {
+            errno = EWOULDBLOCK;
+            return -1;
+        }
+        long sleep_us = delay_us + rand_r(&seed) % delay_us;
+        if (sleep_us > left * 1e6) {
+            sleep_us = left * 1e6 + 1;
+        }
+        struct timespec pause = { sleep_us / 1000000, (sleep_us % 1000000) * 1000 };
+        nanosleep(&pause, NULL);
+        
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+            return 0;
+        }
+        if (errno != EWOULDBLOCK) {
+            return -1;
+        }
+        if (delay_us < 20000) {
+            delay_us *= 2;
+        }
+    }
+}
+
+// Function to write a whole iovec array, continuing after short writes
+int write_vector(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+// Function to append content (or stdin when content is NULL) to a file
+int append_to_file(const char *file_name, const char *content, const AppendOptions *options) {
+    char log_message[MAX_BUFFER];
+    struct stat st;
+    
+    // Check if file exists
+    if (stat(file_name, &st) == -1) {
+        strcpy(log_message, "Error: File \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\" not found.");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    // Content and its newline go out together: one writev, or one record
+    size_t content_len = content != NULL ? strlen(content) : 0;
+    struct iovec iov[2] = {
+        { (void *)content, content_len },
+        { "\n", 1 },
+    };
+    int iov_count = content_len > 0 && content[content_len - 1] == '\n' ? 1 : 2;
+    
+    if (content != NULL && options->coalesce != NULL) {
+        char record[COALESCE_RECORD_MAX];
+        if (content_len + 1 <= sizeof(record)) {
+            memcpy(record, content, content_len);
+            record[content_len] = '\n';
+            if (coalesce_submit(options->coalesce, file_name, record, content_len + iov_count - 1) == 0) {
+                strcpy(log_message, "Queued append to file \"");
+                strcat(log_message, file_name);
+                strcat(log_message, "\".");
+                write_message(log_message);
+                write_message("\n");
+                log_operation(log_message, LOG_SUCCESS);
+                return 0;
+            }
+        }
+        // No daemon or too big for one record: append it ourselves
+    }
+    
+    int fd = open(file_name, O_WRONLY | O_APPEND);
+    if (fd == -1) {
+        strcpy(log_message, "Error opening file \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    // Get an exclusive lock, waiting for it if asked to
+    if (lock_exclusive(fd, options->wait_ms) == -1) {
+        strcpy(log_message, "Error: Cannot write to \"");
+        strcat(log_message, file_name);
+        if (options->wait_ms > 0) {
+            char number[32];
+            format_number(number, options->wait_ms);
+            strcat(log_message, "\". File is still locked after ");
+            strcat(log_message, number);
+            strcat(log_message, " ms.");
+        } else {
+            strcat(log_message, "\". File is locked or read-only.");
+        }
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        close(fd);
+        return -1;
+    }
+    
+    int failed;
+    ssize_t streamed = 0;
+    if (content != NULL) {
+        failed = write_vector(fd, iov, iov_count) == -1;
+    } else {
+        // Stream stdin through under the lock, then end the last line
+        char last = '\n';
+        streamed = transfer_stream(STDIN_FILENO, 0, -1, fd, &last);
+        failed = streamed == -1 || (last != '\n' && write_vector(fd, iov + 1, 1) == -1);
+    }
+    
+    if (failed) {
+        strcpy(log_message, "Error writing to file \"");
+        strcat(log_message, file_name);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        flock(fd, LOCK_UN);  // Release the lock
+        close(fd);
+        return -1;
+    }
+    
+    flock(fd, LOCK_UN);  // Release the lock
+    close(fd);
+    
+    strcpy(log_message, "Successfully appended ");
+    if (content == NULL) {
+        char number[32];
+        format_number(number, streamed);
+        strcat(log_message, number);
+        strcat(log_message, " bytes from stdin ");
+    }
+    strcat(log_message, "to file \"");
+    strcat(log_message, file_name);
+    strcat(log_message, "\".");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to run the append-coalescing daemon on a FIFO until interrupted
+int run_append_daemon(const char *fifo) {
+    char log_message[MAX_BUFFER];
+    CoalesceStats stats;
+    
+    strcpy(log_message, "Append daemon listening on \"");
+    strcat(log_message, fifo);
+    strcat(log_message, "\" (Ctrl+C to stop).");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    output_flush();
+    log_flush();
+    
+    if (coalesce_serve(fifo, &stats) == -1) {
+        strcpy(log_message, "Error serving \"");
+        strcat(log_message, fifo);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    char number[32];
+    strcpy(log_message, "Append daemon on \"");
+    strcat(log_message, fifo);
+    strcat(log_message, "\" stopped: ");
+    format_number(number, stats.records);
+    strcat(log_message, number);
+    strcat(log_message, " appends in ");
+    format_number(number, stats.writes);
+    strcat(log_message, number);
+    strcat(log_message, " writes (");
+    format_number(number, stats.batches);
+    strcat(log_message, number);
+    strcat(log_message, " batches)");
+    if (stats.failed > 0) {
+        strcat(log_message, ", ");
+        format_number(number, stats.failed);
+        strcat(log_message, number);
+        strcat(log_message, " failed");
+    }
+    strcat(log_message, ".");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, stats.failed == 0 ? LOG_SUCCESS : LOG_FAILURE);
+    return stats.failed == 0 ? 0 : -1;
+}
+
+int run_command(int argc, char *argv[]);
+
+// Function to run one command for a serve client on a worker thread; its
+// output goes to the client's reply FIFO. Commands that run until stopped
+// or read our stdin are refused.
+int serve_command(int reply_fd, int argc, char *argv[]) {
+    int status = 1;
+    output_set_fd(reply_fd);
+    
+    const char *refused = NULL;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[1], "appendToFile") == 0 && strcmp(argv[i], "--stdin") == 0) {
+            refused = " --stdin";
+        } else if (strcmp(argv[1], "readFile") == 0 && strcmp(argv[i], "--follow") == 0) {
+            refused = " --follow";
+        }
+    }
+    if (strcmp(argv[1], "serve") == 0 || strcmp(argv[1], "appendDaemon") == 0 ||
+        strcmp(argv[1], "watch") == 0 || strcmp(argv[1], "batch") == 0 || refused) {
+        write_message("Error: ");
+        write_message(argv[1]);
+        write_message(refused ? refused : "");
+        write_message(" cannot run inside serve.\n");
+    } else {
+        status = run_command(argc, argv);
+    }
+    output_flush();
+    return status;
+}
+
+// Function to run commands sent to a FIFO on a pool of worker threads,
+// in this process, until interrupted
+int run_server(const char *fifo, int threads) {
+    char log_message[MAX_BUFFER];
+    ServeStats stats;
+    
+    strcpy(log_message, "Serving commands on \"");
+    strcat(log_message, fifo);
+    strcat(log_message, "\" (Ctrl+C to stop).");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    output_flush();
+    log_flush();
+    
+    in_process = 1;
+    int served = serve_run(fifo, threads, serve_command, &stats);
+    in_process = 0;
+    if (served == -1) {
+        strcpy(log_message, "Error serving \"");
+        strcat(log_message, fifo);
+        strcat(log_message, "\": ");
+        strcat(log_message, strerror(errno));
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    char number[32];
+    strcpy(log_message, "Server on \"");
+    strcat(log_message, fifo);
+    strcat(log_message, "\" stopped: ");
+    format_number(number, stats.requests);
+    strcat(log_message, number);
+    strcat(log_message, " commands (");
+    format_number(number, stats.failed);
+    strcat(log_message, number);
+    strcat(log_message, " failed) on ");
+    format_number(number, stats.threads);
+    strcat(log_message, number);
+    strcat(log_message, stats.threads == 1 ? " thread" : " threads");
+    if (stats.dropped > 0) {
+        strcat(log_message, ", ");
+        format_number(number, stats.dropped);
+        strcat(log_message, number);
+        strcat(log_message, " dropped (client gone)");
+    }
+    strcat(log_message, ".");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to report a failed copy or move and log it
+int copy_error(const char *action, const char *source, const char *target, int err) {
+    char log_message[MAX_BUFFER];
+    strcpy(log_message, "Error ");
+    strcat(log_message, action);
+    strcat(log_message, " \"");
+    strcat(log_message, source);
+    strcat(log_message, "\" to \"");
+    strcat(log_message, target);
+    strcat(log_message, "\": ");
+    strcat(log_message, strerror(err));
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_FAILURE);
+    return -1;
+}
+
+// Function to resolve a copy/move target: into a directory keeps the name
+const char *target_path(const char *source, const char *target, char *buffer, size_t size) {
+    struct stat st;
+    if (stat(target, &st) == -1 || !S_ISDIR(st.st_mode)) {
+        return target;
+    }
+    
+    const char *name = strrchr(source, '/');
+    name = name ? name + 1 : source;
+    if (strlen(target) + strlen(name) + 2 > size) {
+        return target;
+    }
+    strcpy(buffer, target);
+    if (buffer[strlen(buffer) - 1] != '/') {
+        strcat(buffer, "/");
+    }
+    strcat(buffer, name);
+    return buffer;
+}
+
+// Function to copy a regular file's bytes and mode to a new file; a
+// failed copy leaves no target behind. Returns 0 or -1 with errno set.
+int copy_contents(const char *source, const char *target, int threads, off_t *bytes,
+                  TransferFileStats *stats) {
+    struct stat st;
+    int in_fd = open(source, O_RDONLY);
+    if (in_fd == -1) {
+        return -1;
+    }
+    int err = 0;
+    if (fstat(in_fd, &st) == -1) {
+        err = errno;
+    } else if (!S_ISREG(st.st_mode)) {
+        err = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+    }
+    if (err != 0) {
+        close(in_fd);
+        errno = err;
+        return -1;
+    }
+    
+    int out_fd = open(target, O_WRONLY | O_CREAT | O_EXCL, st.st_mode & 07777);
+    if (out_fd == -1) {
+        err = errno;
+        close(in_fd);
+        errno = err;
+        return -1;
+    }
+    fchmod(out_fd, st.st_mode & 07777);  // The umask may have cut it
+    
+    // Appenders hold LOCK_EX, so no append lands halfway through the copy
+    flock(in_fd, LOCK_SH);
+    int result = transfer_file(in_fd, out_fd, st.st_size, walk_threads(threads), stats);
+    err = errno;
+    flock(in_fd, LOCK_UN);
+    
+    close(in_fd);
+    if (close(out_fd) == -1 && result == 0) {
+        result = -1;
+        err = errno;
+    }
+    if (result == -1) {
+        unlink(target);
+        errno = err;
+        return -1;
+    }
+    *bytes = st.st_size;
+    return 0;
+}
+
+// Function to log a finished copy: bytes, method, threads and MB/s
+void log_copy(const char *what, const char *source, const char *target, off_t bytes,
+              const TransferFileStats *stats, double elapsed) {
+    char log_message[MAX_BUFFER];
+    char number[32];
+    strcpy(log_message, what);
+    strcat(log_message, " \"");
+    strcat(log_message, source);
+    strcat(log_message, "\" to \"");
+    strcat(log_message, target);
+    strcat(log_message, "\" (");
+    format_number(number, bytes);
+    strcat(log_message, number);
+    strcat(log_message, " bytes, ");
+    strcat(log_message, stats->method);
+    if (stats->threads > 1) {
+        strcat(log_message, ", ");
+        format_number(number, stats->threads);
+        strcat(log_message, number);
+        strcat(log_message, " threads");
+    }
+    strcat(log_message, ", ");
+    format_decimal(number, elapsed > 0 ? bytes / elapsed / (1024 * 1024) : 0, 1);
+    strcat(log_message, number);
+    strcat(log_message, " MB/s).");
+    write_message(log_message);
+    write_message("\n");
+    log_operation(log_message, LOG_SUCCESS);
+}
+
+// Function to copy a file (into a directory if target is one)
+int copy_file(const char *source, const char *target, int threads) {
+    char buffer[MAX_BUFFER];
+    TransferFileStats stats;
+    off_t bytes;
+    double start = now_seconds();
+    
+    target = target_path(source, target, buffer, sizeof(buffer));
+    if (copy_contents(source, target, threads, &bytes, &stats) == -1) {
+        return copy_error("copying", source, target, errno);
+    }
+    log_copy("Copied file", source, target, bytes, &stats, now_seconds() - start);
+    return 0;
+}
+
+// Function to move a file: a rename on the same file system, a copy and
+// unlink across file systems. An existing target is never replaced.
+int move_file(const char *source, const char *target, int threads) {
+    char buffer[MAX_BUFFER];
+    char log_message[MAX_BUFFER];
+    double start = now_seconds();
+    
+    target = target_path(source, target, buffer, sizeof(buffer));
+    int renamed = syscall(SYS_renameat2, AT_FDCWD, source, AT_FDCWD, target, RENAME_NOREPLACE);
+    if (renamed == -1 && errno == EINVAL) {
+        // No RENAME_NOREPLACE on this file system: check, then rename
+        struct stat st;
+        if (lstat(target, &st) == 0) {
+            return copy_error("moving", source, target, EEXIST);
+        }
+        renamed = syscall(SYS_renameat, AT_FDCWD, source, AT_FDCWD, target);
+    }
+    
+    if (renamed == 0) {
+        strcpy(log_message, "Moved \"");
+        strcat(log_message, source);
+        strcat(log_message, "\" to \"");
+        strcat(log_message, target);
+        strcat(log_message, "\" (renamed).");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_SUCCESS);
+        return 0;
+    }
+    if (errno != EXDEV) {
+        return copy_error("moving", source, target, errno);
+    }
+    
+    // Another file system: the copy must be on disk before the source goes
+    TransferFileStats stats;
+    off_t bytes;
+    if (copy_contents(source, target, threads, &bytes, &stats) == -1) {
+        return copy_error("moving", source, target, errno);
+    }
+    int fd = open(target, O_RDONLY);
+    if (fd == -1 || fsync(fd) == -1 || unlink(source) == -1) {
+        int err = errno;
+        if (fd != -1) {
+            close(fd);
+        }
+        return copy_error("moving", source, target, err);
+    }
+    close(fd);
+    log_copy("Moved file", source, target, bytes, &stats, now_seconds() - start);
+    return 0;
+}
+
+// Function to delete a file
+int delete_file(const char *file_name) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        char log_message[MAX_BUFFER];
+        struct stat st = {0};
+        
+        // Check if file exists
+        if (stat(file_name, &st) == -1) {
+            strcpy(log_message, "Error: File \"");
+            strcat(log_message, file_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        // Delete file
+        if (unlink(file_name) == 0) {
+            strcpy(log_message, "File \"");
+            strcat(log_message, file_name);
+            strcat(log_message, "\" deleted successfully.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_SUCCESS);
+            return command_exit(EXIT_SUCCESS);
+        } else {
+            strcpy(log_message, "Error deleting file \"");
+            strcat(log_message, file_name);
+            strcat(log_message, "\": ");
+            strcat(log_message, strerror(errno));
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Function to delete a directory
+int delete_directory(const char *dir_name) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        char log_message[MAX_BUFFER];
+        DIR *dir;
+        struct dirent *entry;
+        int is_empty = 1;
+        
+        dir = opendir(dir_name);
+        if (dir == NULL) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        // Check if directory is empty
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                is_empty = 0;
+                break;
+            }
+        }
+        
+        closedir(dir);
+        
+        if (!is_empty) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" is not empty.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        // Delete the empty directory
+        if (rmdir(dir_name) == 0) {
+            strcpy(log_message, "Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" deleted successfully.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_SUCCESS);
+            return command_exit(EXIT_SUCCESS);
+        } else {
+            strcpy(log_message, "Error deleting directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\": ");
+            strcat(log_message, strerror(errno));
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Counters for one recursive delete, padded per walker thread
+typedef struct {
+    unsigned long files;
+    unsigned long dirs;
+    unsigned long failed;
+    int first_errno;
+    char pad[36];
+} DeleteCounts;
+
+// Walker callback: unlink everything that is not a directory right away
+int delete_visit(int worker, int dfd, const char *path, size_t path_len,
+                 const char *name, unsigned char type, void *arg) {
+    DeleteCounts *counts = (DeleteCounts *)arg + worker;
+    (void)path;
+    (void)path_len;
+    
+    if (type == DT_DIR) {
+        return 1;  // Emptied by the walk, removed when it is left
+    }
+    if (unlinkat(dfd, name, 0) == 0) {
+        counts->files++;
+    } else {
+        if (counts->failed++ == 0) {
+            counts->first_errno = errno;
+        }
+    }
+    return 0;
+}
+
+// Walker callback: a directory and everything below it is done
+void delete_leave(int worker, int root_fd, const char *path, void *arg) {
+    DeleteCounts *counts = (DeleteCounts *)arg + worker;
+    
+    if (path[0] == '\0') {
+        return;  // The root itself is removed by delete_tree
+    }
+    if (unlinkat(root_fd, path, AT_REMOVEDIR) == 0) {
+        counts->dirs++;
+    } else {
+        if (counts->failed++ == 0) {
+            counts->first_errno = errno;
+        }
+    }
+}
+
+// Function to delete a directory and everything in it: files are unlinked
+// in parallel as the walker finds them, directories bottom-up
+int delete_tree(const char *dir_name, int threads) {
+    pid_t pid = command_fork();
+    
+    if (pid < 0) {
+        write_message("Fork failed\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (pid == 0) {  // Child process
+        char log_message[MAX_BUFFER];
+        struct stat st;
+        
+        if (lstat(dir_name, &st) == -1 || !S_ISDIR(st.st_mode)) {
+            strcpy(log_message, "Error: Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" not found.");
+            write_message(log_message);
+            write_message("\n");
+            log_operation(log_message, LOG_FAILURE);
+            return command_exit(EXIT_FAILURE);
+        }
+        
+        DeleteCounts counts[WALK_MAX_THREADS];
+        memset(counts, 0, sizeof(counts));
+        WalkOptions walk = { threads, delete_visit, counts, delete_leave };
+        WalkStats stats;
+        double start = now_seconds();
+        walk_tree(dir_name, &walk, &stats);
+        
+        unsigned long files = 0, dirs = 0, failed = stats.errors;
+        int first_errno = 0;
+        for (int i = 0; i < WALK_MAX_THREADS; i++) {
+            files += counts[i].files;
+            dirs += counts[i].dirs;
+            failed += counts[i].failed;
+            if (first_errno == 0) {
+                first_errno = counts[i].first_errno;
+            }
+        }
+        if (rmdir(dir_name) == 0) {
+            dirs++;
+        } else {
+            if (first_errno == 0) {
+                first_errno = errno;
+            }
+            failed++;
+        }
+        double elapsed = now_seconds() - start;
+        
+        // One summary line for the whole tree instead of one per file
+        char number[32];
+        if (failed == 0) {
+            strcpy(log_message, "Directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" deleted recursively: ");
+        } else {
+            strcpy(log_message, "Error deleting directory \"");
+            strcat(log_message, dir_name);
+            strcat(log_message, "\" recursively (");
+            format_number(number, failed);
+            strcat(log_message, number);
+            strcat(log_message, " failed, first: ");
+            strcat(log_message, strerror(first_errno));
+            strcat(log_message, "): ");
+        }
+        format_number(number, files);
+        strcat(log_message, number);
+        strcat(log_message, " files and ");
+        format_number(number, dirs);
+        strcat(log_message, number);
+        strcat(log_message, " directories removed by ");
+        format_number(number, stats.threads);
+        strcat(log_message, number);
+        strcat(log_message, " threads in ");
+        format_decimal(number, elapsed * 1000, 1);
+        strcat(log_message, number);
+        strcat(log_message, " ms (");
+        format_number(number, (unsigned long)(elapsed > 0 ? files / elapsed : 0));
+        strcat(log_message, number);
+        strcat(log_message, " files/sec).");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, failed == 0 ? LOG_SUCCESS : LOG_FAILURE);
+        return command_exit(failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    } else {  // Parent process
+        int status;
+        waitpid(pid, &status, 0);  // Wait for child process to complete
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    }
+}
+
+// Function to show logs, or the part of them a query selects
+int show_logs(const LogQuery *query) {
+    char log_message[MAX_BUFFER];
+    struct stat st;
+    
+    // Records still in our buffer belong in the output too
+    log_flush();
+    
+    // Check if log file exists
+    if (stat(log_get_format() == LOG_FORMAT_BINARY ? LOG_BINARY_FILE : LOG_FILE, &st) == -1) {
+        write_message("No logs found. Log file does not exist yet.\n");
+        return 0;
+    }
+    
+    write_message(query->summary ? "Operations per hour:\n" : "Operation Logs:\n");
+    LogQueryStats stats;
+    if (log_query(query, &stats) == -1) {
+        write_message("Error reading log file: ");
+        write_message(strerror(errno));
+        write_message("\n");
+        return -1;
+    }
+    
+    int filtered = query->since || query->until || query->tail || query->grep || query->summary;
+    strcpy(log_message, "Displayed operation logs");
+    if (filtered) {
+        char number[32];
+        strcat(log_message, ": ");
+        format_number(number, stats.bytes);
+        strcat(log_message, number);
+        strcat(log_message, " bytes");
+        if (query->since || query->until) {
+            strcat(log_message, ", ");
+            format_number(number, stats.probes);
+            strcat(log_message, number);
+            strcat(log_message, " timestamps probed");
+        }
+        strcat(log_message, ", ");
+        format_number(number, stats.segments);
+        strcat(log_message, number);
+        strcat(log_message, stats.segments == 1 ? " file" : " files");
+    }
+    strcat(log_message, ".");
+    log_operation(log_message, LOG_SUCCESS);
+    return 0;
+}
+
+// Function to display help
+void display_help() {
+    write_message("Usage: fileManager <command> [arguments]\n");
+    write_message("Commands:\n");
+    write_message("  createDir \"folderName\"                      - Create a new directory\n");
+    write_message("  createFile \"fileName\"                       - Create a new file\n");
+    write_message("  createFiles [--sync] \"folderName\" N|\"list\"  - Create N files (or one per line of list)\n");
+    write_message("  listDir [-R] [--sort] \"folderName\"          - List all files in a directory (-R: whole tree)\n");
+    write_message("  listDir [--sort=name|size|mtime] [--long] [--limit=N] \"folderName\"\n");
+    write_message("                                              - One directory sorted, with sizes and times, first N\n");
+    write_message("  listFilesByExtension [-R] [--sort] [--index] \"folderName\" \".txt\"\n");
+    write_message("                                              - List files with specific extension\n");
+    write_message("                                                (also takes --sort=key, --long, --limit=N)\n");
+    write_message("                                                (--index: answer from the index)\n");
+    write_message("  indexDir \"folderName\"                       - Build or rebuild the extension index\n");
+    write_message("  watch \"folderName\"                          - Keep the index current with inotify\n");
+    write_message("  du [--depth=N] [--cache] \"folderName\"       - Size of a tree, per directory\n");
+    write_message("  hashFile \"fileName\" ...                     - Print the content hash of files\n");
+    write_message("  findDuplicates \"folderName\"                - List files with the same content\n");
+    write_message("  searchFiles \"folderName\" \"text\" [--ext .txt] - Print the lines holding text\n");
+    write_message("  readFile \"fileName\" [offset [length]]       - Read a file's content (or a byte range)\n");
+    write_message("  readFile --follow [--lines=N] \"fileName\"    - Print the end, then what is appended\n");
+    write_message("  appendToFile [--wait=MS] [--coalesce=FIFO] \"fileName\" \"new content\"\n");
+    write_message("                                              - Append content to a file\n");
+    write_message("  appendToFile [--wait=MS] --stdin \"fileName\" - Append everything read from stdin\n");
+    write_message("  appendDaemon \"fifo\"                         - Batch appends queued with --coalesce\n");
+    write_message("  copyFile [--threads=N] \"source\" \"target\"    - Copy a file, keeping its mode\n");
+    write_message("  moveFile \"source\" \"target\"                 - Move or rename a file\n");
+    write_message("  deleteFile \"fileName\"                       - Delete a file\n");
+    write_message("  deleteDir [-R] \"folderName\"                 - Delete an empty directory (-R: and its contents)\n");
+    write_message("  showLogs [--since=TIME] [--until=TIME] [--tail=N] [--grep=TEXT] [--summary]\n");
+    write_message("                                              - Display operation logs (or part of them)\n");
+    write_message("                                                (--summary: records per hour and command,\n");
+    write_message("                                                binary log only)\n");
+    write_message("  batch \"script\" | -                          - Run commands from a script or stdin\n");
+    write_message("  serve [--threads=N] \"fifo\"                 - Run commands sent with --server=fifo\n");
+    write_message("Options (before the command):\n");
+    write_message("  --log-sync=never|batch|record               - When log records are fsync'ed\n");
+    write_message("  --log-rotate=SIZE|hourly|daily              - When log.txt becomes a segment (SIZE: 64M, 500K)\n");
+    write_message("  --log-compress                              - Gzip segments once a newer one exists\n");
+    write_message("  --log-format=text|binary                    - Log to log.txt or fixed-size records in log.bin\n");
+    write_message("  --output-buffer=BYTES                       - Stdout buffer size (0 = unbuffered)\n");
+    write_message("  --transfer=auto|mmap|copy                   - How readFile moves file bytes\n");
+    write_message("  --server=FIFO                               - Send the command to a running serve\n");
+}
+
+// Function to run one command, argv[1] is the command name
+int dispatch_command(int argc, char *argv[]) {
+    int result = 0;
+    
+    // Check command
+    if (strcmp(argv[1], "createDir") == 0) {
+        if (argc != 3) {
+            write_message("Error: createDir requires one argument.\n");
+            return 1;
+        }
+        result = create_directory(argv[2]);
+    }
+    else if (strcmp(argv[1], "createFile") == 0) {
+        if (argc != 3) {
+            write_message("Error: createFile requires one argument.\n");
+            return 1;
+        }
+        result = create_file(argv[2]);
+    }
+    else if (strcmp(argv[1], "createFiles") == 0) {
+        int sync = 0;
+        int first = 2;
+        unsigned long count = 0;
+        if (first < argc && strcmp(argv[first], "--sync") == 0) {
+            sync = 1;
+            first++;
+        }
+        if (argc - first != 2) {
+            write_message("Error: createFiles requires two arguments.\n");
+            return 1;
+        }
+        // A number is a count of files to name; anything else is a list,
+        // unless it only looks like a mistyped count ("-3", "10x")
+        const char *what = argv[first + 1];
+        int counted = parse_number(what, &count) == 0;
+        struct stat st;
+        if (!counted && (what[0] == '-' || (what[0] >= '0' && what[0] <= '9')) &&
+            stat(what, &st) == -1) {
+            write_message("Error: createFiles count \"");
+            write_message(what);
+            write_message("\" is not a non-negative number (or a list file).\n");
+            return 1;
+        }
+        result = create_files(argv[first], count, counted ? NULL : argv[first + 1], sync);
+    }
+    else if (strcmp(argv[1], "listDir") == 0) {
+        ListOptions options;
+        int first = 2;
+        if (parse_list_options(argc, argv, &first, &options) == -1) {
+            return 1;
+        }
+        if (argc - first != 1) {
+            write_message("Error: listDir requires one argument.\n");
+            return 1;
+        }
+        int single = list_single_directory(&options);
+        if (single == -1) {
+            return 1;
+        }
+        if (first == 2) {
+            result = list_directory(argv[first]);
+        } else if (single) {
+            result = list_directory_sorted(argv[first], NULL, &options);
+        } else {
+            result = list_tree(argv[first], NULL, &options);
+        }
+    }
+    else if (strcmp(argv[1], "listFilesByExtension") == 0) {
+        ListOptions options;
+        int first = 2;
+        if (parse_list_options(argc, argv, &first, &options) == -1) {
+            return 1;
+        }
+        if (argc - first != 2) {
+            write_message("Error: listFilesByExtension requires two arguments.\n");
+            return 1;
+        }
+        int single = list_single_directory(&options);
+        if (single == -1) {
+            return 1;
+        }
+        if (first == 2) {
+            result = list_files_by_extension(argv[first], argv[first + 1]);
+        } else if (single) {
+            result = list_directory_sorted(argv[first], argv[first + 1], &options);
+        } else {
+            result = list_tree(argv[first], argv[first + 1], &options);
+        }
+    }
+    else if (strcmp(argv[1], "indexDir") == 0 || strcmp(argv[1], "watch") == 0) {
+        int first = 2;
+        int threads;
+        if (parse_thread_options(argc, argv, &first, NULL, &threads) == -1) {
+            return 1;
+        }
+        if (argc - first != 1) {
+            write_message("Error: ");
+            write_message(argv[1]);
+            write_message(" requires one argument.\n");
+            return 1;
+        }
+        if (argv[1][0] == 'i') {
+            result = index_directory(argv[first], threads);
+        } else {
+            result = watch_directory(argv[first], threads);
+        }
+    }
+    else if (strcmp(argv[1], "du") == 0) {
+        ListOptions options;
+        int first = 2;
+        if (parse_du_options(argc, argv, &first, &options) == -1) {
+            return 1;
+        }
+        if (argc - first != 1) {
+            write_message("Error: du requires one argument.\n");
+            return 1;
+        }
+        result = disk_usage(argv[first], &options);
+    }
+    else if (strcmp(argv[1], "hashFile") == 0) {
+        int first = 2;
+        int threads;
+        if (parse_thread_options(argc, argv, &first, NULL, &threads) == -1) {
+            return 1;
+        }
+        if (argc - first < 1) {
+            write_message("Error: hashFile requires at least one argument.\n");
+            return 1;
+        }
+        result = hash_file_list(argv + first, argc - first, threads);
+    }
+    else if (strcmp(argv[1], "findDuplicates") == 0) {
+        int first = 2;
+        int threads;
+        if (parse_thread_options(argc, argv, &first, NULL, &threads) == -1) {
+            return 1;
+        }
+        if (argc - first != 1) {
+            write_message("Error: findDuplicates requires one argument.\n");
+            return 1;
+        }
+        result = find_duplicate_files(argv[first], threads);
+    }
+    else if (strcmp(argv[1], "searchFiles") == 0) {
+        int first = 2;
+        int threads = 0;
+        const char *extension = NULL;
+        while (first < argc && argv[first][0] == '-' && argv[first][1] != '\0') {
+            if (strcmp(argv[first], "--ext") == 0 && first + 1 < argc) {
+                extension = argv[first + 1];
+                first += 2;
+            } else if (strncmp(argv[first], "--ext=", 6) == 0) {
+                extension = argv[first] + 6;
+                first++;
+            } else if (parse_thread_options(first + 1, argv, &first, NULL, &threads) == -1) {
+                return 1;  // One flag at a time, so --ext may come before or after
+            }
+        }
+        // --ext may also follow the pattern: searchFiles dir text --ext .log
+        int last = argc;
+        if (argc - first >= 4 && strcmp(argv[argc - 2], "--ext") == 0) {
+            extension = argv[argc - 1];
+            last = argc - 2;
+        } else if (argc - first >= 3 && strncmp(argv[argc - 1], "--ext=", 6) == 0) {
+            extension = argv[argc - 1] + 6;
+            last = argc - 1;
+        }
+        if (last - first != 2 || argv[first + 1][0] == '\0') {
+            write_message("Error: searchFiles requires a directory and a pattern.\n");
+            return 1;
+        }
+        result = search_files(argv[first], argv[first + 1], extension, threads);
+    }
+    else if (strcmp(argv[1], "readFile") == 0) {
+        unsigned long offset = 0, length = 0, lines = FOLLOW_LINES_DEFAULT;
+        int follow = 0;
+        int first = 2;
+        for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+            if (strcmp(argv[first], "--follow") == 0) {
+                follow = 1;
+            } else if (strncmp(argv[first], "--lines=", 8) == 0 && parse_number(argv[first] + 8, &lines) == 0) {
+                continue;
+            } else {
+                write_message("Unknown option: ");
+                write_message(argv[first]);
+                write_message("\n");
+                return 1;
+            }
+        }
+        if (follow) {
+            if (argc - first != 1) {
+                write_message("Error: readFile --follow requires one argument.\n");
+                return 1;
+            }
+            result = follow_file_command(argv[first], lines);
+        } else {
+            if (argc - first < 1 || argc - first > 3) {
+                write_message("Error: readFile requires one to three arguments.\n");
+                return 1;
+            }
+            if ((argc - first > 1 && parse_number(argv[first + 1], &offset) == -1) ||
+                (argc - first > 2 && parse_number(argv[first + 2], &length) == -1)) {
+                write_message("Error: readFile offset and length must be non-negative numbers.\n");
+                return 1;
+            }
+            result = read_file(argv[first], offset, argc - first > 2 ? (off_t)length : -1);
+        }
+    }
+    else if (strcmp(argv[1], "appendToFile") == 0) {
+        AppendOptions options = { 0, 0, NULL };
+        unsigned long wait_ms;
+        int first = 2;
+        for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+            if (strncmp(argv[first], "--wait=", 7) == 0 && parse_number(argv[first] + 7, &wait_ms) == 0) {
+                options.wait_ms = wait_ms;
+            } else if (strcmp(argv[first], "--stdin") == 0) {
+                options.from_stdin = 1;
+            } else if (strncmp(argv[first], "--coalesce=", 11) == 0 && argv[first][11] != '\0') {
+                options.coalesce = argv[first] + 11;
+            } else {
+                write_message("Unknown option: ");
+                write_message(argv[first]);
+                write_message("\n");
+                return 1;
+            }
+        }
+        if (argc - first != (options.from_stdin ? 1 : 2)) {
+            write_message(options.from_stdin ? "Error: appendToFile --stdin requires one argument.\n"
+                                             : "Error: appendToFile requires two arguments.\n");
+            return 1;
+        }
+        result = append_to_file(argv[first], options.from_stdin ? NULL : argv[first + 1], &options);
+    }
+    else if (strcmp(argv[1], "appendDaemon") == 0) {
+        if (argc != 3) {
+            write_message("Error: appendDaemon requires one argument.\n");
+            return 1;
+        }
+        result = run_append_daemon(argv[2]);
+    }
+    else if (strcmp(argv[1], "serve") == 0) {
+        int first = 2;
+        int threads;
+        if (parse_thread_options(argc, argv, &first, NULL, &threads) == -1) {
+            return 1;
+        }
+        if (argc - first != 1) {
+            write_message("Error: serve requires one argument.\n");
+            return 1;
+        }
+        result = run_server(argv[first], threads);
+    }
+    else if (strcmp(argv[1], "copyFile") == 0 || strcmp(argv[1], "moveFile") == 0) {
+        int first = 2;
+        int threads;  // moveFile uses it when it has to copy across file systems
+        if (parse_thread_options(argc, argv, &first, NULL, &threads) == -1) {
+            return 1;
+        }
+        if (argc - first != 2) {
+            write_message("Error: ");
+            write_message(argv[1]);
+            write_message(" requires two arguments.\n");
+            return 1;
+        }
+        if (argv[1][0] == 'c') {
+            result = copy_file(argv[first], argv[first + 1], threads);
+        } else {
+            result = move_file(argv[first], argv[first + 1], threads);
+        }
+    }
+    else if (strcmp(argv[1], "deleteFile") == 0) {
+        if (argc != 3) {
+            write_message("Error: deleteFile requires one argument.\n");
+            return 1;
+        }
+        result = delete_file(argv[2]);
+    }
+    else if (strcmp(argv[1], "deleteDir") == 0) {
+        int first = 2;
+        int recursive, threads;
+        if (parse_thread_options(argc, argv, &first, &recursive, &threads) == -1) {
+            return 1;
+        }
+        if (argc - first != 1) {
+            write_message("Error: deleteDir requires one argument.\n");
+            return 1;
+        }
+        if (recursive) {
+            result = delete_tree(argv[first], threads);
+        } else {
+            result = delete_directory(argv[first]);
+        }
+    }
+    else if (strcmp(argv[1], "showLogs") == 0) {
+        LogQuery query = { NULL, NULL, 0, NULL, 0 };
+        for (int i = 2; i < argc; i++) {
+            if (strncmp(argv[i], "--since=", 8) == 0 && log_time_valid(argv[i] + 8) == 0) {
+                query.since = argv[i] + 8;
+            } else if (strncmp(argv[i], "--until=", 8) == 0 && log_time_valid(argv[i] + 8) == 0) {
+                query.until = argv[i] + 8;
+            } else if (strncmp(argv[i], "--tail=", 7) == 0 && parse_number(argv[i] + 7, &query.tail) == 0) {
+                continue;
+            } else if (strncmp(argv[i], "--grep=", 7) == 0) {
+                query.grep = argv[i] + 7;
+            } else if (strcmp(argv[i], "--summary") == 0) {
+                query.summary = 1;
+            } else {
+                write_message("Unknown option: ");
+                write_message(argv[i]);
+                write_message("\n");
+                write_message("Times are \"YYYY-MM-DD HH:MM:SS\" or a prefix of it.\n");
+                return 1;
+            }
+        }
+        if (query.summary && (query.tail || query.grep)) {
+            write_message("Error: --summary cannot be combined with --tail or --grep.\n");
+            return 1;
+        }
+        if (query.summary && log_get_format() != LOG_FORMAT_BINARY) {
+            write_message("Error: --summary needs the binary log (--log-format=binary).\n");
+            return 1;
+        }
+        result = show_logs(&query);
+    }
+    else {
+        write_message("Unknown command: ");
+        write_message(argv[1]);
+        write_message("\n");
+        display_help();
+        return 1;
+    }
+    
+    return result == 0 ? 0 : 1;
+}
+
+// Function to run a command with its op code and path (its first operand)
+// as the context of the binary log records it writes
+int run_command(int argc, char *argv[]) {
+    LogContext context = { log_op_code(argv[1]), NULL };
+    for (int i = 2; i < argc && context.path == NULL; i++) {
+        if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            context.path = argv[i];
+        }
+    }
+    
+    LogContext previous = log_set_context(context);
+    int status = dispatch_command(argc, argv);
+    log_set_context(previous);
+    return status;
+}
+
+// Function to split a script line into arguments; "double quotes" keep
+// spaces together and \" or \\ escape inside them
+int split_command_line(char *line, char *args[], int max_args) {
+    int count = 0;
+    char *p = line;
+    
+    while (*p) {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (count == max_args) {
+            return -1;
+        }
+        
+        if (*p == '"') {
+            char *out = ++p;
+            args[count++] = out;
+            while (*p && *p != '"') {
+                if (*p == '\\' && (p[1] == '"' || p[1] == '\\')) {
+                    p++;
+                }
+                *out++ = *p++;
+            }
+            if (*p != '"') {
+                return -1;  // Unterminated quote
+            }
+            p++;
+            *out = '\0';
+        } else {
+            args[count++] = p;
+            while (*p && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            if (*p) {
+                *p++ = '\0';
+            }
+        }
+    }
+    return count;
+}
+
+// Function to read a whole script from a file or stdin ("-")
+char *read_script(const char *script, size_t *length) {
+    int fd = strcmp(script, "-") == 0 ? STDIN_FILENO : open(script, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+    
+    size_t capacity = 64 * 1024;
+    size_t used = 0;
+    char *data = malloc(capacity + 1);
+    ssize_t n;
+    
+    while (data && (n = read(fd, data + used, capacity - used)) > 0) {
+        used += n;
+        if (used == capacity) {
+            capacity *= 2;
+            char *bigger = realloc(data, capacity + 1);
+            if (!bigger) {
+                free(data);
+            }
+            data = bigger;
+        }
+    }
+    
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    if (data) {
+        data[used] = '\0';
+        *length = used;
+    }
+    return data;
+}
+
+// Function to run every command of a script in this one process
+int run_batch(const char *script) {
+    char log_message[MAX_BUFFER];
+    char number[32];
+    size_t length;
+    
+    char *data = read_script(script, &length);
+    if (data == NULL) {
+        strcpy(log_message, "Error: Cannot read batch script \"");
+        strcat(log_message, script);
+        strcat(log_message, "\".");
+        write_message(log_message);
+        write_message("\n");
+        log_operation(log_message, LOG_FAILURE);
+        return -1;
+    }
+    
+    unsigned long commands = 0;
+    unsigned long failed = 0;
+    double batch_start = now_seconds();
+    char *line = data;
+    
+    while (line < data + length) {
+        char *end = memchr(line, '\n', data + length - line);
+        if (end == NULL) {
+            end = data + length;
+        }
+        *end = '\0';
+        if (end > line && end[-1] == '\r') {
+            end[-1] = '\0';
+        }
+        
+        char *args[MAX_ARGS + 1];
+        args[0] = "fileManager";
+        int count = line[0] == '#' ? 0 : split_command_line(line, args + 1, MAX_ARGS - 1);
+        line = end + 1;
+        
+        if (count == 0) {
+            continue;  // Blank line or comment
+        }
+        
+        commands++;
+        int status = 1;
+        double start = now_seconds();
+        
+        if (count < 0) {
+            write_message("Error: Malformed batch line.\n");
+        } else if (strcmp(args[1], "batch") == 0) {
+            write_message("Error: batch cannot be nested.\n");
+        } else {
+            args[count + 1] = NULL;
+            status = run_command(count + 1, args);
+        }
+        
+        // Per-command timing
+        format_number(number, commands);
+        write_message("[batch ");
+        write_message(number);
+        write_message("] ");
+        write_message(count > 0 ? args[1] : "?");
+        write_message(" ");
+        format_decimal(number, (now_seconds() - start) * 1000.0, 3);
+        write_message(number);
+        write_message(status == 0 ? " ms\n" : " ms (failed)\n");
+        
+        if (status != 0) {
+            failed++;
+        }
+    }
+    
+    double elapsed = now_seconds() - batch_start;
+    free(data);
+    
+    // Summary: commands, failures, total time and throughput
+    write_message("Batch finished: ");
+    format_number(number, commands);
+    write_message(number);
+    write_message(" commands, ");
+    format_number(number, failed);
+    write_message(number);
+    write_message(" failed, ");
+    format_decimal(number, elapsed * 1000.0, 3);
+    write_message(number);
+    write_message(" ms total, ");
+    format_decimal(number, elapsed > 0 ? commands / elapsed : 0.0, 1);
+    write_message(number);
+    write_message(" ops/sec\n");
+    
+    strcpy(log_message, "Ran batch script \"");
+    strcat(log_message, script);
+    strcat(log_message, "\": ");
+    format_number(number, commands);
+    strcat(log_message, number);
+    strcat(log_message, " commands, ");
+    format_number(number, failed);
+    strcat(log_message, number);
+    strcat(log_message, " failed.");
+    log_operation(log_message, failed == 0 ? LOG_SUCCESS : LOG_FAILURE);
+    
+    return failed == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t output_size = OUTPUT_BUFFER_DEFAULT;
+    const char *server = NULL;
+    
+    // Leading options
+    while (argc > 1 && strncmp(argv[1], "--", 2) == 0) {
+        char *end = NULL;
+        if (strncmp(argv[1], "--output-buffer=", 16) == 0) {
+            output_size = strtoul(argv[1] + 16, &end, 10);
+        }
+        
+        if ((strncmp(argv[1], "--log-sync=", 11) == 0 && log_set_sync(argv[1] + 11) == 0) ||
+            (strncmp(argv[1], "--log-rotate=", 13) == 0 && log_set_rotate(argv[1] + 13) == 0) ||
+            (strcmp(argv[1], "--log-compress") == 0 && log_set_compress(1) == 0) ||
+            (strncmp(argv[1], "--log-format=", 13) == 0 && log_set_format(argv[1] + 13) == 0) ||
+            (strncmp(argv[1], "--transfer=", 11) == 0 && transfer_set_mode(argv[1] + 11) == 0) ||
+            (strncmp(argv[1], "--server=", 9) == 0 && (server = argv[1] + 9)[0] != '\0') ||
+            (end != NULL && end != argv[1] + 16 && *end == '\0')) {
+            argv[1] = argv[0];
+            argv++;
+            argc--;
+        } else {
+            write_message("Unknown option: ");
+            write_message(argv[1]);
+            write_message("\n");
+            display_help();
+            return 1;
+        }
+    }
+    
+    if (output_init(output_size) == -1) {
+        output_init(0);  // No memory for the buffer: write through
+    }
+    
+    // If no arguments provided, display help
+    if (argc == 1) {
+        display_help();
+        return 0;
+    }
+    
+    // Client of a running serve: the server runs the command and answers
+    if (server != NULL) {
+        int status;
+        if (serve_request(server, argc - 1, argv + 1, &status) == -1) {
+            char error_msg[MAX_BUFFER];
+            strcpy(error_msg, "Error: No answer from server on \"");
+            strcat(error_msg, server);
+            strcat(error_msg, "\": ");
+            strcat(error_msg, strerror(errno));
+            write_message(error_msg);
+            write_message("\n");
+            return 1;
+        }
+        return status;
+    }
+    
+    if (strcmp(argv[1], "batch") == 0) {
+        if (argc != 3) {
+            write_message("Error: batch requires one argument.\n");
+            return 1;
+        }
+        LogContext context = { LOG_OP_BATCH, argv[2] };
+        log_set_context(context);
+        return run_batch(argv[2]) == 0 ? 0 : 1;
+    }
+    
+    return run_command(argc, argv);
 }
\ No newline at end of file
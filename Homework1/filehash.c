@@ -0,0 +1,531 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "filehash.h"
+#include "walker.h"
+
+#define HASH_SMALL (64 * 1024)  // read with pread, mapping costs more
+
+// XXH64 (Yann Collet): four independent 64-bit lanes over 32-byte stripes,
+// which keeps a core busy enough to hash faster than a disk can read
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline unsigned long long rotl64(unsigned long long x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little-endian loads at any alignment
+static inline unsigned long long read64(const unsigned char *p) {
+    unsigned long long v;
+    memcpy(&v, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline unsigned long long read32(const unsigned char *p) {
+    unsigned int v;
+    memcpy(&v, p, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline unsigned long long xxh_round(unsigned long long acc, unsigned long long input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline unsigned long long xxh_merge(unsigned long long acc, unsigned long long lane) {
+    acc ^= xxh_round(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// Function to hash one buffer (XXH64)
+unsigned long long hash_buffer(const void *data, size_t len, unsigned long long seed) {
+    const unsigned char *p = data;
+    const unsigned char *end = p + len;
+    unsigned long long h;
+
+    if (len >= 32) {
+        unsigned long long v1 = seed + PRIME64_1 + PRIME64_2;
+        unsigned long long v2 = seed + PRIME64_2;
+        unsigned long long v3 = seed;
+        unsigned long long v4 = seed - PRIME64_1;
+        const unsigned char *limit = end - 32;
+        do {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += len;
+
+    while (p + 8 <= end) {
+        h ^= xxh_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Function to write a hash as 16 hex digits
+void hash_format(char *buffer, unsigned long long hash) {
+    const char *digits = "0123456789abcdef";
+    for (int i = HASH_HEX_LEN - 1; i >= 0; i--) {
+        buffer[i] = digits[hash & 15];
+        hash >>= 4;
+    }
+    buffer[HASH_HEX_LEN] = '\0';
+}
+
+// The work of one hash_files call: every file is split into units (one
+// chunk each) that the threads take in order, so a big file's chunks are
+// read side by side
+typedef struct {
+    int root_fd;
+    HashFile *files;
+    size_t count;
+    size_t *first;                  // first unit of each file, then the total
+    unsigned long long *digests;    // one per unit
+    size_t next;                    // next unit to take
+} HashJob;
+
+typedef struct {
+    HashJob *job;
+    pthread_t thread;
+    unsigned long bytes;
+    char pad[64];                   // keep workers off each other's cache lines
+} HashWorker;
+
+// Function to find the file a unit belongs to
+static size_t unit_file(const HashJob *job, size_t unit) {
+    size_t lo = 0;
+    size_t hi = job->count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (job->first[mid] <= unit) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Function to hash len bytes of file from offset; small reads go through
+// buffer, bigger ones are mapped and faulted in with one call. A file that
+// changed size since it was listed fails with EAGAIN.
+static int hash_chunk(int root_fd, const HashFile *file, off_t offset, size_t len, char *buffer,
+                      unsigned long long *digest) {
+    int fd = walk_open_file(root_fd, file->path);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    int result = -1;
+    if (fstat(fd, &st) == -1) {
+        goto done;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        errno = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+        goto done;
+    }
+    if ((unsigned long)st.st_size != file->size) {
+        errno = EAGAIN;
+        goto done;
+    }
+
+    if (len <= HASH_SMALL) {
+        size_t got = 0;
+        while (got < len) {
+            ssize_t n = pread(fd, buffer + got, len - got, offset + got);
+            if (n <= 0) {
+                if (n == 0) {
+                    errno = EAGAIN;
+                }
+                goto done;
+            }
+            got += n;
+        }
+        *digest = hash_buffer(buffer, len, 0);
+    } else {
+        void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, offset);
+        if (data == MAP_FAILED) {
+            goto done;
+        }
+        *digest = hash_buffer(data, len, 0);
+        munmap(data, len);
+    }
+    result = 0;
+
+done:
+    close(fd);
+    return result;
+}
+
+static void *hash_worker(void *arg) {
+    HashWorker *self = arg;
+    HashJob *job = self->job;
+    char buffer[HASH_SMALL];
+
+    size_t total = job->first[job->count];
+    for (;;) {
+        size_t unit = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (unit >= total) {
+            break;
+        }
+        size_t index = unit_file(job, unit);
+        HashFile *file = &job->files[index];
+        if (__atomic_load_n(&file->error, __ATOMIC_RELAXED) != 0) {
+            continue;  // Another chunk of it already failed
+        }
+
+        off_t offset = (off_t)(unit - job->first[index]) * HASH_CHUNK;
+        size_t len = file->size - offset < HASH_CHUNK ? file->size - offset : HASH_CHUNK;
+        if (hash_chunk(job->root_fd, file, offset, len, buffer, &job->digests[unit]) == -1) {
+            __atomic_store_n(&file->error, errno ? errno : EIO, __ATOMIC_RELAXED);
+        } else {
+            self->bytes += len;
+        }
+    }
+    return NULL;
+}
+
+// Function to hash every file with a pool of threads
+int hash_files(int root_fd, HashFile *files, size_t count, int threads, HashStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (count == 0) {
+        return 0;
+    }
+
+    HashJob job;
+    job.root_fd = root_fd;
+    job.files = files;
+    job.count = count;
+    job.next = 0;
+    job.first = malloc((count + 1) * sizeof(size_t));
+    if (job.first == NULL) {
+        return -1;
+    }
+    size_t units = 0;
+    for (size_t i = 0; i < count; i++) {
+        job.first[i] = units;
+        if (files[i].error == 0) {
+            units += files[i].size > HASH_CHUNK ? (files[i].size + HASH_CHUNK - 1) / HASH_CHUNK : 1;
+        }
+    }
+    job.first[count] = units;
+    job.digests = malloc((units ? units : 1) * sizeof(unsigned long long));
+    HashWorker *workers = calloc(WALK_MAX_THREADS, sizeof(HashWorker));
+    if (job.digests == NULL || workers == NULL) {
+        free(job.first);
+        free(job.digests);
+        free(workers);
+        return -1;
+    }
+
+    int wanted = walk_threads(threads);
+    if ((size_t)wanted > units) {
+        wanted = units;
+    }
+    int started = 0;
+    for (int i = 0; i < wanted; i++) {
+        workers[i].job = &job;
+        if (pthread_create(&workers[i].thread, NULL, hash_worker, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        workers[0].job = &job;
+        hash_worker(&workers[0]);  // No threads to be had: do it here
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    // A chunked file's hash is the hash of its chunk hashes (seeded with
+    // its size); a single chunk's hash is the file's own
+    for (size_t i = 0; i < count; i++) {
+        HashFile *file = &files[i];
+        size_t chunks = job.first[i + 1] - job.first[i];
+        if (file->error != 0) {
+            stats->errors++;
+            continue;
+        }
+        if (chunks == 1) {
+            file->hash = job.digests[job.first[i]];
+        } else {
+            unsigned char *bytes = (unsigned char *)&job.digests[job.first[i]];
+            for (size_t c = 0; c < chunks; c++) {
+                unsigned long long digest = job.digests[job.first[i] + c];
+                for (int b = 0; b < 8; b++) {
+                    bytes[c * 8 + b] = digest >> (8 * b);
+                }
+            }
+            file->hash = hash_buffer(bytes, chunks * 8, file->size);
+        }
+        stats->files++;
+    }
+    for (int i = 0; i < (started ? started : 1); i++) {
+        stats->bytes += workers[i].bytes;
+    }
+    stats->threads = started ? started : 1;
+
+    free(job.first);
+    free(job.digests);
+    free(workers);
+    return 0;
+}
+
+// The regular files one walker thread found
+typedef struct {
+    HashFile *items;
+    size_t count;
+    size_t cap;
+    unsigned long errors;
+    char pad[64];
+} DupWorker;
+
+typedef struct {
+    DupWorker workers[WALK_MAX_THREADS];
+} DupScan;
+
+// Walker callback: every non-empty regular file is kept with its size and
+// identity; symlinks and special files are not content
+static int dup_visit(int worker, int dfd, const char *path, size_t path_len,
+                     const char *name, unsigned char type, void *arg) {
+    DupWorker *self = &((DupScan *)arg)->workers[worker];
+    if (type == DT_DIR) {
+        return 1;
+    }
+    if (type != DT_REG) {
+        return 0;
+    }
+
+    struct statx stx;
+    if (statx(dfd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STATX_SIZE | STATX_INO, &stx) == -1) {
+        self->errors++;
+        return 0;
+    }
+    if (self->count == self->cap) {
+        size_t cap = self->cap ? self->cap * 2 : 1024;
+        HashFile *items = realloc(self->items, cap * sizeof(HashFile));
+        if (items == NULL) {
+            self->errors++;
+            return 0;
+        }
+        self->items = items;
+        self->cap = cap;
+    }
+
+    HashFile *file = &self->items[self->count];
+    memset(file, 0, sizeof(*file));
+    file->path = malloc(path_len + 1);
+    if (file->path == NULL) {
+        self->errors++;
+        return 0;
+    }
+    memcpy(file->path, path, path_len + 1);
+    file->size = stx.stx_size;
+    file->dev = ((unsigned long)stx.stx_dev_major << 20) | stx.stx_dev_minor;
+    file->ino = stx.stx_ino;
+    self->count++;
+    return 0;
+}
+
+// Largest first, then by identity so hard links end up side by side
+static int compare_size(const void *a, const void *b) {
+    const HashFile *x = a;
+    const HashFile *y = b;
+    if (x->size != y->size) {
+        return x->size > y->size ? -1 : 1;
+    }
+    if (x->dev != y->dev) {
+        return x->dev < y->dev ? -1 : 1;
+    }
+    if (x->ino != y->ino) {
+        return x->ino < y->ino ? -1 : 1;
+    }
+    return strcmp(x->path, y->path);
+}
+
+// Failed files last; then largest first, by hash, and by path in a group
+static int compare_hash(const void *a, const void *b) {
+    const HashFile *x = a;
+    const HashFile *y = b;
+    if ((x->error != 0) != (y->error != 0)) {
+        return x->error != 0 ? 1 : -1;
+    }
+    if (x->size != y->size) {
+        return x->size > y->size ? -1 : 1;
+    }
+    if (x->hash != y->hash) {
+        return x->hash < y->hash ? -1 : 1;
+    }
+    return strcmp(x->path, y->path);
+}
+
+static void free_files(HashFile *files, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        free(files[i].path);
+    }
+}
+
+// Function to find the files under root with the same content
+int find_duplicates(const char *root, int threads, DupResult *result) {
+    memset(result, 0, sizeof(*result));
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd == -1) {
+        return -1;
+    }
+
+    DupScan *scan = calloc(1, sizeof(DupScan));
+    if (scan == NULL) {
+        close(root_fd);
+        return -1;
+    }
+    WalkOptions options = { threads, dup_visit, scan, NULL };
+    WalkStats walk;
+    if (walk_tree(root, &options, &walk) == -1) {
+        free(scan);
+        close(root_fd);
+        return -1;
+    }
+    result->errors = walk.errors;
+
+    size_t total = 0;
+    for (int w = 0; w < walk.threads; w++) {
+        total += scan->workers[w].count;
+        result->errors += scan->workers[w].errors;
+    }
+    HashFile *files = malloc((total ? total : 1) * sizeof(HashFile));
+    if (files == NULL) {
+        for (int w = 0; w < walk.threads; w++) {
+            free_files(scan->workers[w].items, 0, scan->workers[w].count);
+            free(scan->workers[w].items);
+        }
+        free(scan);
+        close(root_fd);
+        return -1;
+    }
+    size_t count = 0;
+    for (int w = 0; w < walk.threads; w++) {
+        memcpy(files + count, scan->workers[w].items, scan->workers[w].count * sizeof(HashFile));
+        count += scan->workers[w].count;
+        free(scan->workers[w].items);
+    }
+    free(scan);
+    result->scanned = count;
+
+    // Only sizes held by two different files can hide a duplicate; more
+    // names of one inode are the same data, so the first one stands for it
+    qsort(files, count, sizeof(HashFile), compare_size);
+    size_t kept = 0;
+    for (size_t i = 0; i < count;) {
+        size_t end = i;
+        size_t inodes = 0;
+        while (end < count && files[end].size == files[i].size) {
+            inodes += end == i || files[end].dev != files[end - 1].dev || files[end].ino != files[end - 1].ino;
+            end++;
+        }
+        for (size_t j = i; j < end; j++) {
+            int link = j > i && files[j].dev == files[j - 1].dev && files[j].ino == files[j - 1].ino;
+            if (files[i].size > 0 && inodes > 1 && !link) {
+                files[kept++] = files[j];
+            } else {
+                free(files[j].path);
+            }
+        }
+        i = end;
+    }
+    count = kept;
+    result->candidates = count;
+
+    if (hash_files(root_fd, files, count, threads, &result->hash) == -1) {
+        free_files(files, 0, count);
+        free(files);
+        close(root_fd);
+        return -1;
+    }
+    close(root_fd);
+    result->errors += result->hash.errors;
+
+    // Keep the groups of two or more files with one size and hash
+    qsort(files, count, sizeof(HashFile), compare_hash);
+    kept = 0;
+    for (size_t i = 0; i < count;) {
+        if (files[i].error != 0) {
+            free(files[i++].path);
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < count && files[end].error == 0 && files[end].size == files[i].size &&
+               files[end].hash == files[i].hash) {
+            end++;
+        }
+        if (end - i > 1) {
+            result->groups++;
+            result->reclaimable += files[i].size * (end - i - 1);
+            for (size_t j = i; j < end; j++) {
+                files[kept++] = files[j];
+            }
+        } else {
+            free(files[i].path);
+        }
+        i = end;
+    }
+    result->files = files;
+    result->count = kept;
+    return 0;
+}
+
+void dup_free(DupResult *result) {
+    free_files(result->files, 0, result->count);
+    free(result->files);
+    result->files = NULL;
+    result->count = 0;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef FILEHASH_H
+#define FILEHASH_H
+
+#include <stddef.h>
+
+// Files bigger than this are hashed in chunks by several threads at once;
+// the file's hash is then the hash of its chunk hashes
+#define HASH_CHUNK (8 * 1024 * 1024)
+#define HASH_HEX_LEN 16
+
+// One file to hash
+typedef struct {
+    char *path;                 // relative to the root_fd given to hash_files
+    unsigned long size;
+    unsigned long dev;          // identity, so hard links count once
+    unsigned long long ino;
+    unsigned long long hash;
+    int error;                  // errno if it could not be hashed, else 0
+} HashFile;
+
+typedef struct {
+    unsigned long files;        // files hashed
+    unsigned long bytes;        // bytes read
+    unsigned long errors;
+    int threads;
+} HashStats;
+
+typedef struct {
+    HashFile *files;            // the duplicates: each group's files are adjacent,
+    size_t count;               // largest size first
+    size_t groups;
+    unsigned long scanned;      // regular files under the root
+    unsigned long candidates;   // non-empty files sharing their size with another
+    unsigned long reclaimable;  // bytes taken by all but one file of each group
+    unsigned long errors;       // files or directories that could not be read
+    HashStats hash;
+} DupResult;
+
+// Function to hash one buffer (XXH64)
+unsigned long long hash_buffer(const void *data, size_t len, unsigned long long seed);
+
+// Function to write a hash as HASH_HEX_LEN hex digits and a NUL
+void hash_format(char *buffer, unsigned long long hash);
+
+// Function to hash files[0..count), whose path and size are filled in,
+// with a pool of threads (0 = one per CPU). Files whose error is already
+// set are skipped; failures set it.
+int hash_files(int root_fd, HashFile *files, size_t count, int threads, HashStats *stats);
+
+// Function to find the files under root with the same content: files are
+// grouped by size first and only sizes shared by two or more get hashed
+int find_duplicates(const char *root, int threads, DupResult *result);
+
+// Function to free what find_duplicates returned
+void dup_free(DupResult *result);
+
+#endif
\ No newline at end of file
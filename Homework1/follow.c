@@ -0,0 +1,212 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "follow.h"
+#include "output.h"
+#include "transfer.h"
+
+#define TAIL_CHUNK (64 * 1024)
+
+static volatile sig_atomic_t follow_stop = 0;
+
+static void follow_signal(int sig) {
+    (void)sig;
+    follow_stop = 1;
+}
+
+// Function to find where the last lines lines of fd's first size bytes
+// start, reading backwards a chunk at a time; a final newline ends the
+// last line rather than starting another
+static off_t tail_start(int fd, off_t size, unsigned long lines) {
+    char buffer[TAIL_CHUNK];
+    off_t end = size;
+    unsigned long found = 0;
+
+    if (lines == 0) {
+        return size;
+    }
+    while (end > 0) {
+        off_t from = end > TAIL_CHUNK ? end - TAIL_CHUNK : 0;
+        ssize_t n = pread(fd, buffer, end - from, from);
+        if (n <= 0) {
+            return from;
+        }
+        size_t len = n;
+        if (end == size && buffer[len - 1] == '\n') {
+            len--;
+        }
+        char *newline;
+        while ((newline = memrchr(buffer, '\n', len)) != NULL) {
+            if (++found == lines) {
+                return from + (newline - buffer) + 1;
+            }
+            len = newline - buffer;
+        }
+        end = from;
+    }
+    return 0;
+}
+
+// Function to print fd from *pos to its current end in the kernel and
+// move *pos along; a file that shrank below *pos is read from its start
+static int follow_drain(int fd, off_t *pos, FollowStats *stats) {
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        return -1;
+    }
+    if (st.st_size < *pos) {
+        const char *notice = "readFile: file truncated, following from its start\n";
+        output_flush();
+        write(STDERR_FILENO, notice, strlen(notice));
+        stats->truncations++;
+        *pos = 0;
+    }
+    if (st.st_size > *pos) {
+        output_flush();
+        ssize_t moved = transfer_range(fd, *pos, st.st_size - *pos, output_fd());
+        if (moved == -1) {
+            return -1;
+        }
+        *pos += moved;
+        stats->bytes += moved;
+    }
+    return 0;
+}
+
+// Function to watch the file itself for appends and truncation, and its
+// directory for a new file taking over the name
+static int follow_watch(int inotify_fd, const char *path, int *wd) {
+    *wd = inotify_add_watch(inotify_fd, path, IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    return *wd == -1 ? -1 : 0;
+}
+
+// Function to follow path until SIGINT or SIGTERM
+int follow_file(const char *path, unsigned long lines, FollowStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        int saved = errno;
+        if (fd != -1) {
+            close(fd);
+        }
+        errno = saved;
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        errno = EINVAL;  // Pipes have no end to follow from
+        return -1;
+    }
+
+    // The directory and the name in it
+    char dir[PATH_MAX];
+    const char *name = strrchr(path, '/');
+    if (name == NULL) {
+        strcpy(dir, ".");
+        name = path;
+    } else {
+        size_t len = name == path ? 1 : (size_t)(name - path);
+        if (len >= sizeof(dir)) {
+            close(fd);
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+        name++;
+    }
+
+    int inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    int file_wd = -1;
+    if (inotify_fd == -1 || follow_watch(inotify_fd, path, &file_wd) == -1 ||
+        inotify_add_watch(inotify_fd, dir, IN_CREATE | IN_MOVED_TO) == -1) {
+        int saved = errno;
+        if (inotify_fd != -1) {
+            close(inotify_fd);
+        }
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = follow_signal;  // No SA_RESTART: poll() must wake up
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // The existing tail once, then only what is appended
+    off_t pos = tail_start(fd, st.st_size, lines);
+    FollowStats ignored;
+    memset(&ignored, 0, sizeof(ignored));
+    follow_drain(fd, &pos, &ignored);
+    output_flush();
+
+    char buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd = { inotify_fd, POLLIN, 0 };
+    int result = 0;
+
+    // poll() without a timeout: no CPU at all until the kernel has news
+    while (!follow_stop && result == 0) {
+        int ready = poll(&pfd, 1, -1);
+        if (ready == -1) {
+            if (errno != EINTR) {
+                result = -1;
+            }
+            continue;
+        }
+        stats->wakeups++;
+
+        // The events only say "look again": what changed is read from the
+        // file itself, which also covers a queue overflow
+        int renamed = 0;
+        ssize_t n;
+        while ((n = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + n;) {
+                struct inotify_event *event = (struct inotify_event *)p;
+                p += sizeof(struct inotify_event) + event->len;
+                if ((event->wd != file_wd && event->len > 0 && strcmp(event->name, name) == 0) ||
+                    (event->mask & IN_Q_OVERFLOW)) {
+                    renamed = 1;
+                }
+            }
+        }
+        result = follow_drain(fd, &pos, stats);
+
+        // Rotation: once the name points at another file, finish the old
+        // one and switch. Until then a moved or deleted file is still ours.
+        struct stat now;
+        if (result == 0 && renamed && stat(path, &now) == 0 && fstat(fd, &st) == 0 &&
+            (now.st_ino != st.st_ino || now.st_dev != st.st_dev)) {
+            int next = open(path, O_RDONLY | O_CLOEXEC);
+            if (next != -1) {
+                const char *notice = "readFile: file replaced, following the new file\n";
+                output_flush();
+                write(STDERR_FILENO, notice, strlen(notice));
+                inotify_rm_watch(inotify_fd, file_wd);
+                close(fd);
+                fd = next;
+                pos = 0;
+                stats->rotations++;
+                follow_watch(inotify_fd, path, &file_wd);
+                result = follow_drain(fd, &pos, stats);
+            }
+        }
+        output_flush();
+    }
+
+    close(inotify_fd);
+    close(fd);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef FOLLOW_H
+#define FOLLOW_H
+
+// Lines of the existing file printed before following it
+#define FOLLOW_LINES_DEFAULT 10
+
+typedef struct {
+    unsigned long long bytes;   // bytes printed after the starting tail
+    unsigned long wakeups;      // times inotify woke us up
+    unsigned long truncations;  // times the file shrank under us
+    unsigned long rotations;    // times a new file took over the name
+} FollowStats;
+
+// Function to print the last lines lines of path, then every byte
+// appended to it as it arrives, until SIGINT or SIGTERM. A truncated file
+// is followed again from its start; when another file takes over the name
+// (rotation), the rest of the old one is printed and the new one followed
+// from its start. Returns -1 (errno set) if path cannot be followed.
+int follow_file(const char *path, unsigned long lines, FollowStats *stats);
+
+#endif
\ No newline at end of file
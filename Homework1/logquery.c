@@ -0,0 +1,726 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "logquery.h"
+#include "oplog.h"
+#include "output.h"
+#include "transfer.h"
+
+// Every record starts with "[YYYY-MM-DD HH:MM:SS] " (see oplog.c)
+#define STAMP_TEMPLATE "0000-00-00 00:00:00"
+#define STAMP_LEN 19
+
+// Function to check a --since/--until value against the stamp layout
+int log_time_valid(const char *text) {
+    size_t len = strlen(text);
+    if (len < 4 || len > STAMP_LEN) {
+        return -1;
+    }
+    // Whole fields only: year, month, day, hour, minute, second
+    if (len != 4 && len != 7 && len != 10 && len != 13 && len != 16 && len != STAMP_LEN) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char expected = STAMP_TEMPLATE[i];
+        if (expected == '0' ? (text[i] < '0' || text[i] > '9') : text[i] != expected) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Does a record start at pos?
+static int is_record(const char *data, size_t size, size_t pos) {
+    return size - pos >= STAMP_LEN + 2 && data[pos] == '[' && data[pos + STAMP_LEN + 1] == ']';
+}
+
+// Function to find the first record starting at or after pos. Lines
+// without a stamp continue the record before them (a name with a newline).
+static size_t next_record(const char *data, size_t size, size_t pos) {
+    while (pos < size) {
+        if ((pos == 0 || data[pos - 1] == '\n') && is_record(data, size, pos)) {
+            return pos;
+        }
+        const char *newline = memchr(data + pos, '\n', size - pos);
+        if (newline == NULL) {
+            return size;
+        }
+        pos = newline - data + 1;
+    }
+    return size;
+}
+
+// Function to find the last record starting in [lo, pos]; lo if none
+static size_t record_before(const char *data, size_t size, size_t lo, size_t pos) {
+    while (pos > lo) {
+        const char *newline = memrchr(data + lo, '\n', pos - lo);
+        if (newline == NULL) {
+            break;
+        }
+        size_t start = newline - data + 1;
+        if (start <= pos && is_record(data, size, start)) {
+            return start;
+        }
+        pos = newline - data;
+    }
+    return lo;
+}
+
+// Function to find the first record whose stamp, cut to the length of
+// key, compares above key (after = 1) or at/above it (after = 0). Stamps
+// only grow through the file, so this is a binary search over bytes:
+// every probe lands mid-record and moves forward to the next stamp.
+static size_t search_stamp(const char *data, size_t size, const char *key, int after,
+                           unsigned long *probes) {
+    size_t key_len = strlen(key);
+    size_t lo = 0;
+    size_t hi = size;
+
+    // Records starting before lo compare low; the first one at or after hi does not
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t record = next_record(data, size, mid);
+        if (record >= hi) {
+            hi = mid;
+            continue;
+        }
+        (*probes)++;
+        int order = memcmp(data + record + 1, key, key_len);
+        if (order < 0 || (after && order == 0)) {
+            lo = record + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return next_record(data, size, lo);
+}
+
+// Function to check whether the record at [start, end) contains needle
+static int record_matches(const char *data, size_t start, size_t end, const char *needle,
+                          size_t needle_len) {
+    return needle == NULL || memmem(data + start, end - start, needle, needle_len) != NULL;
+}
+
+// One log file a query may read: a segment or log.txt itself
+typedef struct {
+    unsigned long number;           // 0 = log.txt
+    int fd;
+    char *data;
+    size_t size;
+    size_t start;                   // range selected in it
+    size_t end;
+} Segment;
+
+// Function to run "gzip -dc" on path into an anonymous in-memory file
+static int decompress(const char *path) {
+    int fd = memfd_create("logsegment", MFD_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+
+    output_flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(fd, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execlp("gzip", "gzip", "-dc", path, (char *)NULL);
+        _exit(127);
+    }
+
+    int status;
+    if (pid == -1 || waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        close(fd);
+        errno = EIO;
+        return -1;
+    }
+    return fd;
+}
+
+// Function to open and map a segment (or its .gz) and find the query's
+// range in it; a segment that is gone counts as empty
+static int segment_open(Segment *segment, const LogQuery *query, LogQueryStats *stats) {
+    char name[LOG_SEGMENT_NAME_MAX + 4];
+    if (segment->number == 0) {
+        strcpy(name, LOG_FILE);
+    } else {
+        log_segment_name(name, segment->number);
+    }
+
+    segment->data = NULL;
+    segment->size = 0;
+    segment->start = 0;
+    segment->end = 0;
+    segment->fd = open(name, O_RDONLY | O_CLOEXEC);
+    if (segment->fd == -1 && errno == ENOENT && segment->number != 0) {
+        strcat(name, ".gz");
+        segment->fd = decompress(name);
+        if (segment->fd == -1 && access(name, F_OK) == -1) {
+            return 0;  // Neither file: nothing to show from it
+        }
+    }
+    if (segment->fd == -1) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    struct stat st;
+    if (fstat(segment->fd, &st) == -1) {
+        return -1;
+    }
+    stats->segments++;
+    segment->size = st.st_size;
+    if (segment->size == 0) {
+        return 0;
+    }
+    segment->data = mmap(NULL, segment->size, PROT_READ, MAP_PRIVATE, segment->fd, 0);
+    if (segment->data == MAP_FAILED) {
+        segment->data = NULL;
+        return -1;
+    }
+
+    // The range is found by touching O(log n) pages, never the whole file
+    segment->end = segment->size;
+    if (query->since) {
+        segment->start = search_stamp(segment->data, segment->size, query->since, 0, &stats->probes);
+    }
+    if (query->until) {
+        segment->end = search_stamp(segment->data, segment->size, query->until, 1, &stats->probes);
+    }
+    if (segment->end < segment->start) {
+        segment->end = segment->start;
+    }
+    return 0;
+}
+
+static void segment_close(Segment *segment) {
+    if (segment->data != NULL) {
+        munmap(segment->data, segment->size);
+    }
+    if (segment->fd != -1) {
+        close(segment->fd);
+    }
+    segment->data = NULL;
+    segment->fd = -1;
+}
+
+// Function to list the segments whose time range meets the query's, from
+// the segment index, followed by log.txt
+static Segment *list_segments(const LogQuery *query, size_t *count) {
+    char *index = NULL;
+    size_t index_len = 0;
+
+    int fd = open(LOG_INDEX_FILE, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd != -1 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        index = malloc(st.st_size + 1);
+        if (index != NULL) {
+            ssize_t n = pread(fd, index, st.st_size, 0);
+            index_len = n > 0 ? n : 0;
+            index[index_len] = '\0';
+        }
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+
+    size_t lines = 1;
+    for (size_t i = 0; i < index_len; i++) {
+        lines += index[i] == '\n';
+    }
+    Segment *segments = malloc(lines * sizeof(Segment));
+    if (segments == NULL) {
+        free(index);
+        return NULL;
+    }
+
+    // "number<TAB>first<TAB>last<TAB>offset<TAB>bytes"
+    size_t used = 0;
+    char *line = index;
+    while (line != NULL && line < index + index_len) {
+        char *next = strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        char *field;
+        unsigned long number = strtoul(line, &field, 10);
+        if (number > 0 && strlen(field) > 2 * (STAMP_LEN + 1) && field[0] == '\t' &&
+            field[STAMP_LEN + 1] == '\t') {
+            const char *first = field + 1;
+            const char *last = field + STAMP_LEN + 2;
+            int wanted = (query->since == NULL || memcmp(last, query->since, strlen(query->since)) >= 0) &&
+                         (query->until == NULL || memcmp(first, query->until, strlen(query->until)) <= 0);
+            if (wanted) {
+                segments[used].number = number;
+                segments[used].fd = -1;
+                segments[used].data = NULL;
+                used++;
+            }
+        }
+        line = next;
+    }
+    free(index);
+
+    segments[used].number = 0;
+    segments[used].fd = -1;
+    segments[used].data = NULL;
+    *count = used + 1;
+    return segments;
+}
+
+// Function to print segment's selected range, or its records holding needle
+static int segment_print(const Segment *segment, const char *needle, size_t needle_len,
+                         LogQueryStats *stats, char *last) {
+    const char *data = segment->data;
+    size_t start = segment->start;
+    size_t end = segment->end;
+
+    if (needle == NULL) {
+        // One contiguous range: let the kernel copy it
+        if (end > start) {
+            output_flush();
+            ssize_t moved = transfer_range(segment->fd, start, end - start, output_fd());
+            if (moved == -1) {
+                return -1;
+            }
+            stats->bytes += moved;
+            if (moved > 0) {
+                *last = data[start + moved - 1];
+            }
+        }
+        return 0;
+    }
+
+    // memmem finds the next match, which is widened to its record
+    size_t pos = start;
+    while (pos < end) {
+        const char *match = memmem(data + pos, end - pos, needle, needle_len);
+        if (match == NULL) {
+            break;
+        }
+        size_t offset = match - data;
+        size_t record = record_before(data, segment->size, pos, offset);
+        size_t record_end = next_record(data, segment->size, offset + 1);
+        if (record_end > end) {
+            record_end = end;
+        }
+        output_write(data + record, record_end - record);
+        stats->records++;
+        stats->bytes += record_end - record;
+        *last = data[record_end - 1];
+        pos = record_end;
+    }
+    return 0;
+}
+
+// log.bin mapped: its records follow the header record
+typedef struct {
+    int fd;
+    char *data;
+    size_t size;
+    const LogRecord *records;
+    size_t count;
+} BinaryLog;
+
+// Function to map log.bin and check its header; a torn last record is left out
+static int binary_open(BinaryLog *log) {
+    memset(log, 0, sizeof(*log));
+    log->fd = open(LOG_BINARY_FILE, O_RDONLY | O_CLOEXEC);
+    if (log->fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(log->fd, &st) == -1) {
+        return -1;
+    }
+    log->size = st.st_size;
+    if (log->size < sizeof(LogFileHeader)) {
+        errno = EINVAL;
+        return -1;
+    }
+    log->data = mmap(NULL, log->size, PROT_READ, MAP_PRIVATE, log->fd, 0);
+    if (log->data == MAP_FAILED) {
+        log->data = NULL;
+        return -1;
+    }
+    const LogFileHeader *header = (const LogFileHeader *)log->data;
+    if (memcmp(header->magic, LOG_BINARY_MAGIC, sizeof(header->magic)) != 0 ||
+        header->record_size != LOG_RECORD_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    log->records = (const LogRecord *)(log->data + LOG_RECORD_SIZE);
+    log->count = log->size / LOG_RECORD_SIZE - 1;
+    madvise(log->data, log->size, MADV_SEQUENTIAL);
+    return 0;
+}
+
+static void binary_close(BinaryLog *log) {
+    if (log->data != NULL) {
+        munmap(log->data, log->size);
+    }
+    if (log->fd != -1) {
+        close(log->fd);
+    }
+}
+
+// Function to format a record's time as "YYYY-MM-DD HH:MM:SS" in local
+// time; the last second formatted is kept, as records come in bursts
+static void binary_stamp(uint64_t time_ns, char *stamp) {
+    static _Thread_local time_t cached = (time_t)-1;
+    static _Thread_local char cached_stamp[STAMP_LEN + 1];
+    time_t seconds = time_ns / 1000000000;
+    if (seconds != cached) {
+        struct tm tm;
+        localtime_r(&seconds, &tm);
+        strftime(cached_stamp, sizeof(cached_stamp), "%Y-%m-%d %H:%M:%S", &tm);
+        cached = seconds;
+    }
+    memcpy(stamp, cached_stamp, STAMP_LEN);
+}
+
+// Function to render a record as a text line:
+// "[YYYY-MM-DD HH:MM:SS.nnnnnnnnn] command "path"[ failed]\n"
+static size_t binary_render(const LogRecord *record, char *line) {
+    size_t len = 0;
+    line[len++] = '[';
+    binary_stamp(record->time_ns, line + len);
+    len += STAMP_LEN;
+    line[len++] = '.';
+    unsigned long fraction = record->time_ns % 1000000000;
+    for (int i = 8; i >= 0; i--) {
+        line[len + i] = '0' + fraction % 10;
+        fraction /= 10;
+    }
+    len += 9;
+    line[len++] = ']';
+    line[len++] = ' ';
+
+    const char *name = log_op_name(record->op);
+    size_t name_len = strlen(name);
+    memcpy(line + len, name, name_len);
+    len += name_len;
+
+    size_t path_len = record->path_len <= sizeof(record->path) ? record->path_len : sizeof(record->path);
+    if (path_len > 0) {
+        memcpy(line + len, " \"", 2);
+        len += 2;
+        if (record->flags & LOG_RECORD_TRUNCATED) {
+            memcpy(line + len, "...", 3);
+            len += 3;
+        }
+        memcpy(line + len, record->path, path_len);
+        len += path_len;
+        line[len++] = '"';
+    }
+    if (record->status != 0) {
+        memcpy(line + len, " failed", 7);
+        len += 7;
+    }
+    line[len++] = '\n';
+    return len;
+}
+
+// Longest line binary_render makes
+#define RENDER_MAX (LOG_RECORD_SIZE + STAMP_LEN + 64)
+
+// Function to find the first record whose stamp, cut to the length of
+// key, compares above key (after = 1) or at/above it (after = 0): a
+// binary search over record indexes, as every record is the same size
+static size_t binary_search_stamp(const BinaryLog *log, const char *key, int after,
+                                  unsigned long *probes) {
+    size_t key_len = strlen(key);
+    size_t lo = 0;
+    size_t hi = log->count;
+    char stamp[STAMP_LEN];
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        (*probes)++;
+        binary_stamp(log->records[mid].time_ns, stamp);
+        int order = memcmp(stamp, key, key_len);
+        if (order < 0 || (after && order == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Counts of one hour of the summary
+typedef struct {
+    uint64_t start_ns;              // local hour [start, end)
+    uint64_t end_ns;
+    unsigned long count[LOG_OP_COUNT];
+    unsigned long failed[LOG_OP_COUNT];
+} HourCounts;
+
+// Function to find or add the hour of time_ns; records are in time order
+// but for batches that raced, so the hour is nearly always the last one
+static HourCounts *summary_hour(HourCounts **hours, size_t *used, size_t *capacity,
+                                uint64_t time_ns) {
+    for (size_t i = *used; i > 0; i--) {
+        HourCounts *hour = &(*hours)[i - 1];
+        if (time_ns >= hour->start_ns && time_ns < hour->end_ns) {
+            return hour;
+        }
+    }
+
+    if (*used == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 64;
+        HourCounts *bigger = realloc(*hours, grown * sizeof(HourCounts));
+        if (bigger == NULL) {
+            return NULL;
+        }
+        *hours = bigger;
+        *capacity = grown;
+    }
+
+    // The local hour holding it: an hour's start is not a multiple of 3600
+    // in every time zone
+    time_t seconds = time_ns / 1000000000;
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    time_t into_hour = tm.tm_min * 60 + tm.tm_sec;
+
+    HourCounts *hour = &(*hours)[(*used)++];
+    memset(hour, 0, sizeof(*hour));
+    hour->start_ns = (uint64_t)(seconds - into_hour) * 1000000000;
+    hour->end_ns = hour->start_ns + 3600ULL * 1000000000;
+    return hour;
+}
+
+static int compare_hours(const void *a, const void *b) {
+    uint64_t left = ((const HourCounts *)a)->start_ns;
+    uint64_t right = ((const HourCounts *)b)->start_ns;
+    return left < right ? -1 : left > right;
+}
+
+// Function to append value to line right-aligned in width characters
+static size_t put_column(char *line, unsigned long value, int width) {
+    char digits[32];
+    int len = 0;
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    size_t used = 0;
+    for (int pad = width - len; pad > 0; pad--) {
+        line[used++] = ' ';
+    }
+    while (len > 0) {
+        line[used++] = digits[--len];
+    }
+    return used;
+}
+
+// Function to count the records in [start, end) per local hour and op
+// code and print one line per hour and op. Each hour is counted by a tight
+// loop over the fixed-size headers that only leaves it when the hour changes.
+static int binary_summary(const BinaryLog *log, size_t start, size_t end, LogQueryStats *stats) {
+    HourCounts *hours = NULL;
+    size_t used = 0;
+    size_t capacity = 0;
+
+    size_t i = start;
+    while (i < end) {
+        HourCounts *hour = summary_hour(&hours, &used, &capacity, log->records[i].time_ns);
+        if (hour == NULL) {
+            free(hours);
+            return -1;
+        }
+        uint64_t lo = hour->start_ns;
+        uint64_t hi = hour->end_ns;
+        for (; i < end; i++) {
+            const LogRecord *record = &log->records[i];
+            if (record->time_ns < lo || record->time_ns >= hi) {
+                break;
+            }
+            unsigned op = record->op < LOG_OP_COUNT ? record->op : LOG_OP_OTHER;
+            hour->count[op]++;
+            hour->failed[op] += record->status != 0;
+        }
+    }
+    qsort(hours, used, sizeof(HourCounts), compare_hours);
+
+    // An hour that came back later (raced batches) is added to its next copy
+    char line[256];
+    size_t len = 0;
+    const char *heading = "Hour              Operation                  Records   Failed\n";
+    output_write(heading, strlen(heading));
+    for (size_t h = 0; h < used; h++) {
+        if (h + 1 < used && hours[h + 1].start_ns == hours[h].start_ns) {
+            for (int op = 0; op < LOG_OP_COUNT; op++) {
+                hours[h + 1].count[op] += hours[h].count[op];
+                hours[h + 1].failed[op] += hours[h].failed[op];
+            }
+            continue;
+        }
+        char stamp[STAMP_LEN];
+        binary_stamp(hours[h].start_ns, stamp);
+        for (int op = 0; op < LOG_OP_COUNT; op++) {
+            if (hours[h].count[op] == 0) {
+                continue;
+            }
+            len = 0;
+            memcpy(line + len, stamp, 13);
+            len += 13;
+            memcpy(line + len, ":00  ", 5);
+            len += 5;
+            const char *name = log_op_name(op);
+            size_t name_len = strlen(name);
+            memcpy(line + len, name, name_len);
+            len += name_len;
+            for (; name_len < 22; name_len++) {
+                line[len++] = ' ';
+            }
+            len += put_column(line + len, hours[h].count[op], 11);
+            len += put_column(line + len, hours[h].failed[op], 9);
+            line[len++] = '\n';
+            output_write(line, len);
+            stats->bytes += len;
+        }
+    }
+    stats->records = end - start;
+    free(hours);
+    return 0;
+}
+
+// Function to answer query from log.bin: the range comes from two binary
+// searches over record indexes, --tail counts back from its end, and only
+// the records printed are rendered to text
+static int binary_query(const LogQuery *query, LogQueryStats *stats) {
+    BinaryLog log;
+    if (binary_open(&log) == -1) {
+        int saved = errno;
+        binary_close(&log);
+        errno = saved;
+        return -1;
+    }
+    stats->segments = 1;
+
+    size_t start = 0;
+    size_t end = log.count;
+    if (query->since) {
+        start = binary_search_stamp(&log, query->since, 0, &stats->probes);
+    }
+    if (query->until) {
+        end = binary_search_stamp(&log, query->until, 1, &stats->probes);
+    }
+    if (end < start) {
+        end = start;
+    }
+
+    const char *needle = query->grep && query->grep[0] ? query->grep : NULL;
+    size_t needle_len = needle ? strlen(needle) : 0;
+    char line[RENDER_MAX];
+    int result = 0;
+
+    if (query->summary) {
+        result = binary_summary(&log, start, end, stats);
+        binary_close(&log);
+        return result;
+    }
+
+    if (query->tail > 0) {
+        unsigned long found = 0;
+        size_t pos = end;
+        while (pos > start && found < query->tail) {
+            pos--;
+            if (needle == NULL || memmem(line, binary_render(&log.records[pos], line), needle, needle_len)) {
+                found++;
+            }
+        }
+        start = pos;
+    }
+
+    for (size_t i = start; i < end; i++) {
+        size_t len = binary_render(&log.records[i], line);
+        if (needle != NULL && memmem(line, len, needle, needle_len) == NULL) {
+            continue;
+        }
+        output_write(line, len);
+        stats->records++;
+        stats->bytes += len;
+    }
+    binary_close(&log);
+    return result;
+}
+
+// Function to print the records of the log that match query
+int log_query(const LogQuery *query, LogQueryStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (log_get_format() == LOG_FORMAT_BINARY) {
+        return binary_query(query, stats);
+    }
+    if (query->summary) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t count;
+    Segment *segments = list_segments(query, &count);
+    if (segments == NULL) {
+        return -1;
+    }
+
+    const char *needle = query->grep;
+    size_t needle_len = needle ? strlen(needle) : 0;
+    if (needle_len == 0) {
+        needle = NULL;
+    }
+
+    int result = 0;
+    size_t first = 0;
+
+    // --tail walks back from the end, one record (and segment) at a time,
+    // so only the segments holding the last N records are opened
+    if (query->tail > 0) {
+        unsigned long found = 0;
+        first = count;
+        while (first > 0 && found < query->tail && result == 0) {
+            Segment *segment = &segments[--first];
+            result = segment_open(segment, query, stats);
+            size_t pos = segment->end;
+            while (result == 0 && found < query->tail && pos > segment->start) {
+                size_t record = record_before(segment->data, segment->size, segment->start, pos - 1);
+                if (record_matches(segment->data, record, pos, needle, needle_len)) {
+                    found++;
+                }
+                pos = record;
+            }
+            segment->start = pos;
+        }
+    }
+
+    char last = '\n';
+    for (size_t i = first; i < count && result == 0; i++) {
+        if (query->tail == 0) {
+            result = segment_open(&segments[i], query, stats);
+        }
+        if (result == 0) {
+            result = segment_print(&segments[i], needle, needle_len, stats, &last);
+        }
+        segment_close(&segments[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        segment_close(&segments[i]);
+    }
+    free(segments);
+
+    // Add a newline if the log doesn't end with one
+    if (last != '\n') {
+        output_write("\n", 1);
+    }
+    return result;
+}
\ No newline at end of file
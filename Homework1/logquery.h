@@ -0,0 +1,31 @@
+#ifndef LOGQUERY_H
+#define LOGQUERY_H
+
+#include <stddef.h>
+
+// What showLogs prints; every field is optional
+typedef struct {
+    const char *since;      // first timestamp, "YYYY-MM-DD[ HH[:MM[:SS]]]"
+    const char *until;      // last timestamp (inclusive, same format)
+    unsigned long tail;     // only the last N records (0 = all)
+    const char *grep;       // only records containing this text
+    int summary;            // count records per hour and operation instead
+} LogQuery;
+
+typedef struct {
+    unsigned long records;  // records printed (counted when filtering)
+    unsigned long probes;   // timestamps compared by the range search
+    unsigned long segments; // files opened (log.txt included)
+    size_t bytes;           // bytes printed
+} LogQueryStats;
+
+// Function to check a --since/--until value; 0 if it is a timestamp prefix
+int log_time_valid(const char *text);
+
+// Function to print the records of the log that match query to stdout:
+// log.txt and the rotated segments whose time range meets the query's,
+// or log.bin rendered as text. A summary needs the binary log. Returns 0,
+// or -1 if a file cannot be read.
+int log_query(const LogQuery *query, LogQueryStats *stats);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,514 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "oplog.h"
+
+// Log state shared by every command of the process; the lock is only
+// contended when serve runs commands on several threads
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static int log_fd = -1;
+static LogSyncPolicy log_sync = LOG_SYNC_NEVER;
+static char log_buffer[LOG_BUFFER_SIZE];
+static size_t log_used = 0;
+
+// Text or binary records (--log-format); binary ones are filed under the
+// command each thread is running
+static LogFormat log_format = LOG_FORMAT_TEXT;
+static _Thread_local LogContext log_context = { LOG_OP_OTHER, NULL };
+
+static const char *log_op_names[LOG_OP_COUNT] = {
+    "other", "createDir", "createFile", "listDir", "listFilesByExtension", "indexDir",
+    "watch", "du", "hashFile", "findDuplicates", "searchFiles", "readFile",
+    "appendToFile", "appendDaemon", "copyFile", "moveFile", "deleteFile", "deleteDir",
+    "showLogs", "batch", "serve", "createFiles"
+};
+
+// "[YYYY-MM-DD HH:MM:SS] " is only reformatted when the second changes
+static time_t stamp_time = (time_t)-1;
+static char stamp[32];
+static size_t stamp_len = 0;
+
+// Rotation policy (--log-rotate, --log-compress)
+typedef enum {
+    LOG_ROTATE_NEVER,
+    LOG_ROTATE_SIZE,
+    LOG_ROTATE_HOURLY,
+    LOG_ROTATE_DAILY
+} LogRotatePolicy;
+
+static LogRotatePolicy log_rotate = LOG_ROTATE_NEVER;
+static unsigned long rotate_bytes = 0;
+static int log_compress = 0;
+
+// The log.txt we have open: a rotation elsewhere shows up as a new inode.
+// log_size is its size when opened plus what we wrote since.
+static ino_t log_inode = 0;
+static unsigned long log_size = 0;
+static char log_period[16];     // "YYYY-MM-DD[ HH]" of its first record
+
+// Length of the stamp prefix that names a rotation period
+static size_t period_len() {
+    return log_rotate == LOG_ROTATE_HOURLY ? 13 : 10;
+}
+
+// Function to create log.bin with its header in place: it is written to a
+// temporary file that is then linked in, so no record can come before it
+static int log_create_binary() {
+    char temp[] = LOG_BINARY_FILE ".XXXXXX";
+    int fd = mkstemp(temp);
+    if (fd == -1) {
+        return -1;
+    }
+
+    LogFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOG_BINARY_MAGIC, sizeof(header.magic));
+    header.record_size = LOG_RECORD_SIZE;
+    int result = fchmod(fd, 0644) == 0 && write(fd, &header, sizeof(header)) == sizeof(header) ? 0 : -1;
+    close(fd);
+
+    // Someone else creating it first is fine too
+    if (result == 0 && link(temp, LOG_BINARY_FILE) == -1 && errno != EEXIST) {
+        result = -1;
+    }
+    unlink(temp);
+    return result;
+}
+
+// Function to open log.txt (or log.bin) and note what rotation needs to
+// know about it
+static int log_open_file() {
+    if (log_format == LOG_FORMAT_BINARY) {
+        log_fd = open(LOG_BINARY_FILE, O_RDWR | O_APPEND);
+        if (log_fd == -1 && errno == ENOENT && log_create_binary() == 0) {
+            log_fd = open(LOG_BINARY_FILE, O_RDWR | O_APPEND);
+        }
+    } else {
+        log_fd = open(LOG_FILE, O_RDWR | O_CREAT | O_APPEND, 0644);
+    }
+    if (log_fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    log_inode = 0;
+    log_size = 0;
+    if (fstat(log_fd, &st) == 0) {
+        log_inode = st.st_ino;
+        log_size = st.st_size;
+    }
+
+    // Time rotation compares the period of the first record with now
+    char first[32];
+    log_period[0] = '\0';
+    if (log_rotate >= LOG_ROTATE_HOURLY && pread(log_fd, first, 21, 0) == 21 && first[0] == '[') {
+        memcpy(log_period, first + 1, period_len());
+        log_period[period_len()] = '\0';
+    }
+    return 0;
+}
+
+static void log_rotate_now();
+static void log_flush_locked();
+
+// Function to open the log once; buffered records are flushed at exit
+static int log_open() {
+    if (log_fd != -1) {
+        return 0;
+    }
+
+    if (log_open_file() == -1) {
+        const char *error_msg = "Error opening log file\n";
+        write(STDERR_FILENO, error_msg, strlen(error_msg));
+        return -1;
+    }
+
+    atexit(log_flush);
+    if (log_format == LOG_FORMAT_BINARY) {
+        log_rotate = LOG_ROTATE_NEVER;  // Segments are text only
+    }
+    if (log_rotate == LOG_ROTATE_SIZE && log_size >= rotate_bytes) {
+        log_rotate_now();
+    }
+    return 0;
+}
+
+// Function to choose the fsync policy
+int log_set_sync(const char *policy) {
+    if (strcmp(policy, "never") == 0) {
+        log_sync = LOG_SYNC_NEVER;
+    } else if (strcmp(policy, "batch") == 0) {
+        log_sync = LOG_SYNC_BATCH;
+    } else if (strcmp(policy, "record") == 0) {
+        log_sync = LOG_SYNC_RECORD;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Function to choose the log format
+int log_set_format(const char *format) {
+    if (strcmp(format, "text") == 0) {
+        log_format = LOG_FORMAT_TEXT;
+    } else if (strcmp(format, "binary") == 0) {
+        log_format = LOG_FORMAT_BINARY;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Function to get the log format in use
+LogFormat log_get_format() {
+    return log_format;
+}
+
+// Function to map a command name to its LogOp
+int log_op_code(const char *command) {
+    for (int op = 1; op < LOG_OP_COUNT; op++) {
+        if (strcmp(command, log_op_names[op]) == 0) {
+            return op;
+        }
+    }
+    return LOG_OP_OTHER;
+}
+
+// Function to name a LogOp
+const char *log_op_name(int op) {
+    return op >= 0 && op < LOG_OP_COUNT ? log_op_names[op] : log_op_names[LOG_OP_OTHER];
+}
+
+// Function to set the context records of this thread are filed under
+LogContext log_set_context(LogContext context) {
+    LogContext previous = log_context;
+    log_context = context;
+    return previous;
+}
+
+// Function to choose when log.txt is rotated
+int log_set_rotate(const char *policy) {
+    if (strcmp(policy, "hourly") == 0) {
+        log_rotate = LOG_ROTATE_HOURLY;
+        return 0;
+    }
+    if (strcmp(policy, "daily") == 0) {
+        log_rotate = LOG_ROTATE_DAILY;
+        return 0;
+    }
+
+    // A size with an optional K, M or G suffix
+    char *end;
+    unsigned long bytes = strtoul(policy, &end, 10);
+    if (end == policy || policy[0] == '-') {
+        return -1;
+    }
+    if (*end == 'K' || *end == 'M' || *end == 'G') {
+        bytes <<= *end == 'K' ? 10 : *end == 'M' ? 20 : 30;
+        end++;
+    }
+    if (*end != '\0' || bytes == 0) {
+        return -1;
+    }
+    log_rotate = LOG_ROTATE_SIZE;
+    rotate_bytes = bytes;
+    return 0;
+}
+
+// Function to gzip segments once a newer one exists
+int log_set_compress(int enabled) {
+    log_compress = enabled;
+    return 0;
+}
+
+// Function to format an unsigned number with at least width digits
+static size_t put_number(char *buffer, unsigned long value, int width) {
+    char digits[32];
+    int len = 0;
+    do {
+        digits[len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0 || len < width);
+
+    for (int i = 0; i < len; i++) {
+        buffer[i] = digits[len - 1 - i];
+    }
+    return len;
+}
+
+// Function to build the file name of segment number
+void log_segment_name(char *buffer, unsigned long number) {
+    size_t len = 0;
+    memcpy(buffer, "log.", 4);
+    len = 4 + put_number(buffer + 4, number, 6);
+    memcpy(buffer + len, ".txt", 5);
+}
+
+// Function to find the stamp of the last record in the first size bytes
+// of fd; records are at most LOG_BUFFER_SIZE long
+static int last_stamp(int fd, off_t size, char *stamp_out) {
+    char tail[2 * LOG_BUFFER_SIZE];
+    off_t from = size > (off_t)sizeof(tail) ? size - (off_t)sizeof(tail) : 0;
+    ssize_t n = pread(fd, tail, size - from, from);
+    if (n <= 0) {
+        return -1;
+    }
+
+    for (ssize_t i = n - 1; i >= 0; i--) {
+        if (tail[i] == '[' && (i > 0 ? tail[i - 1] == '\n' : from == 0) && n - i >= 21) {
+            memcpy(stamp_out, tail + i + 1, 19);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Function to start gzip on a segment without waiting for it
+static void log_compress_segment(unsigned long number) {
+    char name[LOG_SEGMENT_NAME_MAX];
+    log_segment_name(name, number);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // The grandchild is adopted by init, so nobody waits for gzip
+        if (fork() == 0) {
+            int null = open("/dev/null", O_RDWR);
+            dup2(null, STDIN_FILENO);
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+            execlp("gzip", "gzip", "-q", "-n", name, (char *)NULL);
+        }
+        _exit(0);
+    }
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+}
+
+// Function to turn log.txt into the next segment if it is (still) due.
+// The index file's lock makes rotations one at a time; writers take no
+// lock and notice the new log.txt at their next flush.
+static void log_rotate_now() {
+    int index_fd = open(LOG_INDEX_FILE, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (index_fd == -1) {
+        return;
+    }
+    flock(index_fd, LOCK_EX);
+
+    char first[32];
+    char last[32];
+    struct stat st;
+    int fd = open(LOG_FILE, O_RDONLY);
+    int due = fd != -1 && fstat(fd, &st) == 0 && st.st_size > 0 &&
+              pread(fd, first, 21, 0) == 21 && first[0] == '[' &&
+              last_stamp(fd, st.st_size, last) == 0;
+
+    // Someone else may have rotated it while we waited for the lock
+    if (due && log_rotate == LOG_ROTATE_SIZE) {
+        due = (unsigned long)st.st_size >= rotate_bytes;
+    } else if (due) {
+        time_t now = time(NULL);
+        struct tm local;
+        char current[32];
+        localtime_r(&now, &local);
+        strftime(current, sizeof(current), "%Y-%m-%d %H", &local);
+        due = memcmp(first + 1, current, period_len()) != 0;
+    }
+
+    unsigned long number = 1;
+    unsigned long offset = 0;
+    if (due) {
+        // The last index line gives the previous number and where it ended
+        struct stat index_st;
+        char line[256];
+        if (fstat(index_fd, &index_st) == 0 && index_st.st_size > 0) {
+            off_t from = index_st.st_size > (off_t)sizeof(line) - 1 ? index_st.st_size - (off_t)sizeof(line) + 1 : 0;
+            ssize_t n = pread(index_fd, line, index_st.st_size - from, from);
+            if (n > 0) {
+                line[n] = '\0';
+                if (line[n - 1] == '\n') {
+                    line[--n] = '\0';
+                }
+                char *start = strrchr(line, '\n');
+                start = start ? start + 1 : line;
+                char *field = start;
+                number = strtoul(field, &field, 10) + 1;
+                for (int tabs = 0; tabs < 2 && field != NULL; tabs++) {  // to the offset
+                    field = strchr(field + 1, '\t');
+                }
+                if (field != NULL) {
+                    offset = strtoul(field + 1, &field, 10);
+                    offset += strtoul(field, NULL, 10);
+                }
+            }
+        }
+
+        char name[LOG_SEGMENT_NAME_MAX];
+        log_segment_name(name, number);
+        // link + unlink never overwrites an existing segment
+        if (link(LOG_FILE, name) == 0 && unlink(LOG_FILE) == 0) {
+            char record[128];
+            size_t len = put_number(record, number, 1);
+            record[len++] = '\t';
+            memcpy(record + len, first + 1, 19);
+            len += 19;
+            record[len++] = '\t';
+            memcpy(record + len, last, 19);
+            len += 19;
+            record[len++] = '\t';
+            len += put_number(record + len, offset, 1);
+            record[len++] = '\t';
+            len += put_number(record + len, st.st_size, 1);
+            record[len++] = '\n';
+            write(index_fd, record, len);
+        } else {
+            due = 0;
+        }
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+    flock(index_fd, LOCK_UN);
+    close(index_fd);
+
+    // Follow log.txt to its new file either way
+    if (log_fd != -1) {
+        close(log_fd);
+        log_open_file();
+    }
+    if (due && log_compress && number > 1) {
+        log_compress_segment(number - 1);  // Cold: nobody writes to it any more
+    }
+}
+
+// Function to write buffered records out with a single write
+void log_flush() {
+    pthread_mutex_lock(&log_lock);
+    log_flush_locked();
+    pthread_mutex_unlock(&log_lock);
+}
+
+static void log_flush_locked() {
+    if (log_used == 0 || log_fd == -1) {
+        return;
+    }
+
+    // A rotation elsewhere moved the file we hold: follow log.txt
+    struct stat st;
+    if (stat(log_format == LOG_FORMAT_BINARY ? LOG_BINARY_FILE : LOG_FILE, &st) == -1 ||
+        st.st_ino != log_inode) {
+        close(log_fd);
+        if (log_open_file() == -1) {
+            log_used = 0;
+            return;
+        }
+    }
+
+    write(log_fd, log_buffer, log_used);
+    log_size += log_used;
+    log_used = 0;
+
+    if (log_sync != LOG_SYNC_NEVER) {
+        fdatasync(log_fd);
+    }
+    if (log_rotate == LOG_ROTATE_SIZE && log_size >= rotate_bytes) {
+        log_rotate_now();
+    }
+}
+
+// Function to add a binary record: the stamp in ns, the context's op code
+// and path, and the status the caller gave
+static void log_binary_record(int status) {
+    if (log_used + LOG_RECORD_SIZE > LOG_BUFFER_SIZE) {
+        log_flush_locked();
+    }
+
+    LogRecord record;
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    memset(&record, 0, sizeof(record));
+    record.time_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    record.op = log_context.op;
+    record.status = status;
+
+    const char *path = log_context.path ? log_context.path : "";
+    size_t path_len = strlen(path);
+    if (path_len > sizeof(record.path)) {
+        path += path_len - sizeof(record.path);
+        path_len = sizeof(record.path);
+        record.flags |= LOG_RECORD_TRUNCATED;
+    }
+    memcpy(record.path, path, path_len);
+    record.path_len = path_len;
+    memcpy(log_buffer + log_used, &record, sizeof(record));
+    log_used += sizeof(record);
+}
+
+// Function to log operations
+void log_operation(const char *message, int status) {
+    pthread_mutex_lock(&log_lock);
+    if (log_open() == -1) {
+        pthread_mutex_unlock(&log_lock);
+        return;
+    }
+
+    if (log_format == LOG_FORMAT_BINARY) {
+        log_binary_record(status);
+        if (log_sync == LOG_SYNC_RECORD) {
+            log_flush_locked();
+        }
+        pthread_mutex_unlock(&log_lock);
+        return;
+    }
+
+    time_t now = time(NULL);
+    if (now != stamp_time) {
+        struct tm timeinfo;
+        localtime_r(&now, &timeinfo);  // Threads outside the lock format times too
+        stamp_len = strftime(stamp, sizeof(stamp), "[%Y-%m-%d %H:%M:%S] ", &timeinfo);
+        stamp_time = now;
+
+        // A new hour or day starts a new segment before its first record
+        if (log_rotate >= LOG_ROTATE_HOURLY) {
+            if (log_period[0] != '\0' && memcmp(log_period, stamp + 1, period_len()) != 0) {
+                log_flush_locked();
+                log_rotate_now();
+            }
+            memcpy(log_period, stamp + 1, period_len());
+            log_period[period_len()] = '\0';
+        }
+    }
+
+    // Build the record in place; overly long messages are cut so the
+    // record still fits one atomic write
+    size_t message_len = strlen(message);
+    if (stamp_len + message_len + 1 > LOG_BUFFER_SIZE) {
+        message_len = LOG_BUFFER_SIZE - stamp_len - 1;
+    }
+    size_t record_len = stamp_len + message_len + 1;
+
+    if (log_used + record_len > LOG_BUFFER_SIZE) {
+        log_flush_locked();
+    }
+
+    char *record = log_buffer + log_used;
+    memcpy(record, stamp, stamp_len);
+    memcpy(record + stamp_len, message, message_len);
+    record[record_len - 1] = '\n';
+    log_used += record_len;
+
+    if (log_sync == LOG_SYNC_RECORD) {
+        log_flush_locked();
+    }
+    pthread_mutex_unlock(&log_lock);
+}
\ No newline at end of file
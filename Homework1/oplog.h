@@ -0,0 +1,130 @@
+#ifndef OPLOG_H
+#define OPLOG_H
+
+#include <limits.h>
+#include <stdint.h>
+
+#define LOG_FILE "log.txt"
+
+// Records are batched and written with one write() each time the buffer
+// fills; keeping a batch under PIPE_BUF keeps it a single atomic append
+// even when forked children log at the same time
+#define LOG_BUFFER_SIZE PIPE_BUF
+
+// When log records reach the disk
+typedef enum {
+    LOG_SYNC_NEVER,     // leave it to the kernel
+    LOG_SYNC_BATCH,     // fdatasync after every batch write
+    LOG_SYNC_RECORD     // write and fdatasync every record
+} LogSyncPolicy;
+
+// Rotated logs: log.txt is renamed to log.000001.txt, log.000002.txt, ...
+// and every rotation appends one line to the segment index:
+// "number<TAB>first stamp<TAB>last stamp<TAB>offset<TAB>bytes\n", where
+// offset is where the segment starts in the whole history. Segments older
+// than the newest may be gzip'ed to log.NNNNNN.txt.gz.
+#define LOG_INDEX_FILE "log.index"
+#define LOG_SEGMENT_NAME_MAX 32
+
+// Binary log (--log-format=binary): log.bin holds fixed-size records, so
+// record i starts at (i + 1) * LOG_RECORD_SIZE, after the file header.
+// Each record is the header fields and the path it is about; the message
+// text is not kept. Paths longer than fit keep their last bytes.
+#define LOG_BINARY_FILE "log.bin"
+#define LOG_BINARY_MAGIC "FMLOGv1"
+#define LOG_RECORD_SIZE 128
+#define LOG_RECORD_TRUNCATED 1
+
+typedef struct {
+    uint64_t time_ns;           // CLOCK_REALTIME
+    uint16_t op;                // LogOp of the command that logged it
+    uint16_t status;            // LOG_SUCCESS or LOG_FAILURE, from the caller
+    uint16_t path_len;          // bytes of path in use
+    uint16_t flags;             // LOG_RECORD_TRUNCATED: path lost its start
+    char path[LOG_RECORD_SIZE - 16];
+} LogRecord;
+
+typedef struct {
+    char magic[8];              // LOG_BINARY_MAGIC
+    uint32_t record_size;       // LOG_RECORD_SIZE
+    char unused[LOG_RECORD_SIZE - 12];
+} LogFileHeader;
+
+typedef enum {
+    LOG_FORMAT_TEXT,
+    LOG_FORMAT_BINARY
+} LogFormat;
+
+// Operation codes, one per command; LOG_OP_OTHER for anything else
+typedef enum {
+    LOG_OP_OTHER,
+    LOG_OP_CREATE_DIR,
+    LOG_OP_CREATE_FILE,
+    LOG_OP_LIST_DIR,
+    LOG_OP_LIST_BY_EXTENSION,
+    LOG_OP_INDEX_DIR,
+    LOG_OP_WATCH,
+    LOG_OP_DU,
+    LOG_OP_HASH_FILE,
+    LOG_OP_FIND_DUPLICATES,
+    LOG_OP_SEARCH_FILES,
+    LOG_OP_READ_FILE,
+    LOG_OP_APPEND_TO_FILE,
+    LOG_OP_APPEND_DAEMON,
+    LOG_OP_COPY_FILE,
+    LOG_OP_MOVE_FILE,
+    LOG_OP_DELETE_FILE,
+    LOG_OP_DELETE_DIR,
+    LOG_OP_SHOW_LOGS,
+    LOG_OP_BATCH,
+    LOG_OP_SERVE,
+    LOG_OP_CREATE_FILES,
+    LOG_OP_COUNT
+} LogOp;
+
+// What binary records are filed under: the running command and its path
+typedef struct {
+    int op;
+    const char *path;
+} LogContext;
+
+// Function to choose the log format ("text" or "binary")
+int log_set_format(const char *format);
+
+// Function to get the log format in use
+LogFormat log_get_format();
+
+// Function to map a command name to its LogOp, and back
+int log_op_code(const char *command);
+const char *log_op_name(int op);
+
+// Function to set the context records of this thread are filed under;
+// returns the previous one so nested commands (batch) can restore it
+LogContext log_set_context(LogContext context);
+
+// Function to choose the fsync policy ("never", "batch" or "record")
+int log_set_sync(const char *policy);
+
+// Function to rotate log.txt once it reaches a size ("64M", "500K", bytes)
+// or when the hour or day of its first record is over ("hourly", "daily")
+int log_set_rotate(const char *policy);
+
+// Function to gzip segments once a newer one exists (in the background)
+int log_set_compress(int enabled);
+
+// Function to build the file name of segment number
+void log_segment_name(char *buffer, unsigned long number);
+
+// Outcome of a logged operation, kept as the binary record's status
+#define LOG_SUCCESS 0
+#define LOG_FAILURE 1
+
+// Function to log operations (buffered); status is LOG_SUCCESS or
+// LOG_FAILURE as decided by the caller
+void log_operation(const char *message, int status);
+
+// Function to write buffered records out; call before fork() and before
+// reading the log back
+void log_flush();
+
+#endif
\ No newline at end of file
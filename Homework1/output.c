@@ -0,0 +1,122 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "output.h"
+
+// Each thread has its own buffer and descriptor (serve runs commands on
+// worker threads, each answering a different client); new threads start
+// on stdout and take the main thread's buffer size. Threads working for a
+// command write to that command's state, see output_current().
+struct OutputState {
+    char *buffer;
+    size_t size;
+    size_t used;
+    int target;
+};
+
+static _Thread_local OutputState output_state = { NULL, 0, 0, STDOUT_FILENO };
+static size_t output_default = 0;
+static int output_registered = 0;
+
+// Function to write a whole range out, retrying short writes
+static void write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+// Function to write everything queued in state
+static void state_flush(OutputState *state) {
+    if (state->used > 0) {
+        write_all(state->target, state->buffer, state->used);
+        state->used = 0;
+    }
+}
+
+// Function to size the stdout buffer
+int output_init(size_t size) {
+    OutputState *state = &output_state;
+    state_flush(state);
+    free(state->buffer);
+    state->buffer = NULL;
+    state->size = 0;
+
+    if (size > 0) {
+        state->buffer = malloc(size);
+        if (state->buffer == NULL) {
+            return -1;
+        }
+        state->size = size;
+    }
+    output_default = size;
+
+    if (!output_registered) {
+        atexit(output_flush);
+        output_registered = 1;
+    }
+    return 0;
+}
+
+// Function to send this thread's output to fd from now on
+int output_set_fd(int fd) {
+    OutputState *state = &output_state;
+    state_flush(state);
+    state->target = fd;
+    if (state->buffer == NULL && output_default > 0) {
+        state->buffer = malloc(output_default);
+        state->size = state->buffer != NULL ? output_default : 0;
+    }
+    return 0;
+}
+
+// Function to get the descriptor this thread's output goes to
+int output_fd() {
+    return output_state.target;
+}
+
+// Function to get this thread's output, for threads working on its behalf
+OutputState *output_current() {
+    return &output_state;
+}
+
+// Function to write everything queued so far
+void output_flush() {
+    state_flush(&output_state);
+}
+
+// Function to queue bytes on state's buffer
+void output_write_to(OutputState *state, const void *data, size_t len) {
+    if (state->used + len > state->size) {
+        state_flush(state);
+
+        // Too big to be worth copying: send it straight through
+        if (len >= state->size) {
+            write_all(state->target, data, len);
+            return;
+        }
+    }
+
+    memcpy(state->buffer + state->used, data, len);
+    state->used += len;
+}
+
+// Function to queue bytes for stdout
+void output_write(const void *data, size_t len) {
+    output_write_to(&output_state, data, len);
+}
+
+// Function to queue a NUL-terminated string for stdout
+void output_string(const char *text) {
+    output_write(text, strlen(text));
+}
\ No newline at end of file
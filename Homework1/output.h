@@ -0,0 +1,42 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+
+// Default stdout buffer; --output-buffer=BYTES changes it, 0 writes through
+#define OUTPUT_BUFFER_DEFAULT (256 * 1024)
+
+// Function to size the stdout buffer, flushed automatically at exit
+int output_init(size_t size);
+
+// Function to queue bytes for stdout (binary-safe)
+void output_write(const void *data, size_t len);
+
+// Function to queue a NUL-terminated string for stdout
+void output_string(const char *text);
+
+// Function to write everything queued so far; call before fork() and
+// before anything else writes to stdout
+void output_flush();
+
+// Function to send the calling thread's output to fd instead of stdout
+// (serve answers each client on its own reply FIFO)
+int output_set_fd(int fd);
+
+// Function to get the descriptor the calling thread's output goes to;
+// code writing around the buffer (sendfile, splice) must use it
+int output_fd();
+
+// A thread's output: its buffer and the descriptor it drains to
+typedef struct OutputState OutputState;
+
+// Function to get the calling thread's output. Worker threads write a
+// command's results to it with output_write_to (serialized by their own
+// lock, while the command's thread waits for them); their own output
+// would go to stdout with no buffer.
+OutputState *output_current();
+
+// Function to queue bytes on another thread's output
+void output_write_to(OutputState *state, const void *data, size_t len);
+
+#endif
\ No newline at end of file
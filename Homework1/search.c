@@ -0,0 +1,402 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "search.h"
+#include "output.h"
+#include "walker.h"
+
+#define SEARCH_SMALL (64 * 1024)    // read with pread, mapping costs more
+#define SEARCH_BINARY_PROBE 4096    // a NUL byte in here means a binary file
+#define SEARCH_CHUNK (64 * 1024)    // output handed over per worker
+
+// Bytes of text from most to least common; anything else counts as rare
+static const char common_bytes[] =
+    " etaoinsrhldcumfpgwybvkxjqzETAOINSRHLDCUMFPGWYBVKXJQZ0123456789";
+
+// The pattern and the byte of it the scanner looks for with memchr
+typedef struct {
+    const char *text;
+    size_t len;
+    size_t rare;                // offset of its least common byte
+} Pattern;
+
+// Paths of the files to search, kept in one block per walker thread
+typedef struct {
+    char *names;                // NUL-terminated paths one after another
+    size_t used;
+    size_t cap;
+    size_t count;
+    unsigned long errors;
+    char pad[64];
+} SearchList;
+
+typedef struct {
+    const char *extension;
+    size_t ext_len;
+    SearchList lists[WALK_MAX_THREADS];
+} SearchScan;
+
+// One search thread: it prints into data and hands full chunks over
+typedef struct {
+    struct SearchJob *job;
+    pthread_t thread;
+    char *data;
+    size_t used;
+    size_t cap;
+    SearchStats stats;
+    char pad[64];
+} SearchWorker;
+
+typedef struct SearchJob {
+    int root_fd;
+    const char *root;
+    size_t root_len;
+    Pattern pattern;
+    char **paths;
+    size_t count;
+    size_t next;                // next file to take
+    OutputState *output;        // the caller's output, not the worker's own
+    pthread_mutex_t lock;       // output_write is not thread-safe
+} SearchJob;
+
+static int byte_frequency(unsigned char c) {
+    const char *found = c != '\0' ? strchr(common_bytes, c) : NULL;
+    return found != NULL ? (int)(sizeof(common_bytes) - (found - common_bytes)) : 0;
+}
+
+// Function to find pattern in [data, end): memchr (vectorized in libc)
+// jumps between places holding its rarest byte, then memcmp checks them
+static const char *pattern_find(const Pattern *pattern, const char *data, const char *end) {
+    if (pattern->len == 1) {
+        return memchr(data, pattern->text[0], end - data);
+    }
+    const char *p = data + pattern->rare;
+    while (p < end) {
+        const char *hit = memchr(p, pattern->text[pattern->rare], end - p);
+        if (hit == NULL) {
+            return NULL;
+        }
+        const char *start = hit - pattern->rare;
+        if (start + pattern->len <= end && memcmp(start, pattern->text, pattern->len) == 0) {
+            return start;
+        }
+        p = hit + 1;
+    }
+    return NULL;
+}
+
+// Walker callback: keep the regular files whose name has the extension
+static int search_visit(int worker, int dfd, const char *path, size_t path_len,
+                        const char *name, unsigned char type, void *arg) {
+    SearchScan *scan = arg;
+    SearchList *list = &scan->lists[worker];
+    (void)dfd;
+
+    if (type == DT_DIR) {
+        return 1;
+    }
+    if (type != DT_REG) {
+        return 0;
+    }
+    if (scan->extension != NULL) {
+        size_t name_len = strlen(name);
+        if (name_len <= scan->ext_len || strcmp(name + name_len - scan->ext_len, scan->extension) != 0) {
+            return 0;
+        }
+    }
+
+    if (list->used + path_len + 1 > list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : SEARCH_CHUNK;
+        while (list->used + path_len + 1 > cap) {
+            cap *= 2;
+        }
+        char *names = realloc(list->names, cap);
+        if (names == NULL) {
+            list->errors++;
+            return 0;
+        }
+        list->names = names;
+        list->cap = cap;
+    }
+    memcpy(list->names + list->used, path, path_len + 1);
+    list->used += path_len + 1;
+    list->count++;
+    return 0;
+}
+
+// Function to hand a worker's lines to the output buffer
+static void worker_flush(SearchWorker *self) {
+    if (self->used == 0) {
+        return;
+    }
+    pthread_mutex_lock(&self->job->lock);
+    output_write_to(self->job->output, self->data, self->used);
+    pthread_mutex_unlock(&self->job->lock);
+    self->used = 0;
+}
+
+// Function to add "root/path:number:line\n" to the worker's buffer
+static void worker_print(SearchWorker *self, const char *path, unsigned long number,
+                         const char *line, size_t line_len) {
+    const SearchJob *job = self->job;
+    size_t path_len = strlen(path);
+    size_t need = job->root_len + path_len + line_len + 32;
+
+    if (self->used + need > self->cap && self->used > 0) {
+        worker_flush(self);
+    }
+    if (need > self->cap) {
+        size_t cap = need > 2 * SEARCH_CHUNK ? need : 2 * SEARCH_CHUNK;
+        char *data = realloc(self->data, cap);
+        if (data == NULL) {
+            return;
+        }
+        self->data = data;
+        self->cap = cap;
+    }
+
+    char *out = self->data + self->used;
+    size_t len = 0;
+    memcpy(out, job->root, job->root_len);
+    len += job->root_len;
+    out[len++] = '/';
+    memcpy(out + len, path, path_len);
+    len += path_len;
+    out[len++] = ':';
+
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = '0' + number % 10;
+        number /= 10;
+    } while (number > 0);
+    while (n > 0) {
+        out[len++] = digits[--n];
+    }
+    out[len++] = ':';
+    memcpy(out + len, line, line_len);
+    len += line_len;
+    out[len++] = '\n';
+    self->used += len;
+    self->stats.lines++;
+}
+
+// Function to count the newlines in [from, to)
+static unsigned long count_newlines(const char *from, const char *to) {
+    unsigned long count = 0;
+    while ((from = memchr(from, '\n', to - from)) != NULL) {
+        count++;
+        from++;
+    }
+    return count;
+}
+
+// Function to print the matching lines of one file; line numbers are
+// only counted up to a match, so files without one are never counted
+static void search_text(SearchWorker *self, const char *path, const char *data, size_t size) {
+    const Pattern *pattern = &self->job->pattern;
+    const char *end = data + size;
+    const char *pos = data;         // always at the start of a line
+    const char *counted = data;     // newlines before here are in number
+    unsigned long number = 1;
+    int matched = 0;
+
+    const char *match;
+    while (pos < end && (match = pattern_find(pattern, pos, end)) != NULL) {
+        const char *line = memrchr(pos, '\n', match - pos);
+        line = line != NULL ? line + 1 : pos;
+        const char *line_end = memchr(match, '\n', end - match);
+        if (line_end == NULL) {
+            line_end = end;
+        }
+
+        number += count_newlines(counted, line);
+        counted = line;
+        worker_print(self, path, number, line, line_end - line);
+        matched = 1;
+        pos = line_end + 1;
+    }
+    self->stats.matched += matched;
+}
+
+// Function to search one file: small ones are read into buffer, bigger
+// ones mapped for a sequential pass
+static void search_file(SearchWorker *self, const char *path, char *buffer) {
+    int fd = walk_open_file(self->job->root_fd, path);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        self->stats.errors++;
+        if (fd != -1) {
+            close(fd);
+        }
+        return;
+    }
+
+    size_t size = st.st_size;
+    const char *data = buffer;
+    if (size <= SEARCH_SMALL) {
+        ssize_t n = pread(fd, buffer, SEARCH_SMALL, 0);
+        size = n > 0 ? n : 0;
+    } else {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            self->stats.errors++;
+            close(fd);
+            return;
+        }
+        madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    self->stats.files++;
+    self->stats.bytes += size;
+    if (memchr(data, '\0', size < SEARCH_BINARY_PROBE ? size : SEARCH_BINARY_PROBE) != NULL) {
+        self->stats.binary++;
+    } else {
+        search_text(self, path, data, size);
+    }
+    if (data != buffer) {
+        munmap((void *)data, size);
+    }
+}
+
+static void *search_worker(void *arg) {
+    SearchWorker *self = arg;
+    SearchJob *job = self->job;
+    char buffer[SEARCH_SMALL];
+
+    for (;;) {
+        size_t index = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (index >= job->count) {
+            break;
+        }
+        search_file(self, job->paths[index], buffer);
+        // A file's lines stay together; stream once a chunk is full
+        if (self->used >= SEARCH_CHUNK) {
+            worker_flush(self);
+        }
+    }
+    worker_flush(self);
+    return NULL;
+}
+
+// Function to search every file under root for pattern
+int search_tree(const char *root, const char *pattern, const SearchOptions *options,
+                SearchStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    SearchJob job;
+    job.root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (job.root_fd == -1) {
+        return -1;
+    }
+
+    // Walk first: the files are then shared out one at a time, so a
+    // directory with thousands of files is searched by every thread
+    SearchScan *scan = calloc(1, sizeof(SearchScan));
+    if (scan == NULL) {
+        close(job.root_fd);
+        return -1;
+    }
+    scan->extension = options->extension;
+    scan->ext_len = options->extension != NULL ? strlen(options->extension) : 0;
+    WalkOptions walk_options = { options->threads, search_visit, scan, NULL };
+    WalkStats walk;
+    if (walk_tree(root, &walk_options, &walk) == -1) {
+        free(scan);
+        close(job.root_fd);
+        return -1;
+    }
+    stats->errors = walk.errors;
+
+    size_t count = 0;
+    for (int w = 0; w < walk.threads; w++) {
+        count += scan->lists[w].count;
+        stats->errors += scan->lists[w].errors;
+    }
+    job.paths = malloc((count ? count : 1) * sizeof(char *));
+    SearchWorker *workers = calloc(WALK_MAX_THREADS, sizeof(SearchWorker));
+    if (job.paths == NULL || workers == NULL) {
+        for (int w = 0; w < walk.threads; w++) {
+            free(scan->lists[w].names);
+        }
+        free(job.paths);
+        free(workers);
+        free(scan);
+        close(job.root_fd);
+        return -1;
+    }
+    job.count = 0;
+    for (int w = 0; w < walk.threads; w++) {
+        const SearchList *list = &scan->lists[w];
+        for (size_t at = 0; at < list->used; at += strlen(list->names + at) + 1) {
+            job.paths[job.count++] = list->names + at;
+        }
+    }
+
+    job.root = root;
+    job.root_len = strlen(root);
+    while (job.root_len > 0 && root[job.root_len - 1] == '/') {
+        job.root_len--;  // "dir/" and "/" print as "dir/x" and "/x"
+    }
+    job.pattern.text = pattern;
+    job.pattern.len = strlen(pattern);
+    job.pattern.rare = 0;
+    for (size_t i = 1; i < job.pattern.len; i++) {
+        if (byte_frequency(pattern[i]) < byte_frequency(pattern[job.pattern.rare])) {
+            job.pattern.rare = i;
+        }
+    }
+    job.next = 0;
+    job.output = output_current();
+    pthread_mutex_init(&job.lock, NULL);
+
+    int wanted = walk_threads(options->threads);
+    if ((size_t)wanted > count) {
+        wanted = count ? count : 1;
+    }
+    int started = 0;
+    for (int i = 0; i < wanted; i++) {
+        workers[i].job = &job;
+        if (pthread_create(&workers[i].thread, NULL, search_worker, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        workers[0].job = &job;
+        search_worker(&workers[0]);  // No threads to be had: do it here
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    stats->threads = started ? started : 1;
+    for (int i = 0; i < stats->threads; i++) {
+        const SearchStats *own = &workers[i].stats;
+        stats->files += own->files;
+        stats->bytes += own->bytes;
+        stats->lines += own->lines;
+        stats->matched += own->matched;
+        stats->binary += own->binary;
+        stats->errors += own->errors;
+        free(workers[i].data);
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    for (int w = 0; w < walk.threads; w++) {
+        free(scan->lists[w].names);
+    }
+    free(job.paths);
+    free(workers);
+    free(scan);
+    close(job.root_fd);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+typedef struct {
+    const char *extension;      // only files whose name ends in it (NULL = all)
+    int threads;                // 0 = one per CPU
+} SearchOptions;
+
+typedef struct {
+    unsigned long files;        // files searched
+    unsigned long bytes;        // bytes searched
+    unsigned long lines;        // lines printed
+    unsigned long matched;      // files with at least one match
+    unsigned long binary;       // files skipped for holding a NUL byte
+    unsigned long errors;       // files or directories that could not be read
+    int threads;
+} SearchStats;
+
+// Function to print every line holding pattern in the files under root as
+// "root/path:line:text", streamed through the output buffer as each file
+// is done. Returns -1 if root cannot be opened.
+int search_tree(const char *root, const char *pattern, const SearchOptions *options,
+                SearchStats *stats);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,373 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "serve.h"
+#include "fiforeader.h"
+#include "output.h"
+#include "walker.h"
+
+#define SERVE_BATCH (256 * 1024)    // bytes read from the FIFO at once
+#define SERVE_QUEUE 256             // requests waiting for a worker
+#define SERVE_REPLY_BUFFER (64 * 1024)
+
+// Request layout on the FIFO: header, then argc + 1 NUL-terminated
+// strings, the first being the client's reply FIFO
+typedef struct {
+    uint16_t len;               // bytes after the header
+    uint16_t argc;
+} RequestHeader;
+
+// The last bytes of every reply: magic and the command's exit status
+typedef struct {
+    char magic[4];
+    int32_t status;
+} ReplyTrailer;
+
+#define REPLY_MAGIC "FMST"
+
+typedef struct {
+    char *data;                 // reply FIFO, then the arguments
+    int argc;
+} Request;
+
+typedef struct {
+    ServeHandler handler;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;       // a request was queued, or we are closing
+    pthread_cond_t room;        // a request was taken off the queue
+    Request queue[SERVE_QUEUE];
+    size_t head;
+    size_t count;
+    int closing;
+    int shared;                 // the command FIFO is writable by other users
+    ServeStats *stats;
+} Server;
+
+// Function to write all of data, retrying short writes
+static int write_full(int fd, const void *data, size_t len) {
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Function to run one request and answer it on its reply FIFO
+static void serve_one(Server *server, Request *request) {
+    char *argv[SERVE_MAX_ARGS + 2];
+    char *p = request->data;
+    const char *reply = p;
+    argv[0] = "fileManager";
+    for (int i = 0; i < request->argc; i++) {
+        p += strlen(p) + 1;
+        argv[i + 1] = p;
+    }
+    argv[request->argc + 1] = NULL;
+
+    // ENXIO: the client stopped waiting before its turn came. Anything
+    // but a FIFO of ours (of anyone's on a shared server) is refused, so
+    // a request cannot make us overwrite a file with the output.
+    int fd = open(reply, O_WRONLY | O_NONBLOCK | O_CLOEXEC | O_NOFOLLOW);
+    struct stat st;
+    if (fd != -1 && (fstat(fd, &st) == -1 || !S_ISFIFO(st.st_mode) ||
+                     (!server->shared && st.st_uid != geteuid()))) {
+        close(fd);
+        fd = -1;
+    }
+    if (fd == -1) {
+        pthread_mutex_lock(&server->lock);
+        server->stats->dropped++;
+        pthread_mutex_unlock(&server->lock);
+        return;
+    }
+    fcntl(fd, F_SETFL, 0);  // Block while the client catches up
+
+    int status = server->handler(fd, request->argc + 1, argv);
+    ReplyTrailer trailer;
+    memcpy(trailer.magic, REPLY_MAGIC, 4);
+    trailer.status = status;
+    write_full(fd, &trailer, sizeof(trailer));
+    close(fd);
+
+    pthread_mutex_lock(&server->lock);
+    server->stats->requests++;
+    server->stats->failed += status != 0;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void *serve_worker(void *arg) {
+    Server *server = arg;
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        while (server->count == 0 && !server->closing) {
+            pthread_cond_wait(&server->ready, &server->lock);
+        }
+        if (server->count == 0) {
+            pthread_mutex_unlock(&server->lock);
+            break;  // Closing and nothing left to answer
+        }
+        Request request = server->queue[server->head];
+        server->head = (server->head + 1) % SERVE_QUEUE;
+        server->count--;
+        pthread_cond_signal(&server->room);
+        pthread_mutex_unlock(&server->lock);
+
+        serve_one(server, &request);
+        free(request.data);
+    }
+    return NULL;
+}
+
+// Function to check a request body: argc + 1 strings filling it exactly
+static int request_valid(const char *data, size_t len, int argc) {
+    if (argc < 1 || argc > SERVE_MAX_ARGS || len == 0 || data[len - 1] != '\0') {
+        return 0;
+    }
+    int strings = 0;
+    for (size_t i = 0; i < len; i++) {
+        strings += data[i] == '\0';
+    }
+    return strings == argc + 1 && data[0] != '\0';
+}
+
+// FIFO reader callback: queue the complete requests in data for the
+// workers; returns the bytes consumed (a trailing partial request waits)
+static size_t queue_requests(const char *data, size_t len, void *arg) {
+    Server *server = arg;
+    size_t pos = 0;
+    while (len - pos >= sizeof(RequestHeader)) {
+        RequestHeader header;
+        memcpy(&header, data + pos, sizeof(header));
+        if (sizeof(header) + header.len > SERVE_REQUEST_MAX) {
+            return len;  // Not a request: drop what we have and resync
+        }
+        if (len - pos < sizeof(header) + header.len) {
+            break;
+        }
+        const char *body = data + pos + sizeof(header);
+        pos += sizeof(header) + header.len;
+        if (!request_valid(body, header.len, header.argc)) {
+            continue;
+        }
+
+        Request request;
+        request.argc = header.argc;
+        request.data = malloc(header.len);
+        if (request.data == NULL) {
+            continue;
+        }
+        memcpy(request.data, body, header.len);
+
+        // A full queue holds the reader back, and with it the clients
+        pthread_mutex_lock(&server->lock);
+        while (server->count == SERVE_QUEUE) {
+            pthread_cond_wait(&server->room, &server->lock);
+        }
+        server->queue[(server->head + server->count) % SERVE_QUEUE] = request;
+        server->count++;
+        pthread_cond_signal(&server->ready);
+        pthread_mutex_unlock(&server->lock);
+    }
+    return pos;
+}
+
+// Function to serve fifo until SIGINT or SIGTERM
+int serve_run(const char *fifo, int threads, ServeHandler handler, ServeStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    // Private unless the FIFO already exists with wider permissions
+    FifoReader reader;
+    if (fifo_reader_open(&reader, fifo, 0600, SERVE_BATCH) == -1) {
+        return -1;
+    }
+    Server *server = calloc(1, sizeof(Server));
+    pthread_t *workers = calloc(WALK_MAX_THREADS, sizeof(pthread_t));
+    if (server == NULL || workers == NULL) {
+        free(server);
+        free(workers);
+        fifo_reader_close(&reader);
+        return -1;
+    }
+    struct stat st;
+    server->handler = handler;
+    server->shared = fstat(reader.fd, &st) == 0 && (st.st_mode & (S_IWGRP | S_IWOTH)) != 0;
+    server->stats = stats;
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->ready, NULL);
+    pthread_cond_init(&server->room, NULL);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_IGN;  // A client that quits must not kill us
+    sigaction(SIGPIPE, &sa, NULL);
+
+    // Workers leave SIGINT/SIGTERM to this thread, which reads the FIFO
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    int wanted = walk_threads(threads);
+    for (int i = 0; i < wanted; i++) {
+        if (pthread_create(&workers[stats->threads], NULL, serve_worker, server) == 0) {
+            stats->threads++;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    int result = stats->threads > 0 ? 0 : -1;
+
+    // Once we stop, new clients fail to connect; the requests already
+    // written still get read and answered
+    if (result == 0) {
+        fifo_reader_run(&reader, queue_requests, server);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->closing = 1;
+    pthread_cond_broadcast(&server->ready);
+    pthread_mutex_unlock(&server->lock);
+    for (int i = 0; i < stats->threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    fifo_reader_close(&reader);
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->ready);
+    pthread_cond_destroy(&server->room);
+    free(server);
+    free(workers);
+    return result;
+}
+
+// Function to send a request to the server on fifo and print its reply
+int serve_request(const char *fifo, int argc, char *argv[], int *status) {
+    char dir[] = "/tmp/fileManager.XXXXXX";
+    char reply[sizeof(dir) + 8];
+    if (argc < 1 || argc > SERVE_MAX_ARGS) {
+        errno = E2BIG;
+        return -1;
+    }
+    if (mkdtemp(dir) == NULL) {
+        return -1;
+    }
+    strcpy(reply, dir);
+    strcat(reply, "/reply");
+
+    // The request: header, reply FIFO, arguments
+    char record[SERVE_REQUEST_MAX];
+    size_t len = sizeof(RequestHeader);
+    const char *field = reply;
+    for (int i = -1; i < argc; i++) {
+        field = i < 0 ? reply : argv[i];
+        size_t field_len = strlen(field) + 1;
+        if (len + field_len > sizeof(record) || len + field_len > PIPE_BUF) {
+            rmdir(dir);
+            errno = EMSGSIZE;
+            return -1;
+        }
+        memcpy(record + len, field, field_len);
+        len += field_len;
+    }
+    RequestHeader header = { (uint16_t)(len - sizeof(header)), (uint16_t)argc };
+    memcpy(record, &header, sizeof(header));
+
+    // Our read end is open before the request goes out, so the server's
+    // non-blocking open of it only fails once we are gone
+    int rfd = -1;
+    int fd = -1;
+    int result = -1;
+    if (mkfifo(reply, 0600) == -1 || (rfd = open(reply, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) == -1) {
+        goto done;
+    }
+    fd = open(fifo, O_WRONLY | O_NONBLOCK | O_CLOEXEC);  // ENXIO: no server
+    if (fd == -1) {
+        goto done;
+    }
+    struct sigaction ignore, old;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &ignore, &old);
+    ssize_t sent = write(fd, record, len);  // <= PIPE_BUF: never interleaved
+    sigaction(SIGPIPE, &old, NULL);
+    close(fd);
+    if (sent != (ssize_t)len) {
+        goto done;
+    }
+
+    // Wait for a worker to open the reply; check now and then that the
+    // server is still there
+    struct pollfd pfd = { rfd, POLLIN, 0 };
+    for (;;) {
+        int ready = poll(&pfd, 1, 1000);
+        if (ready > 0) {
+            break;
+        }
+        if (ready == -1 && errno != EINTR) {
+            goto done;
+        }
+        int probe = open(fifo, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (probe == -1) {
+            goto done;
+        }
+        close(probe);
+    }
+    fcntl(rfd, F_SETFL, 0);
+
+    // Copy everything but the trailer, which is the last bytes to arrive
+    char *buffer = malloc(SERVE_REPLY_BUFFER + sizeof(ReplyTrailer));
+    if (buffer == NULL) {
+        goto done;
+    }
+    size_t held = 0;
+    ssize_t n;
+    while ((n = read(rfd, buffer + held, SERVE_REPLY_BUFFER)) != 0) {
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        held += n;
+        if (held > sizeof(ReplyTrailer)) {
+            output_write(buffer, held - sizeof(ReplyTrailer));
+            memmove(buffer, buffer + held - sizeof(ReplyTrailer), sizeof(ReplyTrailer));
+            held = sizeof(ReplyTrailer);
+        }
+    }
+    ReplyTrailer trailer;
+    if (n == 0 && held == sizeof(trailer)) {
+        memcpy(&trailer, buffer, sizeof(trailer));
+        result = memcmp(trailer.magic, REPLY_MAGIC, 4) == 0 ? 0 : -1;
+        *status = trailer.status;
+    }
+    if (result == -1) {
+        errno = EPIPE;  // The server went away mid-reply
+    }
+    free(buffer);
+
+done:
+    if (rfd != -1) {
+        close(rfd);
+    }
+    unlink(reply);
+    rmdir(dir);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef SERVE_H
+#define SERVE_H
+
+// A request is one atomic FIFO write: its reply FIFO and the arguments
+#define SERVE_REQUEST_MAX 4096
+#define SERVE_MAX_ARGS 16
+
+// Runs one request's command with its output going to reply_fd; returns
+// the command's exit status
+typedef int (*ServeHandler)(int reply_fd, int argc, char *argv[]);
+
+typedef struct {
+    unsigned long requests;     // commands run
+    unsigned long failed;       // of those, the ones with a nonzero status
+    unsigned long dropped;      // requests whose client was already gone
+    int threads;
+} ServeStats;
+
+// Function to serve fifo with a pool of threads (0 = one per CPU) until
+// SIGINT or SIGTERM; every request is run by handler
+int serve_run(const char *fifo, int threads, ServeHandler handler, ServeStats *stats);
+
+// Function to send argv[0..argc) to the server on fifo and copy its reply
+// to stdout; *status gets the command's exit status. Returns -1 (errno
+// set) if there is no server or it went away.
+int serve_request(const char *fifo, int argc, char *argv[], int *status);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,366 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+#include "transfer.h"
+
+#define TRANSFER_CHUNK (1L << 30)           // per zero-copy call
+#define TRANSFER_MAP_WINDOW (64L << 20)     // per mmap window
+#define TRANSFER_COPY_BUFFER (64 * 1024)
+#define TRANSFER_MAX_THREADS 16             // chunks of one file copy
+
+static TransferMode transfer_mode = TRANSFER_AUTO;
+
+// Function to choose the transfer mode
+int transfer_set_mode(const char *mode) {
+    if (strcmp(mode, "auto") == 0) {
+        transfer_mode = TRANSFER_AUTO;
+    } else if (strcmp(mode, "mmap") == 0) {
+        transfer_mode = TRANSFER_MMAP;
+    } else if (strcmp(mode, "copy") == 0) {
+        transfer_mode = TRANSFER_COPY;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Function to write a whole range, retrying short writes
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Errors that mean "this method does not apply here", not "I/O failed"
+static int unsupported(int err) {
+    return err == EINVAL || err == ENOSYS || err == EXDEV || err == EBADF ||
+           err == EOPNOTSUPP || err == ESPIPE;
+}
+
+// Kernel-side copies; `method` picks copy_file_range, sendfile or splice.
+// Returns bytes moved, -1 with errno set if the method failed up front.
+static ssize_t transfer_kernel(int method, int in_fd, off_t offset, size_t count, int out_fd) {
+    size_t moved = 0;
+
+    while (moved < count) {
+        size_t chunk = count - moved < TRANSFER_CHUNK ? count - moved : TRANSFER_CHUNK;
+        off_t pos = offset + moved;
+        ssize_t n;
+
+        if (method == 0) {
+            n = copy_file_range(in_fd, &pos, out_fd, NULL, chunk, 0);
+        } else if (method == 1) {
+            n = sendfile(out_fd, in_fd, &pos, chunk);
+        } else {
+            n = splice(in_fd, &pos, out_fd, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+        }
+
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (moved == 0 && n == -1) {
+                return -1;
+            }
+            break;  // End of file (it shrank) or a late error
+        }
+        moved += n;
+    }
+    return moved;
+}
+
+// mmap the range a window at a time and write it out
+static ssize_t transfer_mmap(int in_fd, off_t offset, size_t count, int out_fd) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t moved = 0;
+
+    while (moved < count) {
+        off_t pos = offset + moved;
+        off_t base = pos & ~((off_t)page - 1);
+        size_t skip = pos - base;
+        size_t len = count - moved < TRANSFER_MAP_WINDOW ? count - moved : TRANSFER_MAP_WINDOW;
+
+        char *map = mmap(NULL, len + skip, PROT_READ, MAP_PRIVATE, in_fd, base);
+        if (map == MAP_FAILED) {
+            return moved > 0 ? (ssize_t)moved : -1;
+        }
+        madvise(map, len + skip, MADV_SEQUENTIAL);
+
+        int failed = write_all(out_fd, map + skip, len) == -1;
+        munmap(map, len + skip);
+        if (failed) {
+            return moved > 0 ? (ssize_t)moved : -1;
+        }
+        moved += len;
+    }
+    return moved;
+}
+
+// pread/write through a buffer
+static ssize_t transfer_copy(int in_fd, off_t offset, size_t count, int out_fd) {
+    char *buffer = malloc(TRANSFER_COPY_BUFFER);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    size_t moved = 0;
+    while (moved < count) {
+        size_t chunk = count - moved < TRANSFER_COPY_BUFFER ? count - moved : TRANSFER_COPY_BUFFER;
+        ssize_t n = pread(in_fd, buffer, chunk, offset + moved);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || write_all(out_fd, buffer, n) == -1) {
+            break;
+        }
+        moved += n;
+    }
+
+    free(buffer);
+    return moved > 0 || count == 0 ? (ssize_t)moved : -1;
+}
+
+// Function to move count bytes of in_fd starting at offset to out_fd
+ssize_t transfer_range(int in_fd, off_t offset, size_t count, int out_fd) {
+    if (transfer_mode == TRANSFER_AUTO) {
+        struct stat out_st;
+        int out_regular = fstat(out_fd, &out_st) == 0 && S_ISREG(out_st.st_mode);
+        int out_pipe = !out_regular && S_ISFIFO(out_st.st_mode);
+
+        // copy_file_range only works file to file, splice needs a pipe end
+        for (int method = out_regular ? 0 : 1; method <= 2; method++) {
+            if (method == 2 && !out_pipe) {
+                break;
+            }
+            ssize_t n = transfer_kernel(method, in_fd, offset, count, out_fd);
+            if (n >= 0) {
+                return n;
+            }
+            if (!unsupported(errno)) {
+                return -1;
+            }
+        }
+    }
+
+    if (transfer_mode != TRANSFER_COPY) {
+        ssize_t n = transfer_mmap(in_fd, offset, count, out_fd);
+        if (n >= 0) {
+            return n;
+        }
+    }
+    return transfer_copy(in_fd, offset, count, out_fd);
+}
+
+// Function to move in_fd to out_fd by reading it
+ssize_t transfer_stream(int in_fd, off_t skip, off_t limit, int out_fd, char *last) {
+    char *buffer = malloc(TRANSFER_COPY_BUFFER);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    // Seekable descriptors skip for free, the rest read and discard
+    if (skip > 0 && lseek(in_fd, skip, SEEK_CUR) != -1) {
+        skip = 0;
+    }
+
+    size_t moved = 0;
+    while (limit != 0) {
+        size_t want = TRANSFER_COPY_BUFFER;
+        if (skip > 0 && skip < (off_t)want) {
+            want = skip;
+        } else if (skip == 0 && limit > 0 && limit < (off_t)want) {
+            want = limit;
+        }
+
+        ssize_t n = read(in_fd, buffer, want);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        if (skip > 0) {
+            skip -= n;
+            continue;
+        }
+        if (write_all(out_fd, buffer, n) == -1) {
+            break;
+        }
+        *last = buffer[n - 1];
+        moved += n;
+        if (limit > 0) {
+            limit -= n;
+        }
+    }
+
+    free(buffer);
+    return moved;
+}
+
+// One chunk of a file copy, run by one thread
+typedef struct {
+    int in_fd;
+    int out_fd;
+    off_t offset;
+    off_t count;
+    int kernel;         // try copy_file_range first
+    int used_kernel;    // set if it did all of the chunk
+    int error;          // errno of a failure, 0 if done
+} CopyChunk;
+
+// pwrite a whole buffer, retrying short writes
+static int pwrite_all(int fd, const char *data, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, data, len, offset);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= n;
+        offset += n;
+    }
+    return 0;
+}
+
+// Copy one chunk at explicit offsets, so chunks can run side by side
+static void *copy_chunk(void *arg) {
+    CopyChunk *chunk = arg;
+    off_t done = 0;
+
+    if (chunk->kernel) {
+        while (done < chunk->count) {
+            off_t in_pos = chunk->offset + done;
+            off_t out_pos = in_pos;
+            size_t want = chunk->count - done < TRANSFER_CHUNK ? chunk->count - done : TRANSFER_CHUNK;
+            ssize_t n = copy_file_range(chunk->in_fd, &in_pos, chunk->out_fd, &out_pos, want, 0);
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            if (n == -1 && !unsupported(errno)) {
+                chunk->error = errno;
+                return NULL;
+            }
+            if (n <= 0) {
+                break;  // Not here: the rest goes through a buffer
+            }
+            done += n;
+        }
+        chunk->used_kernel = done == chunk->count;
+    }
+
+    char *buffer = done < chunk->count ? malloc(TRANSFER_COPY_BUFFER) : NULL;
+    if (done < chunk->count && buffer == NULL) {
+        chunk->error = ENOMEM;
+        return NULL;
+    }
+    while (done < chunk->count) {
+        size_t want = chunk->count - done < TRANSFER_COPY_BUFFER ? chunk->count - done : TRANSFER_COPY_BUFFER;
+        ssize_t n = pread(chunk->in_fd, buffer, want, chunk->offset + done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            chunk->error = n == 0 ? EIO : errno;  // The source shrank under us
+            break;
+        }
+        if (pwrite_all(chunk->out_fd, buffer, n, chunk->offset + done) == -1) {
+            chunk->error = errno;
+            break;
+        }
+        done += n;
+    }
+    free(buffer);
+    return NULL;
+}
+
+// Function to copy size bytes of in_fd into out_fd at the same offsets
+int transfer_file(int in_fd, int out_fd, off_t size, int threads, TransferFileStats *stats) {
+    stats->method = "reflink";
+    stats->threads = 1;
+
+    // Shared blocks: no data is copied at all
+    if (transfer_mode == TRANSFER_AUTO && ioctl(out_fd, FICLONE, in_fd) == 0) {
+        return 0;
+    }
+
+    if (size < TRANSFER_PARALLEL_MIN || threads < 1) {
+        threads = 1;
+    }
+    if (threads > TRANSFER_MAX_THREADS) {
+        threads = TRANSFER_MAX_THREADS;
+    }
+
+    // Reserve the whole file up front so the chunks don't fragment it
+    if (size > 0) {
+        fallocate(out_fd, 0, 0, size);
+    }
+
+    CopyChunk chunks[TRANSFER_MAX_THREADS];
+    pthread_t ids[TRANSFER_MAX_THREADS];
+    long page = sysconf(_SC_PAGESIZE);
+    off_t per_thread = (size / threads + page - 1) & ~((off_t)page - 1);
+    int started = 0;
+
+    for (int i = 0; i < threads; i++) {
+        CopyChunk *chunk = &chunks[i];
+        chunk->in_fd = in_fd;
+        chunk->out_fd = out_fd;
+        chunk->offset = per_thread * i;
+        chunk->count = i == threads - 1 ? size - chunk->offset : per_thread;
+        if (chunk->count < 0) {
+            chunk->count = 0;
+        }
+        chunk->kernel = transfer_mode == TRANSFER_AUTO;
+        chunk->used_kernel = 0;
+        chunk->error = 0;
+        if (i == 0 || pthread_create(&ids[i], NULL, copy_chunk, chunk) != 0) {
+            continue;  // Chunk 0 (or one without a thread) runs here
+        }
+        started |= 1 << i;
+    }
+    copy_chunk(&chunks[0]);
+
+    int error = 0;
+    int kernel = 1;
+    for (int i = 0; i < threads; i++) {
+        if (started & (1 << i)) {
+            pthread_join(ids[i], NULL);
+        } else if (i > 0) {
+            copy_chunk(&chunks[i]);
+        }
+        if (chunks[i].error != 0 && error == 0) {
+            error = chunks[i].error;
+        }
+        kernel &= chunks[i].used_kernel || chunks[i].count == 0;
+    }
+
+    stats->method = kernel && size > 0 ? "copy_file_range" : "read/write";
+    stats->threads = threads;
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
\ No newline at end of file
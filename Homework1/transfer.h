@@ -0,0 +1,40 @@
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <sys/types.h>
+
+// How file bytes are moved to another descriptor
+typedef enum {
+    TRANSFER_AUTO,      // copy_file_range / sendfile / splice, then mmap
+    TRANSFER_MMAP,      // mmap windows written out with write()
+    TRANSFER_COPY       // plain read()/write() through a buffer
+} TransferMode;
+
+// Function to choose the transfer mode ("auto", "mmap" or "copy")
+int transfer_set_mode(const char *mode);
+
+// Function to move count bytes of in_fd starting at offset to out_fd.
+// Returns the bytes moved or -1 if nothing could be moved.
+ssize_t transfer_range(int in_fd, off_t offset, size_t count, int out_fd);
+
+// Function to move in_fd (pipes, /proc files) to out_fd by reading it:
+// skip bytes are dropped, then at most limit bytes (-1 = all) are moved.
+// The last byte moved is stored in *last.
+ssize_t transfer_stream(int in_fd, off_t skip, off_t limit, int out_fd, char *last);
+
+// Files at least this big are copied in chunks by several threads
+#define TRANSFER_PARALLEL_MIN (256L << 20)
+
+// How transfer_file copied
+typedef struct {
+    const char *method;     // "reflink", "copy_file_range" or "read/write"
+    int threads;            // threads that copied chunks
+} TransferFileStats;
+
+// Function to copy size bytes of in_fd into out_fd at the same offsets:
+// a reflink (FICLONE) if the file system shares blocks, else the kernel
+// copies, else pread/pwrite; big files are split across up to threads.
+// Returns 0, or -1 with errno set.
+int transfer_file(int in_fd, int out_fd, off_t size, int threads, TransferFileStats *stats);
+
+#endif
\ No newline at end of file
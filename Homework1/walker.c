@@ -0,0 +1,292 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "walker.h"
+
+#define WALK_DENTS_BUFFER (256 * 1024)  // getdents64 buffer per worker
+#define WALK_IDLE_SPINS 64              // yields before an idle worker naps
+
+// A directory to read; it is left once it has been read and all of its
+// subdirectories have been left
+typedef struct WalkNode {
+    struct WalkNode *parent;
+    atomic_int refs;        // 1 until read, +1 per subdirectory not yet left
+    char path[];
+} WalkNode;
+
+// Directory queue of one worker: the owner pushes and pops at the tail
+// (depth first, warm caches), idle workers steal from the head
+typedef struct {
+    pthread_mutex_t lock;
+    WalkNode **items;
+    size_t head;
+    size_t tail;
+    size_t cap;
+} WalkQueue;
+
+typedef struct {
+    int root_fd;
+    int threads;
+    const WalkOptions *options;
+    WalkQueue queues[WALK_MAX_THREADS];
+    atomic_long pending;            // directories queued or being read
+    atomic_ulong dirs;
+    atomic_ulong entries;
+    atomic_ulong errors;
+} Walk;
+
+typedef struct {
+    Walk *walk;
+    int id;
+} WalkWorker;
+
+// Function to open a file found by a walk for reading without touching
+// its access time (O_NOATIME is only allowed on our own files)
+int walk_open_file(int root_fd, const char *path) {
+    int fd = openat(root_fd, path, O_RDONLY | O_NOATIME | O_CLOEXEC);
+    if (fd == -1 && errno == EPERM) {
+        fd = openat(root_fd, path, O_RDONLY | O_CLOEXEC);
+    }
+    return fd;
+}
+
+// Function to resolve a requested worker count
+int walk_threads(int requested) {
+    long threads = requested > 0 ? requested : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) {
+        threads = 1;
+    }
+    return threads > WALK_MAX_THREADS ? WALK_MAX_THREADS : (int)threads;
+}
+
+static int queue_push(WalkQueue *queue, WalkNode *dir) {
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail == queue->cap) {
+        if (queue->head > 0) {
+            // Slide the live part down before growing
+            memmove(queue->items, queue->items + queue->head,
+                    (queue->tail - queue->head) * sizeof(WalkNode *));
+            queue->tail -= queue->head;
+            queue->head = 0;
+        }
+        if (queue->tail == queue->cap) {
+            size_t cap = queue->cap ? queue->cap * 2 : 256;
+            WalkNode **items = realloc(queue->items, cap * sizeof(WalkNode *));
+            if (items == NULL) {
+                pthread_mutex_unlock(&queue->lock);
+                return -1;
+            }
+            queue->items = items;
+            queue->cap = cap;
+        }
+    }
+    queue->items[queue->tail++] = dir;
+    pthread_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+static WalkNode *queue_pop(WalkQueue *queue, int steal) {
+    WalkNode *dir = NULL;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail > queue->head) {
+        dir = steal ? queue->items[queue->head++] : queue->items[--queue->tail];
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return dir;
+}
+
+static WalkNode *node_new(WalkNode *parent, const char *path, size_t len) {
+    WalkNode *node = malloc(sizeof(WalkNode) + len + 1);
+    if (node != NULL) {
+        node->parent = parent;
+        atomic_init(&node->refs, 1);
+        memcpy(node->path, path, len + 1);
+    }
+    return node;
+}
+
+// Drop one reference; directories nobody waits on any more are left,
+// which may in turn finish their parents
+static void node_release(Walk *walk, int id, WalkNode *node) {
+    while (node != NULL && atomic_fetch_sub(&node->refs, 1) == 1) {
+        WalkNode *parent = node->parent;
+        if (walk->options->leave != NULL) {
+            walk->options->leave(id, walk->root_fd, node->path, walk->options->arg);
+        }
+        free(node);
+        node = parent;
+    }
+}
+
+// Read one directory, hand its entries to visit and queue subdirectories
+static void walk_dir(Walk *walk, int id, WalkNode *node, char *buffer) {
+    const WalkOptions *options = walk->options;
+    const char *dir = node->path;
+    int dfd = openat(walk->root_fd, dir[0] ? dir : ".",
+                     O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (dfd == -1) {
+        atomic_fetch_add(&walk->errors, 1);
+        return;
+    }
+
+    char path[WALK_PATH_MAX];
+    size_t base = strlen(dir);
+    memcpy(path, dir, base);
+    if (base > 0) {
+        path[base++] = '/';
+    }
+
+    unsigned long entries = 0;
+    ssize_t n;
+    while ((n = getdents64(dfd, buffer, WALK_DENTS_BUFFER)) > 0) {
+        for (ssize_t pos = 0; pos < n;) {
+            struct dirent64 *entry = (struct dirent64 *)(buffer + pos);
+            pos += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+
+            size_t name_len = strlen(name);
+            if (base + name_len >= WALK_PATH_MAX) {
+                atomic_fetch_add(&walk->errors, 1);
+                continue;
+            }
+            memcpy(path + base, name, name_len + 1);
+
+            // Only file systems without d_type cost a stat
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat st;
+                type = fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 ? IFTODT(st.st_mode) : DT_REG;
+            }
+
+            entries++;
+            if (options->visit(id, dfd, path, base + name_len, name, type, options->arg) &&
+                type == DT_DIR) {
+                WalkNode *child = node_new(node, path, base + name_len);
+                atomic_fetch_add(&walk->pending, 1);
+                atomic_fetch_add(&node->refs, 1);
+                if (child == NULL || queue_push(&walk->queues[id], child) == -1) {
+                    free(child);
+                    atomic_fetch_sub(&node->refs, 1);
+                    atomic_fetch_sub(&walk->pending, 1);
+                    atomic_fetch_add(&walk->errors, 1);
+                }
+            }
+        }
+    }
+    if (n == -1) {
+        atomic_fetch_add(&walk->errors, 1);
+    }
+
+    close(dfd);
+    atomic_fetch_add(&walk->dirs, 1);
+    atomic_fetch_add(&walk->entries, entries);
+}
+
+// Worker loop: own queue first, then steal, until nothing is pending
+static void *walk_worker(void *arg) {
+    WalkWorker *worker = arg;
+    Walk *walk = worker->walk;
+    int id = worker->id;
+    int idle = 0;
+
+    char *buffer = malloc(WALK_DENTS_BUFFER);
+    if (buffer == NULL) {
+        return NULL;  // The others pick up the work
+    }
+
+    while (atomic_load(&walk->pending) > 0) {
+        WalkNode *dir = queue_pop(&walk->queues[id], 0);
+        for (int i = 1; dir == NULL && i < walk->threads; i++) {
+            dir = queue_pop(&walk->queues[(id + i) % walk->threads], 1);
+        }
+
+        if (dir == NULL) {
+            // Someone is still reading a directory that may queue more
+            if (++idle < WALK_IDLE_SPINS) {
+                sched_yield();
+            } else {
+                struct timespec nap = { 0, 50000 };
+                nanosleep(&nap, NULL);
+            }
+            continue;
+        }
+
+        idle = 0;
+        walk_dir(walk, id, dir, buffer);
+        node_release(walk, id, dir);
+        atomic_fetch_sub(&walk->pending, 1);
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+// Function to walk the tree under root with a pool of workers
+int walk_tree(const char *root, const WalkOptions *options, WalkStats *stats) {
+    Walk *walk = calloc(1, sizeof(Walk));
+    if (walk == NULL) {
+        return -1;
+    }
+
+    walk->root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (walk->root_fd == -1) {
+        free(walk);
+        return -1;
+    }
+    walk->options = options;
+    walk->threads = walk_threads(options->threads);
+    for (int i = 0; i < walk->threads; i++) {
+        pthread_mutex_init(&walk->queues[i].lock, NULL);
+    }
+
+    atomic_store(&walk->pending, 1);
+    queue_push(&walk->queues[0], node_new(NULL, "", 0));
+
+    // The calling thread is worker 0
+    pthread_t threads[WALK_MAX_THREADS];
+    WalkWorker workers[WALK_MAX_THREADS];
+    int started = 1;
+    for (int i = 0; i < walk->threads; i++) {
+        workers[i].walk = walk;
+        workers[i].id = i;
+    }
+    for (int i = 1; i < walk->threads; i++) {
+        if (pthread_create(&threads[i], NULL, walk_worker, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    walk_worker(&workers[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (stats != NULL) {
+        stats->dirs = atomic_load(&walk->dirs);
+        stats->entries = atomic_load(&walk->entries);
+        stats->errors = atomic_load(&walk->errors);
+        stats->threads = started;
+    }
+
+    for (int i = 0; i < walk->threads; i++) {
+        free(walk->queues[i].items);
+        pthread_mutex_destroy(&walk->queues[i].lock);
+    }
+    close(walk->root_fd);
+    free(walk);
+    return 0;
+}
\ No newline at end of file
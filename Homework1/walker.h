@@ -0,0 +1,46 @@
+#ifndef WALKER_H
+#define WALKER_H
+
+#include <stddef.h>
+
+#define WALK_MAX_THREADS 64
+#define WALK_PATH_MAX 4096
+
+// Called from a worker thread for every entry of every directory.
+// `path` is relative to the walk root ("sub/name"), `dfd` is the open
+// directory holding `name`, `type` is a DT_* value (never DT_UNKNOWN).
+// Return nonzero to descend into a directory entry.
+typedef int (*WalkVisit)(int worker, int dfd, const char *path, size_t path_len,
+                         const char *name, unsigned char type, void *arg);
+
+// Optional, called once a directory and everything below it has been
+// walked (children before parents, the root last with path "").
+// `root_fd` is the walk root, `path` relative to it.
+typedef void (*WalkLeave)(int worker, int root_fd, const char *path, void *arg);
+
+typedef struct {
+    int threads;            // 0 = one per online CPU
+    WalkVisit visit;
+    void *arg;
+    WalkLeave leave;
+} WalkOptions;
+
+typedef struct {
+    unsigned long dirs;     // directories read, the root included
+    unsigned long entries;  // entries passed to visit
+    unsigned long errors;   // directories that could not be read
+    int threads;            // workers actually used
+} WalkStats;
+
+// Function to resolve a requested worker count (0 = online CPUs)
+int walk_threads(int requested);
+
+// Function to open path (relative to root_fd) for reading, leaving its
+// access time alone when we are allowed to
+int walk_open_file(int root_fd, const char *path);
+
+// Function to walk the tree under root with a pool of workers; symlinks
+// are reported but never followed. Returns -1 if root cannot be opened.
+int walk_tree(const char *root, const WalkOptions *options, WalkStats *stats);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+/**
+ * accounts.h - Structure-of-arrays account table and bulk scan kernels
+ *
+ * Balances live in one dense 64-bit array, the active flags in a bitmap and
+ * the BankID text in a separate cold store that is only touched when the log
+ * is written. Full-table scans therefore only pull the bytes they use.
+ */
+
+#ifndef ACCOUNTS_H
+#define ACCOUNTS_H
+
+#include "common.h"
+
+// Slots rounded up to whole bitmap words so kernels never need a tail loop
+#define ACCOUNT_WORDS ((MAX_ACCOUNTS + 63) / 64)
+#define ACCOUNT_SLOTS (ACCOUNT_WORDS * 64)
+#define ACCOUNT_ID_LEN 20
+
+// Balance histogram buckets: [0], [1,2), [2,4), ... last bucket open-ended
+#define HISTOGRAM_BUCKETS 24
+
+// Invariant: an inactive slot always has balance 0
+typedef struct {
+    int64_t balance[ACCOUNT_SLOTS] __attribute__((aligned(64)));
+    uint64_t active[ACCOUNT_WORDS];
+    char id[ACCOUNT_SLOTS][ACCOUNT_ID_LEN];
+} AccountTable;
+
+typedef struct {
+    int active_count;
+    int64_t total_balance;
+    uint64_t histogram[HISTOGRAM_BUCKETS];
+} AccountReport;
+
+static inline int account_is_active(const AccountTable *table, uint32_t idx) {
+    return (table->active[idx >> 6] >> (idx & 63)) & 1;
+}
+
+static inline void account_set_active(AccountTable *table, uint32_t idx) {
+    table->active[idx >> 6] |= 1ULL << (idx & 63);
+}
+
+static inline void account_clear_active(AccountTable *table, uint32_t idx) {
+    table->active[idx >> 6] &= ~(1ULL << (idx & 63));
+    table->balance[idx] = 0;
+}
+
+// One account under a batch job; the vector kernel must agree with this
+static inline int64_t account_job_value(int kind, int64_t param, int64_t balance) {
+    switch (kind) {
+    case BATCH_INTEREST: return balance + balance * param / 10000;
+    case BATCH_FEE: return balance > param ? balance - param : balance;
+    case BATCH_FLOOR: return balance < param ? param : balance;
+    default: return balance;
+    }
+}
+
+// Bulk kernels
+int accounts_active_count(const AccountTable *table);
+int64_t accounts_total_balance(const AccountTable *table);
+void accounts_balance_histogram(const AccountTable *table, uint64_t hist[HISTOGRAM_BUCKETS]);
+void accounts_report(const AccountTable *table, AccountReport *report);
+
+// Apply a batch job to the accounts of bitmap word `word` selected by mask,
+// returns the change in total deposits
+int64_t accounts_apply_job(AccountTable *table, int word, uint64_t mask, int kind, int64_t param);
+
+#endif /* ACCOUNTS_H */
\ No newline at end of file
@@ -0,0 +1,149 @@
+/**
+ * batch.c - End-of-day batch jobs over the whole account table
+ */
+
+#include "batch.h"
+
+static int64_t batch_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int batch_init(BatchEngine *be) {
+    memset(be, 0, sizeof(*be));
+    for (int w = 0; w < ACCOUNT_WORDS; w++) {
+        if (pthread_mutex_init(&be->locks[w], NULL) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Transform the pending accounts of one word, at most once per epoch
+static void batch_catch_up(BatchEngine *be, int word) {
+    if (__atomic_load_n(&be->pending[word], __ATOMIC_ACQUIRE) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&be->locks[word]);
+    uint64_t mask = be->pending[word];
+    if (mask) {
+        int64_t delta = accounts_apply_job(be->table, word, mask, be->kind, be->param);
+        __atomic_fetch_add(&be->delta, delta, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&be->accounts, __builtin_popcountll(mask), __ATOMIC_RELAXED);
+        __atomic_store_n(&be->pending[word], 0, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&be->locks[word]);
+}
+
+static void *batch_worker(void *arg) {
+    BatchEngine *be = arg;
+    int word;
+
+    while ((word = __atomic_fetch_add(&be->next_word, 1, __ATOMIC_RELAXED)) < ACCOUNT_WORDS) {
+        batch_catch_up(be, word);
+    }
+
+    // Keep the latest finish time across workers
+    int64_t now = batch_now_ns();
+    int64_t seen = __atomic_load_n(&be->ended_ns, __ATOMIC_RELAXED);
+    while (now > seen &&
+           !__atomic_compare_exchange_n(&be->ended_ns, &seen, now, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    __atomic_fetch_add(&be->workers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int batch_start(BatchEngine *be, AccountTable *table, int kind, int64_t param, uint32_t epoch) {
+    if (be->active) {
+        return -1;
+    }
+
+    be->table = table;
+    be->kind = kind;
+    be->param = param;
+    be->epoch = epoch;
+    be->next_word = 0;
+    be->workers_done = 0;
+    be->accounts = 0;
+    be->delta = 0;
+    be->total = 0;
+    for (int w = 0; w < ACCOUNT_WORDS; w++) {
+        be->pending[w] = table->active[w];
+        be->total += __builtin_popcountll(table->active[w]);
+    }
+    be->started_ns = batch_now_ns();
+    be->ended_ns = be->started_ns;
+    be->active = 1;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int want = cpus > 0 ? (int)cpus : 1;
+    if (want > BATCH_MAX_WORKERS) {
+        want = BATCH_MAX_WORKERS;
+    }
+    if (want > ACCOUNT_WORDS) {
+        want = ACCOUNT_WORDS;
+    }
+
+    be->nworkers = 0;
+    while (be->nworkers < want &&
+           pthread_create(&be->workers[be->nworkers], NULL, batch_worker, be) == 0) {
+        be->nworkers++;
+    }
+
+    // No threads at all: do the whole table on the caller
+    if (be->nworkers == 0) {
+        for (int w = 0; w < ACCOUNT_WORDS; w++) {
+            batch_catch_up(be, w);
+        }
+        be->ended_ns = batch_now_ns();
+    }
+    return 0;
+}
+
+void batch_touch(BatchEngine *be, uint32_t idx) {
+    if (be->active && idx < ACCOUNT_SLOTS) {
+        batch_catch_up(be, (int)(idx >> 6));
+    }
+}
+
+void batch_word_balances(BatchEngine *be, const AccountTable *table, int word, int64_t out[64]) {
+    const int64_t *balances = table->balance + word * 64;
+
+    if (!be->active || __atomic_load_n(&be->pending[word], __ATOMIC_ACQUIRE) == 0) {
+        memcpy(out, balances, 64 * sizeof(int64_t));
+        return;
+    }
+
+    pthread_mutex_lock(&be->locks[word]);
+    uint64_t mask = be->pending[word];
+    for (int i = 0; i < 64; i++) {
+        out[i] = (mask >> i) & 1 ? account_job_value(be->kind, be->param, balances[i])
+                                 : balances[i];
+    }
+    pthread_mutex_unlock(&be->locks[word]);
+}
+
+int batch_done(BatchEngine *be) {
+    return be->active &&
+           __atomic_load_n(&be->workers_done, __ATOMIC_ACQUIRE) == be->nworkers;
+}
+
+void batch_finish(BatchEngine *be, BatchStats *stats) {
+    for (int i = 0; i < be->nworkers; i++) {
+        pthread_join(be->workers[i], NULL);
+    }
+
+    stats->epoch = be->epoch;
+    stats->kind = be->kind;
+    stats->param = be->param;
+    stats->accounts = be->accounts;
+    stats->delta = be->delta;
+    stats->seconds = (double)(be->ended_ns - be->started_ns) / 1e9;
+
+    be->nworkers = 0;
+    be->active = 0;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * batch.h - End-of-day batch jobs over the whole account table
+ *
+ * A batch (interest, fee, floor) runs on worker threads, one bitmap word of
+ * 64 accounts at a time, while the main loop keeps serving clients. The
+ * accounts active when the batch starts form its epoch and are tracked in a
+ * pending bitmap. Before the server touches an account it catches up that
+ * account's word, so every live request sees the balance the batch would
+ * have produced had it run instantly at the start of the epoch.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "accounts.h"
+
+#include <pthread.h>
+
+#define BATCH_MAX_WORKERS 8
+
+typedef struct {
+    AccountTable *table;
+    int kind;                       // BatchJobKind
+    int64_t param;
+    uint32_t epoch;
+    int active;                     // a batch has been started and not finished
+
+    // Words still to transform, cleared under the word's lock once done
+    uint64_t pending[ACCOUNT_WORDS];
+    pthread_mutex_t locks[ACCOUNT_WORDS];
+
+    pthread_t workers[BATCH_MAX_WORKERS];
+    int nworkers;
+    int next_word;                  // next word for a worker to claim
+    int workers_done;
+
+    int total;                      // accounts in the epoch
+    int accounts;                   // accounts transformed so far
+    int64_t delta;                  // change in total deposits so far
+    int64_t started_ns;
+    int64_t ended_ns;               // when the last worker ran out of words
+} BatchEngine;
+
+typedef struct {
+    uint32_t epoch;
+    int kind;
+    int64_t param;
+    int accounts;
+    int64_t delta;
+    double seconds;
+} BatchStats;
+
+int batch_init(BatchEngine *be);
+
+// Snapshot the active accounts as the epoch and start the workers.
+// Returns -1 if a batch is already running.
+int batch_start(BatchEngine *be, AccountTable *table, int kind, int64_t param, uint32_t epoch);
+
+// Bring the word holding idx up to the epoch before the caller touches it
+void batch_touch(BatchEngine *be, uint32_t idx);
+
+// Balances of one word as the batch will leave them, without writing them
+void batch_word_balances(BatchEngine *be, const AccountTable *table, int word, int64_t out[64]);
+
+// 1 once every worker has finished, the batch still needs batch_finish()
+int batch_done(BatchEngine *be);
+
+// Join the workers and report what the batch did
+void batch_finish(BatchEngine *be, BatchStats *stats);
+
+#endif /* BATCH_H */
\ No newline at end of file
@@ -0,0 +1,178 @@
+/**
+ * bench_fifo.c - Server FIFO read microbenchmark
+ *
+ * A writer process plays the clients and writes Message structs one write()
+ * at a time. The reader drains them either the old way (select + one
+ * sizeof(Message) read per message) or through the FrameReader (select only
+ * when nothing is buffered, one readv for everything available), and reports
+ * messages per second and messages per syscall for each.
+ */
+
+#define _GNU_SOURCE
+#include "common.h"
+#include "frame_reader.h"
+
+#include <sys/select.h>
+
+#define DEFAULT_MESSAGES 1000000
+#define BENCH_PIPE_SIZE (1024 * 1024)
+
+typedef struct {
+    const char *name;
+    unsigned long messages;
+    unsigned long syscalls;
+    double seconds;
+} BenchResult;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Writer side: one write() per message, like the clients do
+static pid_t start_writer(int fd, unsigned long count) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        Message msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.version = WIRE_VERSION;
+        msg.type = MSG_DEPOSIT;
+        msg.account_id = 1;
+        msg.amount = 1;
+        for (unsigned long i = 0; i < count; i++) {
+            msg.client_pid = (pid_t)i;
+            if (write(fd, &msg, sizeof(msg)) != sizeof(msg)) {
+                perror("writer");
+                _exit(EXIT_FAILURE);
+            }
+        }
+        _exit(EXIT_SUCCESS);
+    }
+    return pid;
+}
+
+static int wait_readable(int fd) {
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(fd, &read_fds);
+    return select(fd + 1, &read_fds, NULL, NULL, NULL);
+}
+
+// Old server loop: select + read(sizeof(Message)) per message
+static void bench_per_message(int fd, unsigned long count, BenchResult *res) {
+    Message msg;
+    unsigned long seen = 0;
+    unsigned long checksum = 0;
+
+    while (seen < count) {
+        if (wait_readable(fd) == -1) {
+            perror("select");
+            break;
+        }
+        res->syscalls++;
+
+        ssize_t n = read(fd, &msg, sizeof(msg));
+        res->syscalls++;
+        if (n <= 0) {
+            break;
+        }
+        checksum += (unsigned long)msg.amount;
+        seen++;
+    }
+    res->messages = seen;
+    (void)checksum;
+}
+
+// New server loop: bulk reads into the frame ring, batches to the apply stage
+static void bench_framed(int fd, unsigned long count, BenchResult *res) {
+    FrameReader reader;
+    Message batch[256];
+    unsigned long seen = 0;
+    unsigned long checksum = 0;
+
+    if (frame_reader_init(&reader, FRAME_RING_SIZE, sizeof(Message)) == -1) {
+        perror("frame_reader_init");
+        return;
+    }
+
+    while (seen < count) {
+        if (frame_reader_frames(&reader) == 0) {
+            if (wait_readable(fd) == -1) {
+                perror("select");
+                break;
+            }
+            res->syscalls++;
+            if (frame_reader_fill(&reader, fd) <= 0) {
+                res->syscalls++;
+                break;
+            }
+            res->syscalls++;
+        }
+
+        size_t got = frame_reader_next_batch(&reader, batch, 256);
+        for (size_t i = 0; i < got; i++) {
+            checksum += (unsigned long)batch[i].amount;
+        }
+        seen += got;
+    }
+    res->messages = seen;
+    frame_reader_free(&reader);
+    (void)checksum;
+}
+
+static void run(const char *name, void (*reader)(int, unsigned long, BenchResult *),
+                unsigned long count, BenchResult *res) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    // Same capacity for both runs; F_SETPIPE_SZ may be capped, that is fine
+    fcntl(fds[1], F_SETPIPE_SZ, BENCH_PIPE_SIZE);
+
+    memset(res, 0, sizeof(*res));
+    res->name = name;
+
+    double start = now_seconds();
+    pid_t writer = start_writer(fds[1], count);
+    close(fds[1]);
+    reader(fds[0], count, res);
+    res->seconds = now_seconds() - start;
+
+    close(fds[0]);
+    waitpid(writer, NULL, 0);
+}
+
+static void report(const BenchResult *res) {
+    printf("%-12s %10lu msgs %10lu syscalls %8.2f msgs/syscall %12.0f msgs/s\n",
+           res->name, res->messages, res->syscalls,
+           res->syscalls ? (double)res->messages / (double)res->syscalls : 0.0,
+           res->seconds > 0 ? (double)res->messages / res->seconds : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long count = DEFAULT_MESSAGES;
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [messages]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (argc == 2) {
+        count = strtoul(argv[1], NULL, 10);
+    }
+
+    BenchResult before, after;
+    printf("Server FIFO read benchmark, %lu messages of %zu bytes\n", count, sizeof(Message));
+    run("per-message", bench_per_message, count, &before);
+    report(&before);
+    run("framed", bench_framed, count, &after);
+    report(&after);
+
+    if (before.seconds > 0 && after.seconds > 0) {
+        printf("speedup %.2fx, syscalls per message %.3f -> %.3f\n",
+               before.seconds / after.seconds,
+               (double)before.syscalls / (double)before.messages,
+               (double)after.syscalls / (double)after.messages);
+    }
+    return 0;
+}
\ No newline at end of file
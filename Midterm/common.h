@@ -1,62 +1,131 @@
-/**
- * common.h - Shared definitions for the Bank Simulator
- */
-
-#ifndef COMMON_H
-#define COMMON_H
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <string.h>
-#include <fcntl.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/wait.h>
-#include <signal.h>
-#include <time.h>
-#include <errno.h>
-#include <sys/mman.h>
-#include <semaphore.h>
-
-// Constants
-#define MAX_ACCOUNTS 1000
-#define MAX_BUFFER 256
-#define MAX_CLIENTS 20
-#define BANK_NAME "AdaBank"
-#define LOG_FILE "AdaBank.bankLog"
-
-// Account structure
-typedef struct {
-    char account_id[20];
-    int balance;
-    int is_active;
-} Account;
-
-// Message types
-typedef enum {
-    MSG_DEPOSIT,
-    MSG_WITHDRAW,
-    MSG_RESPONSE
-} MessageType;
-
-// Message structure for communication
-typedef struct {
-    MessageType type;
-    char account_id[20];
-    int amount;
-    int status;  // 0: success, negative: error
-    pid_t client_pid;
-} Message;
-
-// Create client FIFO name based on PID
-static inline void client_fifo_name(char *buffer, pid_t pid) {
-    sprintf(buffer, "client_%d_fifo", pid);
-}
-
-// Debug macro
-#define DEBUG_PRINT(fmt, ...) \
-    do { fprintf(stderr, "[DEBUG] %s:%d:%s(): " fmt, \
-         __FILE__, __LINE__, __func__, ##__VA_ARGS__); } while (0)
-
+/**
+ * common.h - Shared definitions for the Bank Simulator
+ */
+
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <semaphore.h>
+
+// Constants
+#define MAX_ACCOUNTS 1000
+#define MAX_BUFFER 256
+#define MAX_CLIENTS 20
+#define BANK_NAME "AdaBank"
+#define LOG_FILE "AdaBank.bankLog"
+
+// Message types (op codes)
+typedef enum {
+    MSG_DEPOSIT,
+    MSG_WITHDRAW,
+    MSG_RESPONSE,
+    MSG_HELLO,      // first message of a client group, amount = client count
+    MSG_BATCH       // end-of-day batch job over all accounts, see BatchJobKind
+} MessageType;
+
+// End-of-day batch jobs, carried in Message.job with the parameter in amount
+typedef enum {
+    BATCH_NONE,
+    BATCH_INTEREST,     // balance += balance * amount / 10000 (basis points)
+    BATCH_FEE,          // balance -= amount, only where balance > amount
+    BATCH_FLOOR         // balance = max(balance, amount)
+} BatchJobKind;
+
+// Wire format version carried in every message
+#define WIRE_VERSION 2
+
+// Account ID of a client that has no account yet ("N" / "BankID_None")
+#define ACCOUNT_NONE 0u
+
+// Message structure for communication (wire format v2)
+// Account IDs travel as numbers; "BankID_<n>" text only exists at the edges
+// (client files and the log). Fixed 32 bytes, naturally aligned, so two
+// messages fill a 64-byte cache line and frames never straddle one.
+typedef struct {
+    uint8_t version;        // WIRE_VERSION
+    uint8_t type;           // MessageType
+    int16_t status;         // 0: success, negative: error (-3: batch busy)
+    uint32_t account_id;    // numeric BankID, ACCOUNT_NONE for new clients
+    uint32_t request_id;    // sequence number within the client group
+    int32_t amount;
+    pid_t client_pid;
+    int32_t job;            // BatchJobKind for MSG_BATCH, 0 otherwise
+    int64_t balance;        // account balance after the request (responses)
+} Message;
+
+_Static_assert(sizeof(Message) == 32, "Message must stay 32 bytes on the wire");
+
+// Parse "BankID_<n>" into n; "N" and "BankID_None" give ACCOUNT_NONE.
+// Returns -1 for anything else.
+static inline int64_t account_id_parse(const char *text) {
+    if (strcmp(text, "N") == 0 || strcmp(text, "BankID_None") == 0) {
+        return ACCOUNT_NONE;
+    }
+    if (strncmp(text, "BankID_", 7) != 0 || text[7] < '0' || text[7] > '9') {
+        return -1;
+    }
+
+    int64_t id = 0;
+    for (const char *p = text + 7; *p; p++) {
+        if (*p < '0' || *p > '9' || id > UINT32_MAX / 10) {
+            return -1;
+        }
+        id = id * 10 + (*p - '0');
+    }
+    return id;
+}
+
+// Format a numeric account ID as "BankID_<n>"
+static inline void account_id_format(char *buffer, size_t size, uint32_t id) {
+    if (id == ACCOUNT_NONE) {
+        snprintf(buffer, size, "BankID_None");
+    } else {
+        snprintf(buffer, size, "BankID_%u", id);
+    }
+}
+
+// Batch job names as written in client files and the log
+static inline int batch_job_parse(const char *text) {
+    if (strcmp(text, "interest") == 0) {
+        return BATCH_INTEREST;
+    } else if (strcmp(text, "fee") == 0) {
+        return BATCH_FEE;
+    } else if (strcmp(text, "floor") == 0) {
+        return BATCH_FLOOR;
+    }
+    return BATCH_NONE;
+}
+
+static inline const char *batch_job_name(int kind) {
+    switch (kind) {
+    case BATCH_INTEREST: return "interest";
+    case BATCH_FEE: return "fee";
+    case BATCH_FLOOR: return "floor";
+    default: return "none";
+    }
+}
+
+// Create client FIFO name based on PID
+static inline void client_fifo_name(char *buffer, pid_t pid) {
+    sprintf(buffer, "client_%d_fifo", pid);
+}
+
+// Debug macro
+#define DEBUG_PRINT(fmt, ...) \
+    do { fprintf(stderr, "[DEBUG] %s:%d:%s(): " fmt, \
+         __FILE__, __LINE__, __func__, ##__VA_ARGS__); } while (0)
+
 #endif /* COMMON_H */
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * frame_reader.c - Ring buffer that splits a byte stream into fixed-size frames
+ */
+
+#include "frame_reader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+int frame_reader_init(FrameReader *fr, size_t size, size_t frame_size) {
+    memset(fr, 0, sizeof(*fr));
+
+    // Round up to a power of 2 so positions wrap with a mask
+    size_t cap = 1;
+    while (cap < size || cap < frame_size) {
+        cap <<= 1;
+    }
+
+    fr->data = malloc(cap);
+    if (!fr->data) {
+        return -1;
+    }
+    fr->size = cap;
+    fr->frame_size = frame_size;
+    return 0;
+}
+
+void frame_reader_free(FrameReader *fr) {
+    free(fr->data);
+    fr->data = NULL;
+    fr->size = 0;
+}
+
+void frame_reader_reset(FrameReader *fr) {
+    fr->head = 0;
+    fr->tail = 0;
+}
+
+size_t frame_reader_bytes(const FrameReader *fr) {
+    return fr->tail - fr->head;
+}
+
+size_t frame_reader_frames(const FrameReader *fr) {
+    return (fr->tail - fr->head) / fr->frame_size;
+}
+
+ssize_t frame_reader_fill(FrameReader *fr, int fd) {
+    size_t mask = fr->size - 1;
+    size_t used = fr->tail - fr->head;
+    size_t space = fr->size - used;
+    if (space == 0) {
+        return 0;
+    }
+
+    // Free space may wrap past the end of the buffer: cover both parts
+    size_t start = fr->tail & mask;
+    size_t first = fr->size - start;
+    if (first > space) {
+        first = space;
+    }
+
+    struct iovec iov[2];
+    iov[0].iov_base = fr->data + start;
+    iov[0].iov_len = first;
+    iov[1].iov_base = fr->data;
+    iov[1].iov_len = space - first;
+
+    fr->reads++;
+    ssize_t n = readv(fd, iov, iov[1].iov_len ? 2 : 1);
+    if (n > 0) {
+        fr->tail += (size_t)n;
+    }
+    return n;
+}
+
+// Double the capacity, laying the buffered bytes out from offset 0
+static int frame_reader_grow(FrameReader *fr, size_t need) {
+    size_t cap = fr->size;
+    while (cap - (fr->tail - fr->head) < need) {
+        cap <<= 1;
+    }
+
+    char *data = malloc(cap);
+    if (!data) {
+        return -1;
+    }
+
+    size_t used = fr->tail - fr->head;
+    size_t start = fr->head & (fr->size - 1);
+    size_t first = fr->size - start;
+    if (first > used) {
+        first = used;
+    }
+    memcpy(data, fr->data + start, first);
+    memcpy(data + first, fr->data, used - first);
+
+    free(fr->data);
+    fr->data = data;
+    fr->size = cap;
+    fr->head = 0;
+    fr->tail = used;
+    return 0;
+}
+
+int frame_reader_feed(FrameReader *fr, const void *data, size_t len) {
+    if (fr->size - (fr->tail - fr->head) < len && frame_reader_grow(fr, len) == -1) {
+        return -1;
+    }
+
+    size_t mask = fr->size - 1;
+    size_t start = fr->tail & mask;
+    size_t first = fr->size - start;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(fr->data + start, data, first);
+    memcpy(fr->data, (const char *)data + first, len - first);
+    fr->tail += len;
+    return 0;
+}
+
+size_t frame_reader_next_batch(FrameReader *fr, void *out, size_t max) {
+    size_t count = frame_reader_frames(fr);
+    if (count > max) {
+        count = max;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Copy whole frames out; at most one copy boundary at the wrap point
+    size_t bytes = count * fr->frame_size;
+    size_t start = fr->head & (fr->size - 1);
+    size_t first = fr->size - start;
+    if (first > bytes) {
+        first = bytes;
+    }
+    memcpy(out, fr->data + start, first);
+    memcpy((char *)out + first, fr->data, bytes - first);
+
+    fr->head += bytes;
+    fr->frames += count;
+    return count;
+}
\ No newline at end of file
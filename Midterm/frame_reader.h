@@ -0,0 +1,48 @@
+/**
+ * frame_reader.h - Ring buffer that splits a byte stream into fixed-size frames
+ *
+ * The server FIFO carries back-to-back Message structs. Instead of one read()
+ * per Message, the reader pulls everything that is available into a ring and
+ * hands complete frames out in batches; a frame split across two reads stays
+ * in the ring until its remaining bytes arrive.
+ */
+
+#ifndef FRAME_READER_H
+#define FRAME_READER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define FRAME_RING_SIZE (64 * 1024)
+
+typedef struct {
+    char *data;
+    size_t size;                // capacity, always a power of 2
+    size_t head;                // total bytes consumed
+    size_t tail;                // total bytes stored
+    size_t frame_size;
+
+    unsigned long reads;        // read syscalls issued by frame_reader_fill
+    unsigned long frames;       // complete frames handed out
+} FrameReader;
+
+int frame_reader_init(FrameReader *fr, size_t size, size_t frame_size);
+void frame_reader_free(FrameReader *fr);
+
+// Drop buffered bytes, e.g. a partial frame left by a writer that went away
+void frame_reader_reset(FrameReader *fr);
+
+// Bytes buffered / complete frames buffered
+size_t frame_reader_bytes(const FrameReader *fr);
+size_t frame_reader_frames(const FrameReader *fr);
+
+// One read() into all free space (both sides of the wrap), returns read()'s result
+ssize_t frame_reader_fill(FrameReader *fr, int fd);
+
+// Append bytes that arrived by other means (e.g. io_uring), growing if needed
+int frame_reader_feed(FrameReader *fr, const void *data, size_t len);
+
+// Copy up to max complete frames into out, returns how many were copied
+size_t frame_reader_next_batch(FrameReader *fr, void *out, size_t max);
+
+#endif /* FRAME_READER_H */
\ No newline at end of file
@@ -1,652 +1,1364 @@
-/**
- * server.c - Bank Server implementation
- */
-
-#include "common.h"
-
-// Global variables
-Account accounts[MAX_ACCOUNTS];
-int next_account_id = 1;
-volatile sig_atomic_t running = 1;
-char server_fifo[MAX_BUFFER];
-
-// Global message storage to pass between main and teller processes
-Message current_messages[MAX_CLIENTS];
-int current_message_count = 0;
-
-// Function prototypes
-void initialize_bank();
-void save_bank_log();
-void signal_handler(int sig);
-int find_account_by_id(const char *account_id);
-int create_new_account();
-
-// Basic implementation functions
-void handle_deposit(Message *msg);
-void handle_withdraw(Message *msg);
-void create_teller_basic(pid_t client_pid);
-
-// Enhanced implementation functions
-pid_t Teller(void* func, void* arg_func);
-int waitTeller(pid_t pid, int* status);
-void deposit(void* arg);
-void withdraw(void* arg);
-void create_teller_enhanced(pid_t client_pid);
-
-// Shared memory structure for teller-server communication
-typedef struct {
-    Message request;
-    Message response;
-    sem_t request_sem;
-    sem_t response_sem;
-} SharedMemory;
-
-SharedMemory *shared_mems[MAX_CLIENTS];
-int next_shared_mem = 0;
-
-int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s BankName ServerFIFO_Name\n", argv[0]);
-        exit(EXIT_FAILURE);
-    }
-
-    // Save server FIFO name
-    strcpy(server_fifo, argv[2]);
-
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-
-    // Initialize the bank
-    initialize_bank();
-
-    printf("%s is active....\n", argv[1]);
-
-    // Create server FIFO
-    if (mkfifo(server_fifo, 0666) == -1 && errno != EEXIST) {
-        perror("mkfifo failed");
-        exit(EXIT_FAILURE);
-    }
-    
-    while (running) {
-        printf("Waiting for clients @%s...\n", server_fifo);
-        
-        // Open in non-blocking mode first to check if anyone is writing
-        int server_fd = open(server_fifo, O_RDONLY | O_NONBLOCK);
-        if (server_fd == -1) {
-            perror("Failed to open server FIFO");
-            break;
-        }
-        
-        // Switch to blocking mode
-        fcntl(server_fd, F_SETFL, fcntl(server_fd, F_GETFL) & ~O_NONBLOCK);
-
-        // Read client connections from FIFO
-        Message msg;
-        int client_count = 0;
-        pid_t client_group = 0;
-        
-        // Reset message storage
-        current_message_count = 0;
-        
-        // Set a timeout for reading
-        fd_set read_fds;
-        struct timeval tv;
-        int select_result;
-        
-        while (running) {
-            // Setup select parameters
-            FD_ZERO(&read_fds);
-            FD_SET(server_fd, &read_fds);
-            
-            // 5 second timeout
-            tv.tv_sec = 5;
-            tv.tv_usec = 0;
-            
-            select_result = select(server_fd + 1, &read_fds, NULL, NULL, &tv);
-            
-            if (select_result == -1) {
-                // Error in select
-                perror("Select failed");
-                break;
-            } else if (select_result == 0) {
-                // Timeout - no data available
-                if (client_count == 0) {
-                    // No clients connected yet, continue waiting
-                    continue;
-                } else {
-                    // Was in the middle of processing client group, but timed out
-                    DEBUG_PRINT("Timeout waiting for more clients from group %d\n", client_group);
-                    // Break out and process what we have
-                    break;
-                }
-            }
-            
-            // Data is available, read it
-            ssize_t read_result = read(server_fd, &msg, sizeof(Message));
-            
-            if (read_result <= 0) {
-                // End of file or error
-                if (read_result < 0) {
-                    perror("Read from server FIFO failed");
-                }
-                break;
-            }
-            
-            DEBUG_PRINT("Received message from client PID %d\n", msg.client_pid);
-            
-            if (client_count == 0) {
-                client_group = msg.client_pid;
-                printf(" - Received %d clients from PID%d..\n", msg.amount, client_group);
-                client_count = msg.amount;
-            } else {
-                DEBUG_PRINT("Creating teller for client PID %d\n", msg.client_pid);
-                DEBUG_PRINT("Message type: %d, account: %s, amount: %d\n", 
-                           msg.type, msg.account_id, msg.amount);
-                
-                // Store message for teller to use
-                if (current_message_count < MAX_CLIENTS) {
-                    memcpy(&current_messages[current_message_count++], &msg, sizeof(Message));
-                }
-                
-                // Process the message directly in the server first
-                if (msg.type == MSG_DEPOSIT) {
-                    handle_deposit(&msg);
-                } else if (msg.type == MSG_WITHDRAW) {
-                    handle_withdraw(&msg);
-                }
-                
-                // Update the stored message with the processed result
-                for (int i = 0; i < current_message_count; i++) {
-                    if (current_messages[i].client_pid == msg.client_pid) {
-                        memcpy(&current_messages[i], &msg, sizeof(Message));
-                        break;
-                    }
-                }
-                
-                // Create a teller to handle client communication
-                #ifdef ENHANCED
-                create_teller_enhanced(msg.client_pid);
-                #else
-                create_teller_basic(msg.client_pid);
-                #endif
-                
-                client_count--;
-                
-                if (client_count == 0) {
-                    DEBUG_PRINT("All clients from group %d processed\n", client_group);
-                    save_bank_log();
-                    break;
-                }
-            }
-        }
-        
-        close(server_fd);
-        
-        // If we're gracefully shutting down, break out of the loop
-        if (!running) {
-            break;
-        }
-        
-        // Collect any zombie teller processes
-        int status;
-        pid_t pid;
-        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
-            DEBUG_PRINT("Collected zombie teller process: %d\n", pid);
-        }
-    }
-
-    // Clean up
-    unlink(server_fifo);
-    save_bank_log();
-    printf("Removing ServerFIFO... Updating log file...\n");
-    printf("Adabank says \"Bye\"...\n");
-    
-    return 0;
-}
-
-// Initialize the bank and load from log if exists
-void initialize_bank() {
-    // Initialize all accounts as inactive
-    for (int i = 0; i < MAX_ACCOUNTS; i++) {
-        accounts[i].is_active = 0;
-    }
-
-    // Try to load from log file
-    FILE *log = fopen(LOG_FILE, "r");
-    if (log == NULL) {
-        printf("No previous logs.. Creating the bank database\n");
-        return;
-    }
-
-    char line[MAX_BUFFER];
-    while (fgets(line, MAX_BUFFER, log)) {
-        // Skip comments and empty lines
-        if (line[0] == '#' || line[0] == '\n') {
-            continue;
-        }
-        
-        char account_id[20];
-        int balance;
-        
-        // Parse line for account information
-        // Format: BankID_XX D 300 W 300 0
-        if (sscanf(line, "%s", account_id) == 1) {
-            char *token = strtok(line + strlen(account_id), " ");
-            balance = 0;
-            
-            // Find the last number on the line (final balance)
-            while (token != NULL) {
-                if (sscanf(token, "%d", &balance) == 1) {
-                    // This will keep overwriting until we get the last number
-                }
-                token = strtok(NULL, " ");
-            }
-            
-            if (balance > 0) {
-                int idx = find_account_by_id(account_id);
-                if (idx == -1) {
-                    // New account
-                    int id_num;
-                    if (sscanf(account_id, "BankID_%d", &id_num) == 1) {
-                        if (id_num >= next_account_id) {
-                            next_account_id = id_num + 1;
-                        }
-                    }
-                    
-                    idx = id_num;
-                    strcpy(accounts[idx].account_id, account_id);
-                }
-                accounts[idx].balance = balance;
-                accounts[idx].is_active = 1;
-            }
-        }
-    }
-    
-    fclose(log);
-}
-
-// Save bank log
-void save_bank_log() {
-    FILE *log = fopen(LOG_FILE, "w");
-    if (!log) {
-        perror("Failed to open log file");
-        return;
-    }
-    
-    // Get current time
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char time_str[50];
-    strftime(time_str, sizeof(time_str), "%H:%M %B %d %Y", tm_info);
-    
-    fprintf(log, "# Adabank Log file updated @%s \n", time_str);
-    
-    // Write active accounts
-    for (int i = 1; i < next_account_id; i++) {
-        if (accounts[i].is_active) {
-            fprintf(log, "%s D %d W 0 %d\n", 
-                   accounts[i].account_id, 
-                   accounts[i].balance, 
-                   accounts[i].balance);
-        }
-    }
-    
-    fprintf(log, "## end of log. \n");
-    fclose(log);
-    
-    DEBUG_PRINT("Log file saved with %d active accounts\n", next_account_id - 1);
-}
-
-// Signal handler
-void signal_handler(int sig) {
-    (void)sig; // Prevent unused parameter warning
-    printf("Signal received closing active Tellers\n");
-    running = 0;
-}
-
-// Find account by ID
-int find_account_by_id(const char *account_id) {
-    int id_num;
-    if (sscanf(account_id, "BankID_%d", &id_num) != 1) {
-        return -1;  // Invalid format
-    }
-    
-    if (id_num < 1 || id_num >= MAX_ACCOUNTS || !accounts[id_num].is_active) {
-        return -1;  // Not found or inactive
-    }
-    
-    return id_num;
-}
-
-// Create a new account
-int create_new_account() {
-    int id = next_account_id++;
-    sprintf(accounts[id].account_id, "BankID_%d", id);
-    accounts[id].balance = 0;
-    accounts[id].is_active = 1;
-    return id;
-}
-
-// Handle deposit request
-void handle_deposit(Message *msg) {
-    int account_idx;
-    
-    if (strcmp(msg->account_id, "BankID_None") == 0) {
-        // New client
-        account_idx = create_new_account();
-        DEBUG_PRINT("Created new account: %s\n", accounts[account_idx].account_id);
-    } else {
-        // Existing client
-        account_idx = find_account_by_id(msg->account_id);
-        if (account_idx == -1) {
-            DEBUG_PRINT("Account not found: %s\n", msg->account_id);
-            msg->status = -1;  // Account not found
-            return;
-        }
-        DEBUG_PRINT("Found existing account: %s with balance %d\n", 
-                   accounts[account_idx].account_id, accounts[account_idx].balance);
-    }
-    
-    // Update balance
-    accounts[account_idx].balance += msg->amount;
-    DEBUG_PRINT("Updated balance for %s to %d\n", 
-               accounts[account_idx].account_id, accounts[account_idx].balance);
-    
-    // Update message
-    strcpy(msg->account_id, accounts[account_idx].account_id);
-    msg->status = 0;  // Success
-    
-    printf("Client%d deposited %d credits... updating log\n", msg->client_pid, msg->amount);
-    save_bank_log();
-}
-
-// Handle withdraw request
-void handle_withdraw(Message *msg) {
-    int account_idx = find_account_by_id(msg->account_id);
-    
-    if (account_idx == -1) {
-        DEBUG_PRINT("Account not found for withdrawal: %s\n", msg->account_id);
-        msg->status = -1;  // Account not found
-        return;
-    }
-    
-    DEBUG_PRINT("Withdrawal from account %s with balance %d, amount %d\n", 
-               accounts[account_idx].account_id, accounts[account_idx].balance, msg->amount);
-    
-    if (accounts[account_idx].balance < msg->amount) {
-        printf("Client%d withdraws %d credit.. operation not permitted. \n", 
-               msg->client_pid, msg->amount);
-        DEBUG_PRINT("Insufficient funds: balance %d, requested %d\n", 
-                   accounts[account_idx].balance, msg->amount);
-        msg->status = -2;  // Insufficient funds
-        return;
-    }
-    
-    // Update balance
-    accounts[account_idx].balance -= msg->amount;
-    DEBUG_PRINT("New balance after withdrawal: %d\n", accounts[account_idx].balance);
-    
-    // Check if account should be closed
-    if (accounts[account_idx].balance == 0) {
-        accounts[account_idx].is_active = 0;
-        printf("Client%d withdraws %d credits... updating log... Bye Client%d\n", 
-               msg->client_pid, msg->amount, msg->client_pid);
-        DEBUG_PRINT("Account closed: %s\n", accounts[account_idx].account_id);
-    } else {
-        printf("Client%d withdraws %d credits... updating log\n", 
-               msg->client_pid, msg->amount);
-    }
-    
-    // Update message
-    msg->status = 0;  // Success
-    save_bank_log();
-}
-
-// Create teller process (basic implementation using fork)
-void create_teller_basic(pid_t client_pid) {
-    // Find the client's message
-    Message teller_msg;
-    memset(&teller_msg, 0, sizeof(Message));
-    teller_msg.client_pid = client_pid;
-    teller_msg.status = -1; // Default to error
-    
-    // Process the most recent message from this client
-    for (int i = 0; i < current_message_count; i++) {
-        if (current_messages[i].client_pid == client_pid) {
-            memcpy(&teller_msg, &current_messages[i], sizeof(Message));
-            DEBUG_PRINT("Found message for client %d: type %d, account %s, amount %d\n",
-                      client_pid, teller_msg.type, teller_msg.account_id, teller_msg.amount);
-            break;
-        }
-    }
-    
-    pid_t pid = fork();
-    
-    if (pid < 0) {
-        perror("Fork failed");
-        return;
-    }
-    
-    if (pid == 0) {
-        // Child process (Teller)
-        char client_fifo[MAX_BUFFER];
-        client_fifo_name(client_fifo, client_pid);
-        
-        DEBUG_PRINT("Teller for Client%d: Looking for client FIFO: %s\n", client_pid, client_fifo);
-        
-        // Wait for client FIFO to be created
-        struct stat st;
-        int retry = 0;
-        while (stat(client_fifo, &st) == -1) {
-            usleep(100000);  // 100ms
-            if (++retry > 50) {  // 5 second timeout
-                fprintf(stderr, "Teller: Client FIFO %s not found after timeout\n", client_fifo);
-                exit(EXIT_FAILURE);
-            }
-        }
-        
-        DEBUG_PRINT("Teller for Client%d: Found client FIFO\n", client_pid);
-        
-        // Open client FIFO for writing
-        DEBUG_PRINT("Teller for Client%d: Opening client FIFO for writing: %s\n", client_pid, client_fifo);
-        int client_fd = open(client_fifo, O_WRONLY);
-        if (client_fd == -1) {
-            perror("Failed to open client FIFO for writing");
-            exit(EXIT_FAILURE);
-        }
-        
-        // Check if this is a returning client
-        if (strcmp(teller_msg.account_id, "BankID_None") != 0 && 
-            find_account_by_id(teller_msg.account_id) != -1) {
-            printf(" -- Teller %d is active serving Client%d...Welcome back Client%d\n", 
-                   getpid(), client_pid, client_pid);
-        } else {
-            printf(" -- Teller %d is active serving Client%d...\n", getpid(), client_pid);
-        }
-        
-        // Send response back to client
-        DEBUG_PRINT("Teller for Client%d: Sending response with status %d, account %s\n", 
-                  client_pid, teller_msg.status, teller_msg.account_id);
-        
-        if (write(client_fd, &teller_msg, sizeof(Message)) != sizeof(Message)) {
-            perror("Failed to write response to client");
-        }
-        
-        DEBUG_PRINT("Teller %d: Closing connection with Client%d\n", getpid(), client_pid);
-        close(client_fd);
-        exit(EXIT_SUCCESS);
-    }
-    
-    // Parent continues
-}
-
-// Custom teller creation function (enhanced implementation)
-pid_t Teller(void* func, void* arg_func) {
-    // Create shared memory
-    SharedMemory *shm = mmap(NULL, sizeof(SharedMemory), 
-                            PROT_READ | PROT_WRITE, 
-                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-    
-    if (shm == MAP_FAILED) {
-        perror("mmap failed");
-        return -1;
-    }
-    
-    // Initialize semaphores
-    sem_init(&shm->request_sem, 1, 0);
-    sem_init(&shm->response_sem, 1, 0);
-    
-    // Store shared memory pointer
-    shared_mems[next_shared_mem++] = shm;
-    
-    pid_t pid = fork();
-    
-    if (pid < 0) {
-        perror("Fork failed");
-        munmap(shm, sizeof(SharedMemory));
-        return -1;
-    }
-    
-    if (pid == 0) {
-        // Child process (Teller)
-        // Cast and call the function
-        void (*teller_func)(void*) = func;
-        teller_func(arg_func);
-        exit(EXIT_SUCCESS);
-    }
-    
-    return pid;
-}
-
-// Custom wait function for Teller
-int waitTeller(pid_t pid, int* status) {
-    return waitpid(pid, status, 0);
-}
-
-// Deposit function for Teller
-void deposit(void* arg) {
-    Message *msg = (Message*)arg;
-    DEBUG_PRINT("Enhanced deposit: account %s, amount %d\n", msg->account_id, msg->amount);
-    
-    // Copy to shared memory
-    SharedMemory *shm = shared_mems[next_shared_mem - 1];
-    memcpy(&shm->request, msg, sizeof(Message));
-    
-    // Signal request is ready
-    sem_post(&shm->request_sem);
-    
-    // Wait for response
-    sem_wait(&shm->response_sem);
-    
-    // Copy response back
-    memcpy(msg, &shm->response, sizeof(Message));
-    DEBUG_PRINT("Enhanced deposit completed: status %d, account %s\n", msg->status, msg->account_id);
-}
-
-// Withdraw function for Teller
-void withdraw(void* arg) {
-    Message *msg = (Message*)arg;
-    DEBUG_PRINT("Enhanced withdraw: account %s, amount %d\n", msg->account_id, msg->amount);
-    
-    // Copy to shared memory
-    SharedMemory *shm = shared_mems[next_shared_mem - 1];
-    memcpy(&shm->request, msg, sizeof(Message));
-    
-    // Signal request is ready
-    sem_post(&shm->request_sem);
-    
-    // Wait for response
-    sem_wait(&shm->response_sem);
-    
-    // Copy response back
-    memcpy(msg, &shm->response, sizeof(Message));
-    DEBUG_PRINT("Enhanced withdraw completed: status %d, account %s\n", msg->status, msg->account_id);
-}
-
-// Create teller process (enhanced implementation)
-void create_teller_enhanced(pid_t client_pid) {
-    // Find the client's message
-    Message teller_msg;
-    memset(&teller_msg, 0, sizeof(Message));
-    teller_msg.client_pid = client_pid;
-    teller_msg.status = -1; // Default to error
-    
-    // Process the most recent message from this client
-    for (int i = 0; i < current_message_count; i++) {
-        if (current_messages[i].client_pid == client_pid) {
-            memcpy(&teller_msg, &current_messages[i], sizeof(Message));
-            DEBUG_PRINT("Enhanced: Found message for client %d: type %d, account %s, amount %d\n",
-                      client_pid, teller_msg.type, teller_msg.account_id, teller_msg.amount);
-            break;
-        }
-    }
-    
-    // Wait for client FIFO to be created
-    char client_fifo[MAX_BUFFER];
-    client_fifo_name(client_fifo, client_pid);
-    
-    DEBUG_PRINT("Enhanced teller for Client%d: Looking for client FIFO: %s\n", client_pid, client_fifo);
-    
-    struct stat st;
-    int retry = 0;
-    while (stat(client_fifo, &st) == -1) {
-        usleep(100000);  // 100ms
-        if (++retry > 50) {  // 5 second timeout
-            fprintf(stderr, "Enhanced Teller: Client FIFO %s not found after timeout\n", client_fifo);
-            return;
-        }
-    }
-    
-    DEBUG_PRINT("Enhanced teller for Client%d: Found client FIFO\n", client_pid);
-    
-    // Open client FIFO
-    int client_fd = open(client_fifo, O_RDWR);
-    if (client_fd == -1) {
-        perror("Failed to open client FIFO");
-        return;
-    }
-    
-    // Create appropriate teller
-    pid_t teller_pid;
-    if (teller_msg.type == MSG_DEPOSIT) {
-        teller_pid = Teller(deposit, &teller_msg);
-    } else {
-        teller_pid = Teller(withdraw, &teller_msg);
-    }
-    
-    printf(" -- Teller %d is active serving Client%d...\n", teller_pid, client_pid);
-    
-    // Wait for teller to process request
-    SharedMemory *shm = shared_mems[next_shared_mem - 1];
-    
-    // Wait for request to be ready
-    sem_wait(&shm->request_sem);
-    
-    // Process request
-    if (shm->request.type == MSG_DEPOSIT) {
-        handle_deposit(&shm->request);
-    } else if (shm->request.type == MSG_WITHDRAW) {
-        handle_withdraw(&shm->request);
-    }
-    
-    // Copy response
-    memcpy(&shm->response, &shm->request, sizeof(Message));
-    
-    // Signal response is ready
-    sem_post(&shm->response_sem);
-    
-    // Wait for teller to complete
-    int status;
-    waitTeller(teller_pid, &status);
-    
-    // Send response to client
-    write(client_fd, &teller_msg, sizeof(Message));
-    
-    close(client_fd);
-    
-    // Clean up shared memory
-    sem_destroy(&shm->request_sem);
-    sem_destroy(&shm->response_sem);
-    munmap(shm, sizeof(SharedMemory));
+/**
+ * server.c - Bank Server implementation
+ */
+
+#include "common.h"
+#include "uring_io.h"
+#include "frame_reader.h"
+#include "accounts.h"
+#include "batch.h"
+
+// I/O engines selectable at startup
+typedef enum {
+    IO_POSIX,
+    IO_URING
+} IoEngine;
+
+// Global variables
+AccountTable bank;
+int next_account_id = 1;
+volatile sig_atomic_t running = 1;
+char server_fifo[MAX_BUFFER];
+IoEngine io_engine = IO_POSIX;
+int64_t ledger_total = 0;   // running sum of deposits minus withdrawals
+
+// End-of-day batch jobs run on worker threads next to live traffic
+BatchEngine batch;
+uint32_t batch_epoch = 0;   // last batch epoch started or found in the log
+
+// Live reports (SIGUSR1) run in a forked snapshot of the account table
+#define REPORT_FILE "AdaBank.report"
+volatile sig_atomic_t report_requested = 0;
+pid_t report_pid = 0;
+
+// Global message storage to pass between main and teller processes
+Message current_messages[MAX_CLIENTS];
+int current_message_count = 0;
+
+// Function prototypes
+void initialize_bank();
+void save_bank_log();
+void signal_handler(int sig);
+void report_signal_handler(int sig);
+void service_live_report();
+void write_report();
+int find_account_by_id(uint32_t account_id);
+int check_wire_version(const Message *msg);
+int create_new_account();
+int journal_record(const char *line, int len);
+void service_batch(int wait);
+
+// I/O engine functions
+void apply_batch(Message *batch, size_t count, int *client_count, pid_t *client_group);
+void serve_posix();
+int serve_uring();
+
+// Basic implementation functions
+void handle_deposit(Message *msg);
+void handle_withdraw(Message *msg);
+void handle_batch(Message *msg);
+void create_teller_basic(pid_t client_pid);
+
+// Enhanced implementation functions
+pid_t Teller(void* func, void* arg_func);
+int waitTeller(pid_t pid, int* status);
+void deposit(void* arg);
+void withdraw(void* arg);
+void create_teller_enhanced(pid_t client_pid);
+
+// Shared memory structure for teller-server communication
+typedef struct {
+    Message request;
+    Message response;
+    sem_t request_sem;
+    sem_t response_sem;
+} SharedMemory;
+
+SharedMemory *shared_mems[MAX_CLIENTS];
+int next_shared_mem = 0;
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage: %s BankName ServerFIFO_Name [posix|uring]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Pick the I/O engine, posix is the default
+    if (argc == 4) {
+        if (strcmp(argv[3], "uring") == 0) {
+            io_engine = IO_URING;
+        } else if (strcmp(argv[3], "posix") != 0) {
+            fprintf(stderr, "Unknown I/O engine: %s (expected posix or uring)\n", argv[3]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Save server FIFO name
+    strcpy(server_fifo, argv[2]);
+
+    // Set up signal handlers
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, report_signal_handler);
+
+    if (batch_init(&batch) == -1) {
+        fprintf(stderr, "Failed to set up the batch engine\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Initialize the bank
+    initialize_bank();
+
+    printf("%s is active....\n", argv[1]);
+
+    // Create server FIFO
+    if (mkfifo(server_fifo, 0666) == -1 && errno != EEXIST) {
+        perror("mkfifo failed");
+        exit(EXIT_FAILURE);
+    }
+    
+    if (io_engine == IO_URING && serve_uring() == -1) {
+        printf("io_uring unavailable, falling back to posix I/O\n");
+        io_engine = IO_POSIX;
+    }
+    if (io_engine == IO_POSIX) {
+        serve_posix();
+    }
+
+    // Clean up, letting a running batch finish first
+    unlink(server_fifo);
+    service_batch(1);
+    save_bank_log();
+    printf("Removing ServerFIFO... Updating log file...\n");
+    printf("Adabank says \"Bye\"...\n");
+    
+    return 0;
+}
+
+// Frames handed to the apply stage at once
+#define APPLY_BATCH 256
+
+// Apply stage: run a batch of framed messages from the server FIFO
+void apply_batch(Message *batch, size_t count, int *client_count, pid_t *client_group) {
+    for (size_t b = 0; b < count; b++) {
+        Message msg = batch[b];
+        
+        DEBUG_PRINT("Received message from client PID %d\n", msg.client_pid);
+        
+        if (check_wire_version(&msg) == -1) {
+            continue;
+        }
+        
+        if (msg.type == MSG_HELLO) {
+            *client_group = msg.client_pid;
+            printf(" - Received %d clients from PID%d..\n", msg.amount, *client_group);
+            *client_count = msg.amount;
+            
+            // Reset message storage
+            current_message_count = 0;
+            continue;
+        }
+        
+        DEBUG_PRINT("Creating teller for client PID %d\n", msg.client_pid);
+        DEBUG_PRINT("Message type: %d, account: %u, amount: %d\n", 
+                   msg.type, msg.account_id, msg.amount);
+        
+        // Store message for teller to use
+        if (current_message_count < MAX_CLIENTS) {
+            memcpy(&current_messages[current_message_count++], &msg, sizeof(Message));
+        }
+        
+        // Process the message directly in the server first
+        if (msg.type == MSG_DEPOSIT) {
+            handle_deposit(&msg);
+        } else if (msg.type == MSG_WITHDRAW) {
+            handle_withdraw(&msg);
+        } else if (msg.type == MSG_BATCH) {
+            handle_batch(&msg);
+        }
+        
+        // Update the stored message with the processed result
+        for (int i = 0; i < current_message_count; i++) {
+            if (current_messages[i].client_pid == msg.client_pid) {
+                memcpy(&current_messages[i], &msg, sizeof(Message));
+                break;
+            }
+        }
+        
+        // Create a teller to handle client communication
+        #ifdef ENHANCED
+        create_teller_enhanced(msg.client_pid);
+        #else
+        create_teller_basic(msg.client_pid);
+        #endif
+        
+        // A batch may run on into the next group's messages
+        if (*client_count > 0 && --(*client_count) == 0) {
+            DEBUG_PRINT("All clients from group %d processed\n", *client_group);
+            save_bank_log();
+        }
+    }
+}
+
+// Serve client groups with select() and bulk reads into a frame ring
+// (default I/O engine)
+void serve_posix() {
+    FrameReader reader;
+    Message batch[APPLY_BATCH];
+    
+    if (frame_reader_init(&reader, FRAME_RING_SIZE, sizeof(Message)) == -1) {
+        perror("Failed to allocate server FIFO buffer");
+        return;
+    }
+    
+    while (running) {
+        printf("Waiting for clients @%s...\n", server_fifo);
+        
+        // Open in non-blocking mode first to check if anyone is writing
+        int server_fd = open(server_fifo, O_RDONLY | O_NONBLOCK);
+        if (server_fd == -1) {
+            perror("Failed to open server FIFO");
+            break;
+        }
+        
+        // Switch to blocking mode
+        fcntl(server_fd, F_SETFL, fcntl(server_fd, F_GETFL) & ~O_NONBLOCK);
+
+        // Read client connections from FIFO
+        int client_count = 0;
+        pid_t client_group = 0;
+        
+        // Set a timeout for reading
+        fd_set read_fds;
+        struct timeval tv;
+        int select_result;
+        
+        while (running) {
+            service_batch(0);
+            service_live_report();
+            
+            // Only wait on the FIFO when no complete message is buffered
+            if (frame_reader_frames(&reader) == 0) {
+                // Setup select parameters
+                FD_ZERO(&read_fds);
+                FD_SET(server_fd, &read_fds);
+                
+                // 5 second timeout
+                tv.tv_sec = 5;
+                tv.tv_usec = 0;
+                
+                select_result = select(server_fd + 1, &read_fds, NULL, NULL, &tv);
+                
+                if (select_result == -1) {
+                    // Interrupted by a signal: re-check running and reports
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // Error in select
+                    perror("Select failed");
+                    break;
+                } else if (select_result == 0) {
+                    // Timeout - no data available
+                    if (client_count == 0) {
+                        // No clients connected yet, continue waiting
+                        continue;
+                    } else {
+                        // Was in the middle of processing client group, but timed out
+                        DEBUG_PRINT("Timeout waiting for more clients from group %d\n", client_group);
+                        // Break out and process what we have
+                        break;
+                    }
+                }
+                
+                // Data is available, pull in everything the FIFO holds
+                ssize_t read_result = frame_reader_fill(&reader, server_fd);
+                
+                if (read_result <= 0) {
+                    // End of file or error
+                    if (read_result < 0) {
+                        perror("Read from server FIFO failed");
+                    }
+                    break;
+                }
+            }
+            
+            size_t count = frame_reader_next_batch(&reader, batch, APPLY_BATCH);
+            apply_batch(batch, count, &client_count, &client_group);
+        }
+        
+        close(server_fd);
+        
+        // A partial frame from this group's writers can never complete;
+        // don't splice it onto the next client's first message
+        frame_reader_reset(&reader);
+        
+        // If we're gracefully shutting down, break out of the loop
+        if (!running) {
+            break;
+        }
+        
+        // Collect any zombie teller processes
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            DEBUG_PRINT("Collected zombie teller process: %d\n", pid);
+        }
+    }
+    
+    if (reader.frames > 0) {
+        printf("Server FIFO: %lu messages in %lu reads (%.2f messages/read)\n",
+               reader.frames, reader.reads, (double)reader.frames / (double)reader.reads);
+    }
+    frame_reader_free(&reader);
+}
+
+// io_uring engine sizing
+#define URING_ENTRIES 512           // room for every slot's 4-SQE chain plus the read
+#define URING_SLOTS 64              // client replies in flight
+#define URING_READ_BUFS 16          // provided buffers, power of 2
+#define URING_READ_BUF_SIZE 4096
+#define URING_BGID 1
+#define URING_WAIT_MS 1000
+#define URING_GROUP_TIMEOUT 5       // seconds, same as the select() path
+
+// What a completion belongs to, packed into user_data as (slot << 8) | kind
+enum {
+    UD_READ = 1,
+    UD_JOURNAL,
+    UD_OPEN,
+    UD_REPLY,
+    UD_CLOSE
+};
+#define URING_UD(slot, kind) (((__u64)(slot) << 8) | (kind))
+
+// One in-flight reply chain: journal append -> open FIFO -> write -> close
+typedef struct {
+    int busy;
+    int pending;                    // CQEs still expected for this chain
+    Message reply;
+    char fifo[MAX_BUFFER];
+    char journal[MAX_BUFFER];
+} UringSlot;
+
+typedef struct {
+    Uring ring;
+    UringBufRing bufs;
+    int multishot;                  // 0 once we fell back to plain reads
+    int server_fd;
+    char read_buf[URING_READ_BUF_SIZE];
+
+    // Bytes read from the server FIFO, split into Message frames
+    FrameReader reader;
+
+    UringSlot slots[URING_SLOTS];
+    int busy_slots;
+
+    int journal_fd;
+    off_t journal_off;              // next append offset, assigned at submit time
+
+    int client_count;
+    pid_t client_group;
+    time_t last_message;
+    int compact_pending;            // group done, compact once replies drained
+
+    unsigned long requests;
+} UringServer;
+
+static UringServer uring_server;
+
+// (Re)arm the server FIFO read, multishot when the kernel supports it
+static int uring_arm_read(UringServer *us) {
+    struct io_uring_sqe *sqe = uring_get_sqe(&us->ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    if (us->multishot) {
+        uring_prep_read_multishot(sqe, us->server_fd, URING_BGID);
+    } else {
+        uring_prep_read(sqe, us->server_fd, us->read_buf, sizeof(us->read_buf), (__u64)-1);
+    }
+    sqe->user_data = URING_UD(0, UD_READ);
+    return 0;
+}
+
+// Journal and reply without the ring, for when no slot or SQEs are free
+static void uring_reply_sync(const Message *msg) {
+    uint32_t id = msg->account_id;
+    if (msg->status == 0 && id >= 1 && id < MAX_ACCOUNTS) {
+        char line[MAX_BUFFER];
+        int len = snprintf(line, sizeof(line), "%s D %lld W 0 %lld\n",
+                           bank.id[id],
+                           (long long)bank.balance[id],
+                           (long long)bank.balance[id]);
+        journal_record(line, len);
+    }
+
+    char fifo[MAX_BUFFER];
+    client_fifo_name(fifo, msg->client_pid);
+    int fd = open(fifo, O_WRONLY);
+    if (fd == -1) {
+        perror("Failed to open client FIFO");
+        return;
+    }
+    if (write(fd, msg, sizeof(Message)) != sizeof(Message)) {
+        perror("Failed to write reply");
+    }
+    close(fd);
+}
+
+// Queue the journal append and reply for a processed request as linked SQEs
+static int uring_queue_reply(UringServer *us, const Message *msg) {
+    int slot_idx = -1;
+    for (int i = 0; i < URING_SLOTS; i++) {
+        if (!us->slots[i].busy) {
+            slot_idx = i;
+            break;
+        }
+    }
+    if (slot_idx == -1) {
+        uring_reply_sync(msg);
+        return -1;
+    }
+
+    UringSlot *slot = &us->slots[slot_idx];
+    memcpy(&slot->reply, msg, sizeof(Message));
+    client_fifo_name(slot->fifo, msg->client_pid);
+    slot->pending = 0;
+
+    // Successful requests are journaled first so a reply never gets ahead of the log
+    uint32_t id = msg->account_id;
+    int journal_len = 0;
+    if (msg->status == 0 && id >= 1 && id < MAX_ACCOUNTS) {
+        journal_len = snprintf(slot->journal, sizeof(slot->journal), "%s D %lld W 0 %lld\n",
+                               bank.id[id],
+                               (long long)bank.balance[id],
+                               (long long)bank.balance[id]);
+    }
+
+    // The linked chain has to go in whole: flush what is queued to make room,
+    // and reply synchronously if the kernel still has not consumed enough
+    unsigned need = journal_len > 0 ? 4 : 3;
+    if (uring_sq_space(&us->ring) < need) {
+        uring_submit(&us->ring);
+    }
+    if (uring_sq_space(&us->ring) < need) {
+        uring_reply_sync(msg);
+        return -1;
+    }
+
+    struct io_uring_sqe *sqe;
+    if (journal_len > 0) {
+        sqe = uring_get_sqe(&us->ring);
+        uring_prep_write(sqe, us->journal_fd, slot->journal, journal_len, us->journal_off);
+        sqe->flags |= IOSQE_IO_LINK;
+        sqe->user_data = URING_UD(slot_idx, UD_JOURNAL);
+        us->journal_off += journal_len;
+        slot->pending++;
+    }
+
+    sqe = uring_get_sqe(&us->ring);
+    uring_prep_openat_direct(sqe, slot->fifo, O_WRONLY, slot_idx);
+    // The inline attempt opens non-blocking, which fails a FIFO with ENXIO
+    // until the client starts reading; IOSQE_ASYNC waits in a worker instead
+    sqe->flags |= IOSQE_IO_LINK | IOSQE_ASYNC;
+    sqe->user_data = URING_UD(slot_idx, UD_OPEN);
+
+    sqe = uring_get_sqe(&us->ring);
+    uring_prep_write(sqe, slot_idx, &slot->reply, sizeof(Message), 0);
+    sqe->flags |= IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+    sqe->user_data = URING_UD(slot_idx, UD_REPLY);
+
+    sqe = uring_get_sqe(&us->ring);
+    uring_prep_close_direct(sqe, slot_idx);
+    sqe->user_data = URING_UD(slot_idx, UD_CLOSE);
+
+    slot->pending += 3;
+    slot->busy = 1;
+    us->busy_slots++;
+    return 0;
+}
+
+// Apply complete messages while reply slots are available
+static void uring_dispatch(UringServer *us) {
+    Message msg;
+
+    // One frame at a time: a group boundary stops dispatch until compaction
+    while (!us->compact_pending && us->busy_slots < URING_SLOTS &&
+           frame_reader_next_batch(&us->reader, &msg, 1) == 1) {
+        us->last_message = time(NULL);
+
+        DEBUG_PRINT("Received message from client PID %d\n", msg.client_pid);
+
+        if (check_wire_version(&msg) == -1) {
+            continue;
+        }
+
+        if (msg.type == MSG_HELLO) {
+            us->client_group = msg.client_pid;
+            printf(" - Received %d clients from PID%d..\n", msg.amount, us->client_group);
+            us->client_count = msg.amount;
+            continue;
+        }
+
+        int returning = msg.type != MSG_BATCH && msg.account_id != ACCOUNT_NONE &&
+                        find_account_by_id(msg.account_id) != -1;
+
+        if (msg.type == MSG_DEPOSIT) {
+            handle_deposit(&msg);
+        } else if (msg.type == MSG_WITHDRAW) {
+            handle_withdraw(&msg);
+        } else if (msg.type == MSG_BATCH) {
+            handle_batch(&msg);
+        }
+
+        if (returning) {
+            printf(" -- Ring slot serving Client%d...Welcome back Client%d\n",
+                   msg.client_pid, msg.client_pid);
+        } else {
+            printf(" -- Ring slot serving Client%d...\n", msg.client_pid);
+        }
+
+        uring_queue_reply(us, &msg);
+        us->requests++;
+
+        if (us->client_count > 0 && --us->client_count == 0) {
+            DEBUG_PRINT("All clients from group %d processed\n", us->client_group);
+            us->compact_pending = 1;
+        }
+    }
+}
+
+// Handle one completion from the ring
+static void uring_complete(UringServer *us, struct io_uring_cqe *cqe) {
+    int kind = (int)(cqe->user_data & 0xff);
+    int slot_idx = (int)(cqe->user_data >> 8);
+
+    if (kind == UD_READ) {
+        if (cqe->res > 0) {
+            if (cqe->flags & IORING_CQE_F_BUFFER) {
+                unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+                if (frame_reader_feed(&us->reader, us->bufs.data + (size_t)bid * us->bufs.buf_size,
+                                      (size_t)cqe->res) == -1) {
+                    perror("Failed to buffer server FIFO data");
+                }
+                uring_buf_ring_recycle(&us->bufs, bid);
+            } else {
+                if (frame_reader_feed(&us->reader, us->read_buf, (size_t)cqe->res) == -1) {
+                    perror("Failed to buffer server FIFO data");
+                }
+            }
+        } else if (cqe->res == -EINVAL && us->multishot) {
+            // Kernel predates multishot reads, fall back to one read per wakeup
+            DEBUG_PRINT("Multishot read unsupported, using plain reads\n");
+            us->multishot = 0;
+        } else if (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -EINTR) {
+            fprintf(stderr, "Read from server FIFO failed: %s\n", strerror(-cqe->res));
+            running = 0;
+            return;
+        }
+
+        // A multishot read stays armed until the kernel clears F_MORE
+        if (!us->multishot || !(cqe->flags & IORING_CQE_F_MORE)) {
+            uring_arm_read(us);
+        }
+        return;
+    }
+
+    UringSlot *slot = &us->slots[slot_idx];
+    if (cqe->res < 0 && cqe->res != -ECANCELED) {
+        const char *what = kind == UD_JOURNAL ? "journal append" :
+                           kind == UD_OPEN ? "open client FIFO" :
+                           kind == UD_REPLY ? "reply" : "close client FIFO";
+        fprintf(stderr, "io_uring %s failed for Client%d: %s\n",
+                what, slot->reply.client_pid, strerror(-cqe->res));
+    }
+
+    if (--slot->pending == 0) {
+        slot->busy = 0;
+        us->busy_slots--;
+    }
+}
+
+// Reap every completion that is ready without blocking
+static void uring_reap(UringServer *us) {
+    struct io_uring_cqe *cqe;
+    while ((cqe = uring_peek_cqe(&us->ring)) != NULL) {
+        uring_complete(us, cqe);
+        uring_cqe_seen(&us->ring);
+    }
+}
+
+// Rewrite the log as a snapshot once every journaled reply has landed
+static void uring_compact(UringServer *us) {
+    save_bank_log();
+
+    struct stat st;
+    if (fstat(us->journal_fd, &st) == 0) {
+        us->journal_off = st.st_size;
+    }
+    us->compact_pending = 0;
+}
+
+// Serve client groups through io_uring: reads, journal appends and replies
+// are all submitted and reaped in batches by a single io_uring_enter.
+int serve_uring() {
+    UringServer *us = &uring_server;
+    memset(us, 0, sizeof(*us));
+
+    int ret = uring_init(&us->ring, URING_ENTRIES);
+    if (ret < 0) {
+        fprintf(stderr, "io_uring setup failed: %s\n", strerror(-ret));
+        return -1;
+    }
+
+    ret = uring_register_sparse_files(&us->ring, URING_SLOTS);
+    if (ret < 0) {
+        fprintf(stderr, "io_uring file registration failed: %s\n", strerror(-ret));
+        uring_exit(&us->ring);
+        return -1;
+    }
+
+    if (frame_reader_init(&us->reader, FRAME_RING_SIZE, sizeof(Message)) == -1) {
+        perror("Failed to allocate server FIFO buffer");
+        uring_exit(&us->ring);
+        return -1;
+    }
+
+    // O_RDWR keeps a writer on the FIFO so we never see EOF between groups
+    us->server_fd = open(server_fifo, O_RDWR);
+    if (us->server_fd == -1) {
+        perror("Failed to open server FIFO");
+        frame_reader_free(&us->reader);
+        uring_exit(&us->ring);
+        return -1;
+    }
+
+    us->journal_fd = open(LOG_FILE, O_WRONLY | O_CREAT, 0644);
+    if (us->journal_fd == -1) {
+        perror("Failed to open log file");
+        close(us->server_fd);
+        frame_reader_free(&us->reader);
+        uring_exit(&us->ring);
+        return -1;
+    }
+    us->journal_off = lseek(us->journal_fd, 0, SEEK_END);
+
+    us->multishot = uring_buf_ring_setup(&us->ring, &us->bufs, URING_READ_BUFS,
+                                         URING_READ_BUF_SIZE, URING_BGID) == 0;
+    uring_arm_read(us);
+
+    printf("Waiting for clients @%s... (io_uring)\n", server_fifo);
+
+    while (running) {
+        ret = uring_submit_and_wait(&us->ring, 1, URING_WAIT_MS);
+        if (ret < 0 && ret != -ETIME && ret != -EINTR) {
+            fprintf(stderr, "io_uring_enter failed: %s\n", strerror(-ret));
+            break;
+        }
+
+        uring_reap(us);
+        uring_dispatch(us);
+        service_batch(0);
+        service_live_report();
+
+        // Same 5 second group timeout as the select() based path
+        if (us->client_count > 0 && frame_reader_frames(&us->reader) == 0 &&
+            time(NULL) - us->last_message >= URING_GROUP_TIMEOUT) {
+            DEBUG_PRINT("Timeout waiting for more clients from group %d\n", us->client_group);
+            us->client_count = 0;
+            us->compact_pending = 1;
+        }
+
+        if (us->compact_pending && us->busy_slots == 0) {
+            uring_compact(us);
+            printf("Waiting for clients @%s... (io_uring)\n", server_fifo);
+            uring_dispatch(us);
+        }
+    }
+
+    // Let replies that are already queued reach their clients
+    time_t deadline = time(NULL) + URING_GROUP_TIMEOUT;
+    while (us->busy_slots > 0 && time(NULL) < deadline) {
+        uring_submit_and_wait(&us->ring, 1, URING_WAIT_MS);
+        uring_reap(us);
+    }
+
+    if (us->requests > 0) {
+        printf("io_uring: %lu requests, %lu io_uring_enter calls (%.2f syscalls/request)\n",
+               us->requests, us->ring.enter_calls,
+               (double)us->ring.enter_calls / (double)us->requests);
+    }
+
+    uring_buf_ring_free(&us->ring, &us->bufs);
+    uring_exit(&us->ring);
+    close(us->journal_fd);
+    close(us->server_fd);
+    frame_reader_free(&us->reader);
+    return 0;
+}
+
+// Initialize the bank and load from log if exists
+void initialize_bank() {
+    // Initialize all accounts as inactive
+    memset(bank.active, 0, sizeof(bank.active));
+    memset(bank.balance, 0, sizeof(bank.balance));
+
+    // Try to load from log file
+    FILE *log = fopen(LOG_FILE, "r");
+    if (log == NULL) {
+        printf("No previous logs.. Creating the bank database\n");
+        return;
+    }
+
+    char line[MAX_BUFFER];
+    while (fgets(line, MAX_BUFFER, log)) {
+        // Skip comments and empty lines
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        
+        // Journaled batch: applies to every account loaded so far
+        // Format: @BATCH 3 interest 150
+        if (line[0] == '@') {
+            unsigned int epoch;
+            char job[20];
+            long long param;
+            if (sscanf(line, "@BATCH %u %19s %lld", &epoch, job, &param) == 3 &&
+                batch_job_parse(job) != BATCH_NONE) {
+                for (int w = 0; w < ACCOUNT_WORDS; w++) {
+                    accounts_apply_job(&bank, w, bank.active[w], batch_job_parse(job), param);
+                }
+                if (epoch > batch_epoch) {
+                    batch_epoch = epoch;
+                }
+            }
+            continue;
+        }
+        
+        char account_id[20];
+        long long balance;
+        
+        // Parse line for account information
+        // Format: BankID_XX D 300 W 300 0
+        if (sscanf(line, "%s", account_id) == 1) {
+            char *token = strtok(line + strlen(account_id), " ");
+            balance = 0;
+            
+            // Find the last number on the line (final balance)
+            while (token != NULL) {
+                if (sscanf(token, "%lld", &balance) == 1) {
+                    // This will keep overwriting until we get the last number
+                }
+                token = strtok(NULL, " ");
+            }
+            
+            // Text IDs are converted once here, at the edge
+            int64_t id_num = account_id_parse(account_id);
+            if (id_num < 1 || id_num >= MAX_ACCOUNTS) {
+                continue;
+            }
+            
+            if (balance > 0) {
+                int idx = find_account_by_id((uint32_t)id_num);
+                if (idx == -1) {
+                    // New account
+                    if (id_num >= next_account_id) {
+                        next_account_id = (int)id_num + 1;
+                    }
+                    
+                    idx = (int)id_num;
+                    strcpy(bank.id[idx], account_id);
+                }
+                bank.balance[idx] = balance;
+                account_set_active(&bank, (uint32_t)idx);
+            } else {
+                // Journaled close (final balance 0) of a known account
+                int idx = find_account_by_id((uint32_t)id_num);
+                if (idx != -1) {
+                    account_clear_active(&bank, (uint32_t)idx);
+                }
+            }
+        }
+    }
+    
+    fclose(log);
+    
+    ledger_total = accounts_total_balance(&bank);
+}
+
+// Save bank log
+void save_bank_log() {
+    FILE *log = fopen(LOG_FILE, "w");
+    if (!log) {
+        perror("Failed to open log file");
+        return;
+    }
+    
+    // Get current time
+    time_t now = time(NULL);
+    struct tm *tm_info = localtime(&now);
+    char time_str[50];
+    strftime(time_str, sizeof(time_str), "%H:%M %B %d %Y", tm_info);
+    
+    fprintf(log, "# Adabank Log file updated @%s \n", time_str);
+    
+    // Write active accounts, walking only the set bits of the bitmap.
+    // Balances come out as a running batch will leave them, so the
+    // snapshot never needs the batch's journal record.
+    int64_t balances[64];
+    for (int w = 0; w < ACCOUNT_WORDS; w++) {
+        uint64_t bits = bank.active[w];
+        if (bits) {
+            batch_word_balances(&batch, &bank, w, balances);
+        }
+        while (bits) {
+            int bit = __builtin_ctzll(bits);
+            int i = w * 64 + bit;
+            fprintf(log, "%s D %lld W 0 %lld\n", 
+                   bank.id[i], 
+                   (long long)balances[bit], 
+                   (long long)balances[bit]);
+            bits &= bits - 1;
+        }
+    }
+    
+    fprintf(log, "## end of log. \n");
+    fclose(log);
+    
+    DEBUG_PRINT("Log file saved with %d active accounts\n", accounts_active_count(&bank));
+}
+
+// Signal handler
+void signal_handler(int sig) {
+    (void)sig; // Prevent unused parameter warning
+    printf("Signal received closing active Tellers\n");
+    running = 0;
+}
+
+// SIGUSR1: ask for a live report
+void report_signal_handler(int sig) {
+    (void)sig; // Prevent unused parameter warning
+    report_requested = 1;
+}
+
+// Start a requested report and collect the previous one. The reporter is a
+// fork, so it scans a copy-on-write snapshot while the server keeps serving.
+void service_live_report() {
+    if (report_pid > 0 && waitpid(report_pid, NULL, WNOHANG) != 0) {
+        report_pid = 0;
+    }
+    
+    // Totals only reconcile between batches, so a report waits for the batch
+    if (!report_requested || batch.active) {
+        return;
+    }
+    report_requested = 0;
+    
+    if (report_pid > 0) {
+        printf(" - Report already running (PID %d)\n", report_pid);
+        return;
+    }
+    
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork failed");
+        return;
+    }
+    if (pid == 0) {
+        write_report();
+        _exit(EXIT_SUCCESS);
+    }
+    report_pid = pid;
+}
+
+// Reconciliation, active count and balance histogram from the bulk kernels
+void write_report() {
+    AccountReport report;
+    accounts_report(&bank, &report);
+    
+    FILE *out = fopen(REPORT_FILE, "w");
+    if (!out) {
+        perror("Failed to open report file");
+        return;
+    }
+    
+    time_t now = time(NULL);
+    struct tm *tm_info = localtime(&now);
+    char time_str[50];
+    strftime(time_str, sizeof(time_str), "%H:%M:%S %B %d %Y", tm_info);
+    
+    fprintf(out, "# Adabank report @%s\n", time_str);
+    fprintf(out, "active accounts: %d\n", report.active_count);
+    fprintf(out, "total deposits: %lld\n", (long long)report.total_balance);
+    fprintf(out, "ledger total: %lld (%s)\n", (long long)ledger_total,
+            report.total_balance == ledger_total ? "reconciled" : "MISMATCH");
+    fprintf(out, "balance histogram:\n");
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        if (report.histogram[b] == 0) {
+            continue;
+        }
+        long long low = b == 0 ? 0 : 1LL << (b - 1);
+        if (b == 0) {
+            fprintf(out, "  [0]: %llu\n", (unsigned long long)report.histogram[b]);
+        } else if (b == HISTOGRAM_BUCKETS - 1) {
+            fprintf(out, "  [%lld, ...): %llu\n", low, (unsigned long long)report.histogram[b]);
+        } else {
+            fprintf(out, "  [%lld, %lld): %llu\n", low, low << 1,
+                    (unsigned long long)report.histogram[b]);
+        }
+    }
+    fclose(out);
+    
+    printf(" - Report: %d active accounts, %lld credits (%s), written to %s\n",
+           report.active_count, (long long)report.total_balance,
+           report.total_balance == ledger_total ? "reconciled" : "MISMATCH", REPORT_FILE);
+    fflush(stdout);
+}
+
+// Find account by ID
+int find_account_by_id(uint32_t account_id) {
+    if (account_id < 1 || account_id >= MAX_ACCOUNTS || !account_is_active(&bank, account_id)) {
+        return -1;  // Not found or inactive
+    }
+    
+    return (int)account_id;
+}
+
+// Reject messages from clients speaking another wire format version
+int check_wire_version(const Message *msg) {
+    if (msg->version != WIRE_VERSION) {
+        fprintf(stderr, "Dropping message with wire version %d (expected %d)\n",
+                msg->version, WIRE_VERSION);
+        return -1;
+    }
+    return 0;
+}
+
+// Create a new account
+int create_new_account() {
+    int id = next_account_id++;
+    batch_touch(&batch, (uint32_t)id);
+    account_id_format(bank.id[id], ACCOUNT_ID_LEN, (uint32_t)id);
+    bank.balance[id] = 0;
+    account_set_active(&bank, (uint32_t)id);
+    return id;
+}
+
+// Handle deposit request
+void handle_deposit(Message *msg) {
+    int account_idx;
+    
+    if (msg->account_id == ACCOUNT_NONE) {
+        // New client
+        account_idx = create_new_account();
+        DEBUG_PRINT("Created new account: %s\n", bank.id[account_idx]);
+    } else {
+        // Existing client
+        account_idx = find_account_by_id(msg->account_id);
+        if (account_idx == -1) {
+            DEBUG_PRINT("Account not found: %u\n", msg->account_id);
+            msg->status = -1;  // Account not found
+            return;
+        }
+        batch_touch(&batch, (uint32_t)account_idx);
+        DEBUG_PRINT("Found existing account: %s with balance %lld\n", 
+                   bank.id[account_idx], (long long)bank.balance[account_idx]);
+    }
+    
+    // Update balance
+    bank.balance[account_idx] += msg->amount;
+    ledger_total += msg->amount;
+    DEBUG_PRINT("Updated balance for %s to %lld\n", 
+               bank.id[account_idx], (long long)bank.balance[account_idx]);
+    
+    // Update message
+    msg->account_id = (uint32_t)account_idx;
+    msg->balance = bank.balance[account_idx];
+    msg->status = 0;  // Success
+    
+    printf("Client%d deposited %d credits... updating log\n", msg->client_pid, msg->amount);
+
+    // The io_uring engine journals the account from its completion loop
+    if (io_engine == IO_POSIX) {
+        save_bank_log();
+    }
+}
+
+// Handle withdraw request
+void handle_withdraw(Message *msg) {
+    int account_idx = find_account_by_id(msg->account_id);
+    
+    if (account_idx == -1) {
+        DEBUG_PRINT("Account not found for withdrawal: %u\n", msg->account_id);
+        msg->status = -1;  // Account not found
+        return;
+    }
+    batch_touch(&batch, (uint32_t)account_idx);
+    
+    DEBUG_PRINT("Withdrawal from account %s with balance %lld, amount %d\n", 
+               bank.id[account_idx], (long long)bank.balance[account_idx], msg->amount);
+    
+    if (bank.balance[account_idx] < msg->amount) {
+        printf("Client%d withdraws %d credit.. operation not permitted. \n", 
+               msg->client_pid, msg->amount);
+        DEBUG_PRINT("Insufficient funds: balance %lld, requested %d\n", 
+                   (long long)bank.balance[account_idx], msg->amount);
+        msg->status = -2;  // Insufficient funds
+        return;
+    }
+    
+    // Update balance
+    bank.balance[account_idx] -= msg->amount;
+    ledger_total -= msg->amount;
+    DEBUG_PRINT("New balance after withdrawal: %lld\n", (long long)bank.balance[account_idx]);
+    
+    // Check if account should be closed
+    if (bank.balance[account_idx] == 0) {
+        account_clear_active(&bank, (uint32_t)account_idx);
+        printf("Client%d withdraws %d credits... updating log... Bye Client%d\n", 
+               msg->client_pid, msg->amount, msg->client_pid);
+        DEBUG_PRINT("Account closed: %s\n", bank.id[account_idx]);
+    } else {
+        printf("Client%d withdraws %d credits... updating log\n", 
+               msg->client_pid, msg->amount);
+    }
+    
+    // Update message
+    msg->balance = bank.balance[account_idx];
+    msg->status = 0;  // Success
+    if (io_engine == IO_POSIX) {
+        save_bank_log();
+    }
+}
+
+// Append one record to the log: through the journal offset on the io_uring
+// engine, at the end of the last snapshot otherwise
+int journal_record(const char *line, int len) {
+    if (io_engine == IO_URING) {
+        UringServer *us = &uring_server;
+        if (pwrite(us->journal_fd, line, (size_t)len, us->journal_off) != len) {
+            perror("Failed to journal record");
+            return -1;
+        }
+        us->journal_off += len;
+        return 0;
+    }
+    
+    int fd = open(LOG_FILE, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd == -1) {
+        perror("Failed to open log file");
+        return -1;
+    }
+    int ok = write(fd, line, (size_t)len) == len;
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+// Handle batch request: journal it as one record, then transform the epoch
+// on worker threads while clients keep being served
+void handle_batch(Message *msg) {
+    if (batch.active) {
+        printf("Client%d asks for a %s batch.. epoch %u still running\n",
+               msg->client_pid, batch_job_name(msg->job), batch.epoch);
+        msg->status = -3;  // Batch busy
+        return;
+    }
+    
+    if (msg->job < BATCH_INTEREST || msg->job > BATCH_FLOOR || msg->amount <= 0) {
+        DEBUG_PRINT("Invalid batch job %d with parameter %d\n", msg->job, msg->amount);
+        msg->status = -1;
+        return;
+    }
+    
+    char record[MAX_BUFFER];
+    uint32_t epoch = batch_epoch + 1;
+    int len = snprintf(record, sizeof(record), "@BATCH %u %s %d\n",
+                       epoch, batch_job_name(msg->job), msg->amount);
+    if (journal_record(record, len) == -1) {
+        msg->status = -1;
+        return;
+    }
+    
+    batch_epoch = epoch;
+    batch_start(&batch, &bank, msg->job, msg->amount, epoch);
+    
+    printf("Client%d started batch epoch %u: %s %d over %d accounts\n",
+           msg->client_pid, epoch, batch_job_name(msg->job), msg->amount, batch.total);
+    
+    msg->balance = batch.total;
+    msg->status = 0;  // Success
+}
+
+// Collect a finished batch (or wait for it) and fold it into the ledger
+void service_batch(int wait) {
+    if (!batch.active || (!wait && !batch_done(&batch))) {
+        return;
+    }
+    
+    BatchStats stats;
+    batch_finish(&batch, &stats);
+    ledger_total += stats.delta;
+    
+    printf(" - Batch epoch %u (%s %lld) done: %d accounts, %+lld credits in %.3f ms (%.0f accounts/s)\n",
+           stats.epoch, batch_job_name(stats.kind), (long long)stats.param,
+           stats.accounts, (long long)stats.delta, stats.seconds * 1000.0,
+           stats.seconds > 0 ? (double)stats.accounts / stats.seconds : 0.0);
+}
+
+// Create teller process (basic implementation using fork)
+void create_teller_basic(pid_t client_pid) {
+    // Find the client's message
+    Message teller_msg;
+    memset(&teller_msg, 0, sizeof(Message));
+    teller_msg.client_pid = client_pid;
+    teller_msg.status = -1; // Default to error
+    
+    // Process the most recent message from this client
+    for (int i = 0; i < current_message_count; i++) {
+        if (current_messages[i].client_pid == client_pid) {
+            memcpy(&teller_msg, &current_messages[i], sizeof(Message));
+            DEBUG_PRINT("Found message for client %d: type %d, account %u, amount %d\n",
+                      client_pid, teller_msg.type, teller_msg.account_id, teller_msg.amount);
+            break;
+        }
+    }
+    
+    pid_t pid = fork();
+    
+    if (pid < 0) {
+        perror("Fork failed");
+        return;
+    }
+    
+    if (pid == 0) {
+        // Child process (Teller)
+        char client_fifo[MAX_BUFFER];
+        client_fifo_name(client_fifo, client_pid);
+        
+        DEBUG_PRINT("Teller for Client%d: Looking for client FIFO: %s\n", client_pid, client_fifo);
+        
+        // Wait for client FIFO to be created
+        struct stat st;
+        int retry = 0;
+        while (stat(client_fifo, &st) == -1) {
+            usleep(100000);  // 100ms
+            if (++retry > 50) {  // 5 second timeout
+                fprintf(stderr, "Teller: Client FIFO %s not found after timeout\n", client_fifo);
+                exit(EXIT_FAILURE);
+            }
+        }
+        
+        DEBUG_PRINT("Teller for Client%d: Found client FIFO\n", client_pid);
+        
+        // Open client FIFO for writing
+        DEBUG_PRINT("Teller for Client%d: Opening client FIFO for writing: %s\n", client_pid, client_fifo);
+        int client_fd = open(client_fifo, O_WRONLY);
+        if (client_fd == -1) {
+            perror("Failed to open client FIFO for writing");
+            exit(EXIT_FAILURE);
+        }
+        
+        // Check if this is a returning client
+        if (teller_msg.account_id != ACCOUNT_NONE && 
+            find_account_by_id(teller_msg.account_id) != -1) {
+            printf(" -- Teller %d is active serving Client%d...Welcome back Client%d\n", 
+                   getpid(), client_pid, client_pid);
+        } else {
+            printf(" -- Teller %d is active serving Client%d...\n", getpid(), client_pid);
+        }
+        
+        // Send response back to client
+        DEBUG_PRINT("Teller for Client%d: Sending response with status %d, account %u\n", 
+                  client_pid, teller_msg.status, teller_msg.account_id);
+        
+        if (write(client_fd, &teller_msg, sizeof(Message)) != sizeof(Message)) {
+            perror("Failed to write response to client");
+        }
+        
+        DEBUG_PRINT("Teller %d: Closing connection with Client%d\n", getpid(), client_pid);
+        close(client_fd);
+        exit(EXIT_SUCCESS);
+    }
+    
+    // Parent continues
+}
+
+// Custom teller creation function (enhanced implementation)
+pid_t Teller(void* func, void* arg_func) {
+    // Create shared memory
+    SharedMemory *shm = mmap(NULL, sizeof(SharedMemory), 
+                            PROT_READ | PROT_WRITE, 
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    
+    if (shm == MAP_FAILED) {
+        perror("mmap failed");
+        return -1;
+    }
+    
+    // Initialize semaphores
+    sem_init(&shm->request_sem, 1, 0);
+    sem_init(&shm->response_sem, 1, 0);
+    
+    // Store shared memory pointer
+    shared_mems[next_shared_mem++] = shm;
+    
+    pid_t pid = fork();
+    
+    if (pid < 0) {
+        perror("Fork failed");
+        munmap(shm, sizeof(SharedMemory));
+        return -1;
+    }
+    
+    if (pid == 0) {
+        // Child process (Teller)
+        // Cast and call the function
+        void (*teller_func)(void*) = func;
+        teller_func(arg_func);
+        exit(EXIT_SUCCESS);
+    }
+    
+    return pid;
+}
+
+// Custom wait function for Teller
+int waitTeller(pid_t pid, int* status) {
+    return waitpid(pid, status, 0);
+}
+
+// Deposit function for Teller
+void deposit(void* arg) {
+    Message *msg = (Message*)arg;
+    DEBUG_PRINT("Enhanced deposit: account %u, amount %d\n", msg->account_id, msg->amount);
+    
+    // Copy to shared memory
+    SharedMemory *shm = shared_mems[next_shared_mem - 1];
+    memcpy(&shm->request, msg, sizeof(Message));
+    
+    // Signal request is ready
+    sem_post(&shm->request_sem);
+    
+    // Wait for response
+    sem_wait(&shm->response_sem);
+    
+    // Copy response back
+    memcpy(msg, &shm->response, sizeof(Message));
+    DEBUG_PRINT("Enhanced deposit completed: status %d, account %u\n", msg->status, msg->account_id);
+}
+
+// Withdraw function for Teller
+void withdraw(void* arg) {
+    Message *msg = (Message*)arg;
+    DEBUG_PRINT("Enhanced withdraw: account %u, amount %d\n", msg->account_id, msg->amount);
+    
+    // Copy to shared memory
+    SharedMemory *shm = shared_mems[next_shared_mem - 1];
+    memcpy(&shm->request, msg, sizeof(Message));
+    
+    // Signal request is ready
+    sem_post(&shm->request_sem);
+    
+    // Wait for response
+    sem_wait(&shm->response_sem);
+    
+    // Copy response back
+    memcpy(msg, &shm->response, sizeof(Message));
+    DEBUG_PRINT("Enhanced withdraw completed: status %d, account %u\n", msg->status, msg->account_id);
+}
+
+// Create teller process (enhanced implementation)
+void create_teller_enhanced(pid_t client_pid) {
+    // Find the client's message
+    Message teller_msg;
+    memset(&teller_msg, 0, sizeof(Message));
+    teller_msg.client_pid = client_pid;
+    teller_msg.status = -1; // Default to error
+    
+    // Process the most recent message from this client
+    for (int i = 0; i < current_message_count; i++) {
+        if (current_messages[i].client_pid == client_pid) {
+            memcpy(&teller_msg, &current_messages[i], sizeof(Message));
+            DEBUG_PRINT("Enhanced: Found message for client %d: type %d, account %u, amount %d\n",
+                      client_pid, teller_msg.type, teller_msg.account_id, teller_msg.amount);
+            break;
+        }
+    }
+    
+    // Wait for client FIFO to be created
+    char client_fifo[MAX_BUFFER];
+    client_fifo_name(client_fifo, client_pid);
+    
+    DEBUG_PRINT("Enhanced teller for Client%d: Looking for client FIFO: %s\n", client_pid, client_fifo);
+    
+    struct stat st;
+    int retry = 0;
+    while (stat(client_fifo, &st) == -1) {
+        usleep(100000);  // 100ms
+        if (++retry > 50) {  // 5 second timeout
+            fprintf(stderr, "Enhanced Teller: Client FIFO %s not found after timeout\n", client_fifo);
+            return;
+        }
+    }
+    
+    DEBUG_PRINT("Enhanced teller for Client%d: Found client FIFO\n", client_pid);
+    
+    // Open client FIFO once the client is reading it; a reply written to a
+    // FIFO with no reader is dropped when we close it
+    int client_fd;
+    retry = 0;
+    while ((client_fd = open(client_fifo, O_WRONLY | O_NONBLOCK)) == -1 && errno == ENXIO) {
+        usleep(100000);  // 100ms
+        if (++retry > 50) {  // 5 second timeout
+            break;
+        }
+    }
+    if (client_fd == -1) {
+        perror("Failed to open client FIFO");
+        return;
+    }
+    
+    // Create appropriate teller
+    pid_t teller_pid;
+    if (teller_msg.type == MSG_DEPOSIT) {
+        teller_pid = Teller(deposit, &teller_msg);
+    } else {
+        teller_pid = Teller(withdraw, &teller_msg);
+    }
+    
+    printf(" -- Teller %d is active serving Client%d...\n", teller_pid, client_pid);
+    
+    // Wait for teller to process request
+    SharedMemory *shm = shared_mems[next_shared_mem - 1];
+    
+    // Wait for request to be ready
+    sem_wait(&shm->request_sem);
+    
+    // Process request
+    if (shm->request.type == MSG_DEPOSIT) {
+        handle_deposit(&shm->request);
+    } else if (shm->request.type == MSG_WITHDRAW) {
+        handle_withdraw(&shm->request);
+    }
+    
+    // Copy response
+    memcpy(&shm->response, &shm->request, sizeof(Message));
+    
+    // Signal response is ready
+    sem_post(&shm->response_sem);
+    
+    // Wait for teller to complete
+    int status;
+    waitTeller(teller_pid, &status);
+    
+    // Send response to client
+    write(client_fd, &teller_msg, sizeof(Message));
+    
+    close(client_fd);
+    
+    // Clean up shared memory
+    sem_destroy(&shm->request_sem);
+    sem_destroy(&shm->response_sem);
+    munmap(shm, sizeof(SharedMemory));
 }
\ No newline at end of file
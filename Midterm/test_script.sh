@@ -70,11 +70,33 @@ ALARM_PID=$!
 kill $ALARM_PID 2>/dev/null || true
 echo "Client02 completed."
 
+# Give some time for server to process
+sleep 2
+
+# Run the end-of-day batch client file with a timeout
+echo "Running Client04.file..."
+# Set a 30 second alarm
+(sleep 30; kill -ALRM $) &
+ALARM_PID=$!
+./BankClient Client04.file $SERVER_FIFO
+# Cancel the alarm
+kill $ALARM_PID 2>/dev/null || true
+echo "Client04 completed."
+sleep 1
+
 # Display log file
 echo "Bank log after basic server test:"
 cat AdaBank.bankLog
 echo
 
+# Ask the running server for a live report
+echo "Requesting live report..."
+kill -USR1 $SERVER_PID
+sleep 1
+cat AdaBank.report
+rm -f AdaBank.report
+echo
+
 # Stop the server
 echo "Stopping the basic server..."
 kill -TERM $SERVER_PID
@@ -83,6 +105,42 @@ sleep 2
 rm -f $SERVER_FIFO
 rm -f client_*_fifo
 
+echo "===== Testing io_uring Server ====="
+
+# Start the basic server on the io_uring engine with a clear log file
+rm -f AdaBank.bankLog
+./BankServer AdaBank $SERVER_FIFO uring &
+SERVER_PID=$!
+
+# Wait for server to initialize
+sleep 2
+
+# Run the first client file again, now served through io_uring
+echo "Running Client01.file (io_uring)..."
+# Set a 30 second alarm
+(sleep 30; kill -ALRM $) &
+ALARM_PID=$!
+./BankClient Client01.file $SERVER_FIFO
+# Cancel the alarm
+kill $ALARM_PID 2>/dev/null || true
+echo "Client01 (io_uring) completed."
+
+# Give some time for server to process
+sleep 2
+
+# Display log file
+echo "Bank log after io_uring server test:"
+cat AdaBank.bankLog
+echo
+
+# Stop the server
+echo "Stopping the io_uring server..."
+kill -TERM $SERVER_PID
+wait $SERVER_PID 2>/dev/null || true
+sleep 2
+rm -f $SERVER_FIFO
+rm -f client_*_fifo
+
 echo "===== Testing Enhanced Server ====="
 
 # Start the enhanced server with a clear log file
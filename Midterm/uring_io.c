@@ -0,0 +1,344 @@
+/**
+ * uring_io.c - Minimal io_uring wrapper used by the Bank Server
+ */
+
+#include "uring_io.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// Raw system call wrappers
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags, void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, arg, argsz);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg,
+                                 unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// Set up the rings and map them into our address space
+int uring_init(Uring *ring, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->ring_fd = sys_io_uring_setup(entries, &p);
+    if (ring->ring_fd < 0) {
+        return -errno;
+    }
+    ring->features = p.features;
+
+    ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) {
+            ring->sq_size = ring->cq_size;
+        }
+        ring->cq_size = ring->sq_size;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                        IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        int err = -errno;
+        close(ring->ring_fd);
+        return err;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                            IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            int err = -errno;
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(ring->ring_fd);
+            return err;
+        }
+    }
+
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                      IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        int err = -errno;
+        if (ring->cq_ptr != ring->sq_ptr) {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->ring_fd);
+        return err;
+    }
+
+    char *sq = ring->sq_ptr;
+    ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+    ring->sq_entries = p.sq_entries;
+    ring->sqe_tail = *ring->sq_tail;
+
+    char *cq = ring->cq_ptr;
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    return 0;
+}
+
+// Unmap the rings and close the ring descriptor
+void uring_exit(Uring *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->ring_fd);
+    ring->ring_fd = -1;
+}
+
+// Hand out the next free SQE, or NULL if the submission queue is full
+struct io_uring_sqe *uring_get_sqe(Uring *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sqe_tail - head >= ring->sq_entries) {
+        return NULL;
+    }
+
+    unsigned idx = ring->sqe_tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[idx] = idx;
+    ring->sqe_tail++;
+    return sqe;
+}
+
+// Free entries left in the submission queue
+unsigned uring_sq_space(Uring *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    return ring->sq_entries - (ring->sqe_tail - head);
+}
+
+// Publish pending SQEs to the kernel, returns how many were published
+static unsigned uring_flush_sq(Uring *ring) {
+    unsigned tail = *ring->sq_tail;
+    unsigned pending = ring->sqe_tail - tail;
+    if (pending) {
+        __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+    }
+    return ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+// Submit everything queued without waiting for completions
+int uring_submit(Uring *ring) {
+    return uring_submit_and_wait(ring, 0, 0);
+}
+
+// Submit queued SQEs and wait for at least wait_nr completions.
+// A positive timeout_ms bounds the wait; -ETIME is returned when it expires.
+int uring_submit_and_wait(Uring *ring, unsigned wait_nr, int timeout_ms) {
+    unsigned to_submit = uring_flush_sq(ring);
+    unsigned flags = 0;
+    void *arg = NULL;
+    size_t argsz = 0;
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg ext;
+
+    if (wait_nr > 0) {
+        // Completions already in the CQ satisfy the wait without blocking
+        unsigned ready = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE) -
+                         *ring->cq_head;
+        if (ready >= wait_nr) {
+            wait_nr = 0;
+        } else {
+            flags |= IORING_ENTER_GETEVENTS;
+        }
+    }
+
+    if (to_submit == 0 && wait_nr == 0) {
+        return 0;
+    }
+
+    if (wait_nr > 0 && timeout_ms > 0 && (ring->features & IORING_FEAT_EXT_ARG)) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000LL;
+        memset(&ext, 0, sizeof(ext));
+        ext.ts = (__u64)(unsigned long)&ts;
+        flags |= IORING_ENTER_EXT_ARG;
+        arg = &ext;
+        argsz = sizeof(ext);
+    }
+
+    ring->enter_calls++;
+    int ret = sys_io_uring_enter(ring->ring_fd, to_submit, wait_nr, flags,
+                                 arg, argsz);
+    return ret < 0 ? -errno : ret;
+}
+
+// Return the oldest unconsumed completion, or NULL if there is none
+struct io_uring_cqe *uring_peek_cqe(Uring *ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+// Mark the completion returned by uring_peek_cqe as consumed
+void uring_cqe_seen(Uring *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// Register an empty fixed file table so openat can install direct descriptors
+int uring_register_sparse_files(Uring *ring, unsigned nr) {
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = nr;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+
+    if (sys_io_uring_register(ring->ring_fd, IORING_REGISTER_FILES2,
+                              &reg, sizeof(reg)) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+// Allocate and register a provided buffer ring (entries must be a power of 2)
+int uring_buf_ring_setup(Uring *ring, UringBufRing *bufs, unsigned entries,
+                         unsigned buf_size, unsigned short bgid) {
+    size_t ring_size = entries * sizeof(struct io_uring_buf);
+    memset(bufs, 0, sizeof(*bufs));
+
+    bufs->br = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufs->br == MAP_FAILED) {
+        bufs->br = NULL;
+        return -errno;
+    }
+
+    bufs->data = malloc((size_t)entries * buf_size);
+    if (!bufs->data) {
+        munmap(bufs->br, ring_size);
+        bufs->br = NULL;
+        return -ENOMEM;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (__u64)(unsigned long)bufs->br;
+    reg.ring_entries = entries;
+    reg.bgid = bgid;
+
+    if (sys_io_uring_register(ring->ring_fd, IORING_REGISTER_PBUF_RING,
+                              &reg, 1) < 0) {
+        int err = -errno;
+        free(bufs->data);
+        munmap(bufs->br, ring_size);
+        bufs->br = NULL;
+        bufs->data = NULL;
+        return err;
+    }
+
+    bufs->entries = entries;
+    bufs->buf_size = buf_size;
+    bufs->bgid = bgid;
+
+    // Hand every buffer to the kernel
+    for (unsigned i = 0; i < entries; i++) {
+        struct io_uring_buf *buf = &bufs->br->bufs[i];
+        buf->addr = (__u64)(unsigned long)(bufs->data + (size_t)i * buf_size);
+        buf->len = buf_size;
+        buf->bid = (unsigned short)i;
+    }
+    __atomic_store_n(&bufs->br->tail, (unsigned short)entries, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+// Give a consumed buffer back to the kernel
+void uring_buf_ring_recycle(UringBufRing *bufs, unsigned short bid) {
+    unsigned short tail = bufs->br->tail;
+    struct io_uring_buf *buf = &bufs->br->bufs[tail & (bufs->entries - 1)];
+
+    buf->addr = (__u64)(unsigned long)(bufs->data + (size_t)bid * bufs->buf_size);
+    buf->len = bufs->buf_size;
+    buf->bid = bid;
+    __atomic_store_n(&bufs->br->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+// Unregister and free a provided buffer ring
+void uring_buf_ring_free(Uring *ring, UringBufRing *bufs) {
+    if (!bufs->br) {
+        return;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = bufs->bgid;
+    sys_io_uring_register(ring->ring_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+
+    munmap(bufs->br, bufs->entries * sizeof(struct io_uring_buf));
+    free(bufs->data);
+    bufs->br = NULL;
+    bufs->data = NULL;
+}
+
+void uring_prep_read(struct io_uring_sqe *sqe, int fd, void *buf,
+                     unsigned len, __u64 offset) {
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (__u64)(unsigned long)buf;
+    sqe->len = len;
+    sqe->off = offset;
+}
+
+// Multishot read: one SQE keeps posting a CQE per chunk of data, each
+// landing in a buffer picked from the provided buffer group.
+void uring_prep_read_multishot(struct io_uring_sqe *sqe, int fd,
+                               unsigned short bgid) {
+    sqe->opcode = URING_OP_READ_MULTISHOT;
+    sqe->fd = fd;
+    sqe->off = (__u64)-1;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bgid;
+}
+
+void uring_prep_write(struct io_uring_sqe *sqe, int fd, const void *buf,
+                      unsigned len, __u64 offset) {
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (__u64)(unsigned long)buf;
+    sqe->len = len;
+    sqe->off = offset;
+}
+
+// Open path into fixed file slot `slot` instead of the process fd table
+void uring_prep_openat_direct(struct io_uring_sqe *sqe, const char *path,
+                              int flags, unsigned slot) {
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (__u64)(unsigned long)path;
+    sqe->open_flags = (__u32)flags;
+    sqe->file_index = slot + 1;
+}
+
+void uring_prep_close_direct(struct io_uring_sqe *sqe, unsigned slot) {
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+}
\ No newline at end of file
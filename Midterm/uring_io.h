@@ -0,0 +1,88 @@
+/**
+ * uring_io.h - Minimal io_uring wrapper used by the Bank Server
+ *
+ * Talks to the kernel directly through io_uring_setup/io_uring_enter/
+ * io_uring_register, so no liburing is needed at build time.
+ */
+
+#ifndef URING_IO_H
+#define URING_IO_H
+
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+// IORING_OP_READ_MULTISHOT (Linux 6.7) is missing from older uapi headers
+#define URING_OP_READ_MULTISHOT 49
+
+// Submission/completion ring pair
+typedef struct {
+    int ring_fd;
+    unsigned features;
+
+    // Submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sqe_tail;          // SQEs handed out but not yet published
+    struct io_uring_sqe *sqes;
+
+    // Completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // Mappings
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    size_t sqes_size;
+
+    unsigned long enter_calls;  // io_uring_enter syscalls issued
+} Uring;
+
+// Provided buffer ring used by multishot reads
+typedef struct {
+    struct io_uring_buf_ring *br;
+    char *data;
+    unsigned entries;
+    unsigned buf_size;
+    unsigned short bgid;
+} UringBufRing;
+
+// Ring setup / teardown
+int uring_init(Uring *ring, unsigned entries);
+void uring_exit(Uring *ring);
+
+// Submission side
+struct io_uring_sqe *uring_get_sqe(Uring *ring);
+unsigned uring_sq_space(Uring *ring);
+int uring_submit(Uring *ring);
+int uring_submit_and_wait(Uring *ring, unsigned wait_nr, int timeout_ms);
+
+// Completion side
+struct io_uring_cqe *uring_peek_cqe(Uring *ring);
+void uring_cqe_seen(Uring *ring);
+
+// Registered resources
+int uring_register_sparse_files(Uring *ring, unsigned nr);
+int uring_buf_ring_setup(Uring *ring, UringBufRing *bufs, unsigned entries,
+                         unsigned buf_size, unsigned short bgid);
+void uring_buf_ring_recycle(UringBufRing *bufs, unsigned short bid);
+void uring_buf_ring_free(Uring *ring, UringBufRing *bufs);
+
+// Request preparation helpers
+void uring_prep_read(struct io_uring_sqe *sqe, int fd, void *buf,
+                     unsigned len, __u64 offset);
+void uring_prep_read_multishot(struct io_uring_sqe *sqe, int fd,
+                               unsigned short bgid);
+void uring_prep_write(struct io_uring_sqe *sqe, int fd, const void *buf,
+                      unsigned len, __u64 offset);
+void uring_prep_openat_direct(struct io_uring_sqe *sqe, const char *path,
+                              int flags, unsigned slot);
+void uring_prep_close_direct(struct io_uring_sqe *sqe, unsigned slot);
+
+#endif /* URING_IO_H */
\ No newline at end of file